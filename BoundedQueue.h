@@ -0,0 +1,84 @@
+/**
+    Project: libtpc
+    File name: BoundedQueue.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_BOUNDEDQUEUE_H
+#define LIBTPC_BOUNDEDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace tpc {
+
+    /*!
+     * thread safe FIFO queue with a max capacity, used to connect the stages of a pipeline. Producers block when the
+     * queue is full and consumers block when the queue is empty, until the queue is closed
+     */
+    template<typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity(capacity), closed(false) { }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        /*!
+         * add an element to the queue, waiting for a free slot if the queue is full
+         * @param item the element to add
+         * @return false if the queue has been closed, true otherwise
+         */
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+            if (closed) {
+                return false;
+            }
+            items.push_back(std::move(item));
+            not_empty.notify_one();
+            return true;
+        }
+
+        /*!
+         * remove the first element from the queue, waiting for an element if the queue is empty
+         * @param item the element removed from the queue
+         * @return false if the queue has been closed and there are no more elements, true otherwise
+         */
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this] { return closed || !items.empty(); });
+            if (items.empty()) {
+                return false;
+            }
+            item = std::move(items.front());
+            items.pop_front();
+            not_full.notify_one();
+            return true;
+        }
+
+        /*!
+         * close the queue. Blocked producers and consumers are woken up; the elements still in the queue can be
+         * popped, while new elements are rejected
+         */
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            not_empty.notify_all();
+            not_full.notify_all();
+        }
+
+    private:
+        size_t capacity;
+        bool closed;
+        std::deque<T> items;
+        std::mutex mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+    };
+}
+
+#endif //LIBTPC_BOUNDEDQUEUE_H
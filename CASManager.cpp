@@ -17,9 +17,18 @@
 #include <regex>
 #include <xercesc/util/XMLString.hpp>
 #include <xercesc/framework/LocalFileInputSource.hpp>
+#include <xercesc/framework/MemBufInputSource.hpp>
 #include <uima/xmideserializer.hpp>
 #include "uima/xmiwriter.hpp"
 #include "Utils.h"
+#include "CompactCasSerializer.h"
+#include "CorpusClassifier.h"
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/device/file_descriptor.hpp>
+#include <iomanip>
+#include <stdexcept>
 
 using namespace tpc::cas;
 using namespace std;
@@ -27,60 +36,53 @@ using namespace std;
 void CASManager::convert_raw_file_to_cas1(const string& file_path, FileType type, const string& out_dir,
                                           bool use_parent_dir_as_outname)
 {
-    // get rid of overwhelming messages from podofo library
-    PoDoFo::PdfError::EnableDebug(false);
-    PoDoFo::PdfError::EnableLogging(false);
-
-    string file_name_no_ext = boost::filesystem::path(file_path).filename().string();
-    string file_name_tpcas;
-    size_t extPos = file_name_no_ext.rfind('.');
-    if (extPos != std::string::npos) {
-        file_name_no_ext.erase(extPos);
-    }
-    file_name_tpcas = file_name_no_ext + ".tpcas";
-    string foutname;
-    string fimageoutname;
-    if (use_parent_dir_as_outname) {
-        foutname = out_dir + "/" + boost::filesystem::path(file_path).parent_path().filename().string();
-        fimageoutname = foutname + "/images/" + boost::filesystem::path(file_path).parent_path().filename().string();
-    } else {
-        foutname = out_dir + "/" + boost::filesystem::path(file_path).stem().string();
-        fimageoutname = foutname + "/images/" + boost::filesystem::path(file_path).stem().string();
-    }
-    boost::filesystem::create_directories(foutname + "/images");
-    foutname.append("/" + file_name_tpcas);
-    stringstream sout;
+    convert_raw_files_to_cas1({file_path}, type, out_dir, use_parent_dir_as_outname);
+}
 
-    switch (type) {
-        case FileType::pdf:
-            try {
-                PdfInfo myInfo(file_path, fimageoutname);
-                myInfo.StreamAll(sout);
-                const char *descriptor = PDF2TPCAS_DESCRIPTOR.c_str();
-                Stream2Tpcas stp(sout, foutname, descriptor);
-                stp.processInputStream();
-            } catch (PoDoFo::PdfError &e) {
-                cerr << "Error: An error occurred during processing the pdf file." << endl << e.GetError() << endl
-                     << file_path << endl;
-                e.PrintErrorMsg();
-            }
-            break;
-        case FileType::xml:
-            ReadXml2Stream rs(file_path.c_str());
-            std::stringstream sout;
-            rs.GetStream(sout);
-            const char *descriptor = XML2TPCAS_DESCRIPTOR.c_str();
-            Stream2Tpcas stp(sout, foutname, descriptor);
-            stp.processInputStream();
-            break;
+void CASManager::convert_raw_files_to_cas1(const vector<string>& file_paths, FileType type, const string& out_dir,
+                                           bool use_parent_dir_as_outname)
+{
+    const char *descriptor = type == FileType::pdf ? PDF2TPCAS_DESCRIPTOR.c_str() : XML2TPCAS_DESCRIPTOR.c_str();
+    // the engine and its cas are created once and the cas is reset between files
+    Stream2Tpcas stp(descriptor);
+    for (const string& file_path : file_paths) {
+        string file_name_no_ext = boost::filesystem::path(file_path).filename().string();
+        string file_name_tpcas;
+        size_t extPos = file_name_no_ext.rfind('.');
+        if (extPos != std::string::npos) {
+            file_name_no_ext.erase(extPos);
+        }
+        file_name_tpcas = file_name_no_ext + ".tpcas";
+        string foutname;
+        string fimageoutname;
+        if (use_parent_dir_as_outname) {
+            foutname = out_dir + "/" + boost::filesystem::path(file_path).parent_path().filename().string();
+            fimageoutname = foutname + "/images/" +
+                            boost::filesystem::path(file_path).parent_path().filename().string();
+        } else {
+            foutname = out_dir + "/" + boost::filesystem::path(file_path).stem().string();
+            fimageoutname = foutname + "/images/" + boost::filesystem::path(file_path).stem().string();
+        }
+        boost::filesystem::create_directories(foutname + "/images");
+        foutname.append("/" + file_name_tpcas);
+        // articles without text are converted to a cas with an empty text, as they were before batching
+        string stream;
+        if (get_raw_file_stream(file_path, type, fimageoutname, stream)) {
+            stp.processString(stream, foutname);
+        }
     }
 }
 
-int CASManager::convert_cas1_to_cas2(const string &file_path, const std::string &out_dir)
+/*!
+ * process cas1 files with a single cas2 engine
+ * @param file_paths the paths to the cas1 files
+ * @param engine_completed set to whether the engine has been created and destroyed without errors
+ * @return the number of files with text that have been processed
+ */
+static int process_cas1_files(const vector<string>& file_paths, bool& engine_completed)
 {
-    string foutname = out_dir + "/" + boost::filesystem::path(file_path).parent_path().filename().string();
-    string temp_dir_path = boost::filesystem::temp_directory_path().string();
-    string tpcasfile = Utils::decompress_gzip(file_path, temp_dir_path);
+    int num_converted_files = 0;
+    engine_completed = false;
     try {
         /* Create/link up to a UIMACPP resource manager instance (singleton) */
         (void) uima::ResourceManager::createInstance("TPCAS2LINDEXAE");
@@ -98,32 +100,32 @@ int CASManager::convert_cas1_to_cas2(const string &file_path, const std::string
             exit((int) errorInfo.getErrorId());
         }
         uima::TyErrorId utErrorId; // Variable to store UIMACPP return codes
-        /* Get a new CAS */
+        /* Get a new CAS, reused for all the files */
         uima::CAS* cas = pEngine->newCAS();
         if (cas == nullptr) {
             std::cerr << "pEngine->newCAS() failed." << std::endl;
             exit(1);
         }
-        /* process input / cas */
-        try {
-            /* initialize from an xmicas */
-            XMLCh* native = XMLString::transcode(tpcasfile.c_str());
-            LocalFileInputSource fileIS(native);
-            XMLString::release(&native);
-            uima::XmiDeserializer::deserialize(fileIS, *cas, true);
-            std::string filename(tpcasfile);
-            string filehash = Utils::gettpfnvHash(*cas);
-            /* process the CAS */
-            auto text = Utils::getFulltext(*cas);
-            if (text.length() > 0) {
-                ((uima::AnalysisEngine *) pEngine)->process(*cas);
-            } else {
-                cout << "Skip file." << endl;
+        for (const string& file_path : file_paths) {
+            /* process input / cas */
+            try {
+                /* initialize from a cas file decompressed in memory, in xmi or compact format */
+                CASManager::read_compressed_cas(file_path, *cas);
+                /* process the CAS */
+                auto text = Utils::getFulltext(*cas);
+                if (text.length() > 0) {
+                    ((uima::AnalysisEngine *) pEngine)->process(*cas);
+                    ++num_converted_files;
+                } else {
+                    cout << "Skip file." << endl;
+                }
+            } catch (uima::Exception e) {
+                uima::ErrorInfo errInfo = e.getErrorInfo();
+                std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
+                std::cerr << errInfo << std::endl;
             }
-        } catch (uima::Exception e) {
-            uima::ErrorInfo errInfo = e.getErrorInfo();
-            std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
-            std::cerr << errInfo << std::endl;
+            /* clear the CAS for the next file */
+            cas->reset();
         }
         /* call collectionProcessComplete */
         utErrorId = pEngine->collectionProcessComplete();
@@ -131,12 +133,188 @@ int CASManager::convert_cas1_to_cas2(const string &file_path, const std::string
         utErrorId = pEngine->destroy();
         delete cas;
         delete pEngine;
-        std::remove(tpcasfile.c_str()); //delete uncompressed temp casfile
-        return 1;
+        engine_completed = true;
+    } catch (uima::Exception e) {
+        std::cerr << "Exception: " << e << std::endl;
+    }
+    return num_converted_files;
+}
+
+int CASManager::convert_cas1_to_cas2(const string &file_path, const std::string &out_dir)
+{
+    // files without text and files with processing errors are skipped but still count as converted, as they always
+    // have for this function
+    bool engine_completed;
+    process_cas1_files({file_path}, engine_completed);
+    return engine_completed ? 1 : 0;
+}
+
+int CASManager::convert_cas1_files_to_cas2(const vector<string>& file_paths, const std::string &out_dir)
+{
+    bool engine_completed;
+    return process_cas1_files(file_paths, engine_completed);
+}
+
+bool CASManager::get_raw_file_stream(const string& file_path, FileType type, const string& image_out_root,
+                                     string& stream)
+{
+    stringstream sout;
+    switch (type) {
+        case FileType::pdf:
+            // get rid of overwhelming messages from podofo library
+            PoDoFo::PdfError::EnableDebug(false);
+            PoDoFo::PdfError::EnableLogging(false);
+            try {
+                PdfInfo myInfo(file_path, image_out_root);
+                myInfo.StreamAll(sout);
+            } catch (PoDoFo::PdfError &e) {
+                cerr << "Error: An error occurred during processing the pdf file." << endl << e.GetError() << endl
+                     << file_path << endl;
+                e.PrintErrorMsg();
+                stream.clear();
+                return false;
+            }
+            break;
+        case FileType::xml:
+            ReadXml2Stream rs(file_path.c_str());
+            rs.GetStream(sout);
+            break;
+    }
+    stream = sout.str();
+    return true;
+}
+
+void CASManager::set_cas_text_from_stream(uima::CAS& cas, const string& stream, const string& filename)
+{
+    UnicodeString ustrInputText = Stream2Tpcas::getInputText(filename, stream);
+    cas.setDocumentText(ustrInputText.getBuffer(), ustrInputText.length(), true);
+}
+
+string CASManager::get_tpfnv_hash_from_stream(const string& stream, const string& filename)
+{
+    // same text and hash as the tokenizers, which skip the header up to the position written at its beginning
+    UnicodeString ustrInputText = Stream2Tpcas::getInputText(filename, stream);
+    int32_t firsthash = ustrInputText.indexOf('#');
+    int32_t textstart = 0;
+    for (int32_t i = 0; i < firsthash; ++i) {
+        textstart = textstart * 10 + (ustrInputText[i] - '0');
+    }
+    uint64_t hash = 14695981039346656037ULL;
+    for (int32_t i = textstart; i < ustrInputText.length(); ++i) {
+        hash ^= ustrInputText[i];
+        hash *= 1099511628211ULL;
+    }
+    stringstream shex;
+    shex << std::setw(16) << std::setfill('0') << std::hex << hash;
+    return shex.str();
+}
+
+string CASManager::get_bib_file_content(const BibInfo& bib_info)
+{
+    // one field per line, in the order read by the indexer
+    vector<pair<string, string>> fields{{"author", bib_info.author}, {"accession", bib_info.accession},
+                                        {"type", bib_info.type}, {"title", bib_info.title},
+                                        {"journal", bib_info.journal}, {"citation", bib_info.citation},
+                                        {"year", bib_info.year}, {"abstract", bib_info.abstract}};
+    string content;
+    for (const auto& field : fields) {
+        string value = field.second;
+        boost::replace_all(value, "\n", " ");
+        boost::replace_all(value, "|", " ");
+        content += field.first + "|" + value + "\n";
+    }
+    return content;
+}
+
+void CASManager::write_compressed_cas(uima::CAS& cas, const string& file_path, CasFormat format)
+{
+    bool write_failed = false;
+    try {
+        // unlike an ofstream, the file descriptor sink reports write errors, which would otherwise make the
+        // compressor retry forever
+        boost::iostreams::filtering_ostream out;
+        out.push(boost::iostreams::gzip_compressor());
+        out.push(boost::iostreams::file_descriptor_sink(file_path, std::ios::out | std::ios::binary));
+        if (format == CasFormat::compact) {
+            CompactCasSerializer::serialize(cas, out);
+        } else {
+            uima::XmiWriter writer(cas, true);
+            writer.write(out);
+        }
+        out.flush();
+        write_failed = out.fail();
+        // closing the chain writes the gzip trailer and closes the file
+        out.reset();
+    } catch (std::ios_base::failure& e) {
+        write_failed = true;
+    } catch (...) {
+        boost::filesystem::remove(file_path);
+        throw;
+    }
+    if (write_failed) {
+        boost::filesystem::remove(file_path);
+        throw std::runtime_error("cannot write output cas " + file_path);
+    }
+}
+
+void CASManager::deserialize_cas(const string& content, uima::CAS& cas, const string& source_name)
+{
+    if (CompactCasSerializer::is_compact_cas(content)) {
+        CompactCasSerializer::deserialize(content, cas);
+    } else {
+        MemBufInputSource memIS(reinterpret_cast<const XMLByte*>(content.c_str()), content.size(),
+                                source_name.c_str(), false);
+        uima::XmiDeserializer::deserialize(memIS, cas, true);
+    }
+}
+
+void CASManager::read_compressed_cas(const string& file_path, uima::CAS& cas)
+{
+    deserialize_cas(Utils::decompress_gzip_to_string(file_path), cas, file_path);
+}
+
+int CASManager::convert_cas_files_format(const vector<string>& file_paths, CasFormat format)
+{
+    int num_converted_files = 0;
+    try {
+        // a cas with the textpresso type system is enough to hold the annotations of any cas file
+        uima::ErrorInfo errorInfo;
+        uima::TypeSystem* typeSystem = uima::Framework::createTypeSystem(TPCAS_TYPE_SYSTEM_DESCRIPTOR.c_str(),
+                                                                         errorInfo);
+        if (errorInfo.getErrorId() != UIMA_ERR_NONE) {
+            std::cerr << "  UIMACPP Error info:" << std::endl << errorInfo << std::endl;
+            return 0;
+        }
+        uima::CAS* cas = uima::Framework::createCAS(*typeSystem, errorInfo);
+        if (errorInfo.getErrorId() != UIMA_ERR_NONE) {
+            std::cerr << "  UIMACPP Error info:" << std::endl << errorInfo << std::endl;
+            delete typeSystem;
+            return 0;
+        }
+        for (const string& file_path : file_paths) {
+            try {
+                read_compressed_cas(file_path, *cas);
+                // the new file replaces the old one only once it has been completely written, a failed write
+                // removes the temporary file and leaves the old one in place
+                string tmp_file_path = file_path + ".tmp";
+                write_compressed_cas(*cas, tmp_file_path, format);
+                boost::filesystem::rename(tmp_file_path, file_path);
+                ++num_converted_files;
+            } catch (uima::Exception e) {
+                uima::ErrorInfo errInfo = e.getErrorInfo();
+                std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
+                std::cerr << errInfo << std::endl;
+            } catch (std::exception& e) {
+                std::cerr << "Error converting file " << file_path << ": " << e.what() << std::endl;
+            }
+            cas->reset();
+        }
+        delete cas;
+        delete typeSystem;
     } catch (uima::Exception e) {
         std::cerr << "Exception: " << e << std::endl;
-        return 0;
     }
+    return num_converted_files;
 }
 
 void CASManager::writeXmi(uima::CAS & outCas, int num, std::string outfn) {
@@ -267,16 +445,7 @@ BibInfo CASManager::get_bib_info_from_xml_text(const std::string &xml_text) {
 }
 
 std::vector<std::string> CASManager::classify_article_into_corpora_from_bib_file(const BibInfo &bib_info) {
-    vector<string> matching_categories;
-    for (const auto& cat : PMCOA_CAT_REGEX) {
-        regex cat_regex(cat.second);
-        if (regex_match(bib_info.subject, cat_regex) || regex_match(bib_info.title, cat_regex) ||
-                regex_match(bib_info.journal, cat_regex)) {
-            matching_categories.push_back(cat.first);
-        }
-    }
-    if (matching_categories.empty()) {
-        matching_categories.push_back(PMCOA_UNCLASSIFIED);
-    }
-    return matching_categories;
+    // the corpus patterns are compiled only once, the first time an article is classified
+    static const CorpusClassifier classifier(PMCOA_CAT_REGEX);
+    return classifier.classify(bib_info);
 }
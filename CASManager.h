@@ -20,6 +20,8 @@ namespace tpc {
         static const std::string PDF2TPCAS_DESCRIPTOR("/usr/local/uima_descriptors/TpTokenizer.xml");
         static const std::string XML2TPCAS_DESCRIPTOR("/usr/local/uima_descriptors/TxTokenizer.xml");
         static const std::string TPCAS1_2_TPCAS2_DESCRIPTOR("/usr/local/uima-descriptors/TpLexiconAnnotatorFromPg.xml");
+        static const std::string TPCAS_TYPE_SYSTEM_DESCRIPTOR(
+                "/usr/local/uima_descriptors/TpLexiconAnnotatorFromPgTypeSystem.xml");
 
         static const std::vector<std::pair<std::string, std::string>> PMCOA_CAT_REGEX{
                 {"PMCOA Biology", ".*[Bb]io.*"}, {"PMCOA Neuroscience", ".*[Nn]euro.*"}, {"PMCOA Oncology", ".*([Cc]anc|[Oo]nc).*"},
@@ -43,6 +45,13 @@ namespace tpc {
             pdf = 1, xml = 2
         };
 
+        /*!
+         * serialization formats of cas files. Compact files are written by tpc::cas::CompactCasSerializer
+         */
+        enum class CasFormat {
+            xmi = 1, compact = 2
+        };
+
         /*!
          * @struct BibInfo
          * @brief data structure that represents bib information of a cas file
@@ -80,14 +89,36 @@ namespace tpc {
             static void convert_raw_file_to_cas1(const std::string &file_path, FileType type,
                                                  const std::string &out_dir, bool use_parent_dir_as_outname = false);
 
+            /*!
+             * convert a list of pdf or xml articles to cas1 format and save them to the specified location. A single
+             * engine and a single cas, reset between articles, are used for the whole list. Articles without
+             * text are saved as a cas with an empty text, pdf files that cannot be read are skipped
+             * @param file_paths the paths to the raw files
+             * @param type the type of the files
+             * @param out_dir the location where to save the new cas files
+             */
+            static void convert_raw_files_to_cas1(const std::vector<std::string> &file_paths, FileType type,
+                                                  const std::string &out_dir, bool use_parent_dir_as_outname = false);
+
             /*!
              * convert a cas1 file to cas2 format and save it to the specified location
              * @param file_path the path to the cas1 file
              * @param out_dir the location where to save the new cas file
-             * @return 1 if the conversion succeded, 0 otherwise
+             * @return 1 if the conversion engine could be run, 0 otherwise. A file without text is skipped and still
+             * returns 1, unlike convert_cas1_files_to_cas2, which counts only the files with text
              */
             static int convert_cas1_to_cas2(const std::string& file_path, const std::string& out_dir);
 
+            /*!
+             * convert a list of cas1 files to cas2 format and save them to the specified location. A single engine and
+             * a single cas, reset between files, are used for the whole list
+             * @param file_paths the paths to the cas1 files
+             * @param out_dir the location where to save the new cas files
+             * @return the number of files with text converted
+             */
+            static int convert_cas1_files_to_cas2(const std::vector<std::string>& file_paths,
+                                                  const std::string& out_dir);
+
             /*!
              * extract bib information from the xml fulltext of an article
              * @param xml_text a string containing the xml fulltext of an article
@@ -97,11 +128,83 @@ namespace tpc {
 
             /*!
              * get the list of corpora to which the article belongs through classification performed on bibliographic
-             * information
+             * information. The classification is performed by a tpc::cas::CorpusClassifier created on the first call
              * @param bib_info object containing the bibliographic information of the article
              */
             static std::vector<std::string> classify_article_into_corpora_from_bib_file(const BibInfo& bib_info);
 
+            /*!
+             * extract the text stream of a pdf or xml article, in the format read by the tokenizers
+             * @param file_path the path to the raw file
+             * @param type the type of file
+             * @param image_out_root the root of the names of the image files extracted from pdf articles
+             * @param stream the text stream of the article, empty if the article has no text or cannot be read
+             * @return false if the article cannot be read, true otherwise
+             */
+            static bool get_raw_file_stream(const std::string& file_path, FileType type,
+                                            const std::string& image_out_root, std::string& stream);
+
+            /*!
+             * set the document text of a cas to the text stream of an article, preceded by the header with the file
+             * name that is read by the tokenizers. The text is copied to the cas
+             * @param cas the cas to fill
+             * @param stream the text stream of the article
+             * @param filename the file name to be stored in the cas, in the form literature/paper/filename.tpcas
+             */
+            static void set_cas_text_from_stream(uima::CAS& cas, const std::string& stream,
+                                                 const std::string& filename);
+
+            /*!
+             * compute the content hash that the tokenizers store in the tpfnvhash annotation of the cas of a text
+             * stream, without running them
+             * @param stream the text stream of the article
+             * @param filename the file name to be stored in the cas, in the form literature/paper/filename.tpcas
+             * @return the hash as a hexadecimal string
+             */
+            static std::string get_tpfnv_hash_from_stream(const std::string& stream, const std::string& filename);
+
+            /*!
+             * get the content of a bib file, in the format read by the indexer, from bib information
+             * @param bib_info the bib information of the article
+             * @return the content of the bib file
+             */
+            static std::string get_bib_file_content(const BibInfo& bib_info);
+
+            /*!
+             * serialize a cas to a gzip compressed file
+             * @param cas the cas to serialize
+             * @param file_path the path of the compressed file to write
+             * @param format the serialization format
+             * @throw std::runtime_error if the file cannot be completely written, in which case it is removed
+             */
+            static void write_compressed_cas(uima::CAS& cas, const std::string& file_path,
+                                             CasFormat format = CasFormat::xmi);
+
+            /*!
+             * fill a cas from its serialization. The format, xmi or compact, is detected from the content
+             * @param content the serialized cas
+             * @param cas the cas to fill, which must be empty
+             * @param source_name the name of the source of the content, used in error messages
+             */
+            static void deserialize_cas(const std::string& content, uima::CAS& cas,
+                                        const std::string& source_name = "");
+
+            /*!
+             * read a gzip compressed cas file in xmi or compact format
+             * @param file_path the path of the compressed cas file
+             * @param cas the cas to fill, which must be empty
+             */
+            static void read_compressed_cas(const std::string& file_path, uima::CAS& cas);
+
+            /*!
+             * convert a list of gzip compressed cas files to a serialization format. Files are replaced in place and
+             * keep their names, since the format of a file is detected from its content
+             * @param file_paths the paths of the compressed cas files
+             * @param format the new serialization format
+             * @return the number of files converted
+             */
+            static int convert_cas_files_format(const std::vector<std::string>& file_paths, CasFormat format);
+
         private:
 
             static void writeXmi(uima::CAS &outCas, int num, std::string outfn);
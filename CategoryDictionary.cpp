@@ -0,0 +1,74 @@
+/**
+    Project: libtpc
+    File name: CategoryDictionary.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "CategoryDictionary.h"
+#include <fstream>
+#include <codecvt>
+#include <locale>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+using namespace tpc::index;
+
+int32_t CategoryDictionary::get_or_add_id(const wstring& name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    auto id = static_cast<int32_t>(names.size());
+    names.push_back(name);
+    ids.emplace(name, id);
+    return id;
+}
+
+int32_t CategoryDictionary::get_id(const wstring& name) const {
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : -1;
+}
+
+void CategoryDictionary::load(const string& file_path) {
+    ifstream ifs(file_path);
+    wstring_convert<codecvt_utf8<wchar_t>> converter;
+    string line;
+    while (getline(ifs, line)) {
+        get_or_add_id(converter.from_bytes(line));
+    }
+}
+
+void CategoryDictionary::add_lexicon_categories(const string& lexicon_file_path) {
+    ifstream ifs(lexicon_file_path);
+    if (!ifs) {
+        throw runtime_error("cannot read lexicon " + lexicon_file_path);
+    }
+    wstring_convert<codecvt_utf8<wchar_t>> converter;
+    string line;
+    while (getline(ifs, line)) {
+        size_t tab_pos = line.find('\t');
+        if (tab_pos != string::npos && tab_pos + 1 < line.size()) {
+            get_or_add_id(converter.from_bytes(line.substr(tab_pos + 1)));
+        }
+    }
+}
+
+void CategoryDictionary::save(const string& file_path) const {
+    string tmp_file_path = file_path + ".tmp";
+    {
+        ofstream ofs(tmp_file_path);
+        if (!ofs) {
+            throw runtime_error("cannot write category dictionary " + file_path);
+        }
+        wstring_convert<codecvt_utf8<wchar_t>> converter;
+        for (const wstring& name : names) {
+            ofs << converter.to_bytes(name) << "\n";
+        }
+    }
+    if (rename(tmp_file_path.c_str(), file_path.c_str()) != 0) {
+        throw runtime_error("cannot write category dictionary " + file_path);
+    }
+}
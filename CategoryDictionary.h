@@ -0,0 +1,90 @@
+/**
+    Project: libtpc
+    File name: CategoryDictionary.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_CATEGORYDICTIONARY_H
+#define LIBTPC_CATEGORYDICTIONARY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace tpc {
+
+    namespace index {
+
+        static const std::string CATEGORY_DICTIONARY_FILENAME("categories.txt");
+
+        /*!
+         * @brief dictionary of category names, mapping each name to a dense integer id
+         *
+         * Ids are assigned in order of insertion starting from 0 and never change once assigned, so that categories can
+         * be handled as integers during annotation and indexing and converted back to names only when the index
+         * fields are written. The dictionary is persisted as a utf-8 text file with one name per line, where the line
+         * number is the id of the category. A single dictionary is built from the lexicon when an index is created
+         * and stored at the root of the index, annotators and indexers only read it
+         */
+        class CategoryDictionary {
+        public:
+            /*!
+             * get the id of a category, adding the category to the dictionary if not present
+             * @param name the name of the category
+             * @return the id of the category
+             */
+            int32_t get_or_add_id(const std::wstring& name);
+
+            /*!
+             * get the id of a category
+             * @param name the name of the category
+             * @return the id of the category, or -1 if the category is not in the dictionary
+             */
+            int32_t get_id(const std::wstring& name) const;
+
+            /*!
+             * get the name of a category
+             * @param id the id of the category, which must be smaller than the size of the dictionary
+             * @return the name of the category
+             */
+            const std::wstring& get_name(int32_t id) const { return names[id]; }
+
+            /*!
+             * get the number of categories in the dictionary
+             * @return the number of categories
+             */
+            size_t size() const { return names.size(); }
+
+            /*!
+             * add the categories stored in a dictionary file that are not already present. Nothing is added if the
+             * file does not exist
+             * @param file_path the path of the dictionary file
+             */
+            void load(const std::string& file_path);
+
+            /*!
+             * add the categories of a lexicon file that are not already present, in order of first occurrence. Each
+             * line of the file contains a term and its category separated by a tab, lines without a category are
+             * ignored
+             * @param lexicon_file_path the path of the lexicon file
+             * @throw std::runtime_error if the lexicon file cannot be read
+             */
+            void add_lexicon_categories(const std::string& lexicon_file_path);
+
+            /*!
+             * write the dictionary to file. The file is replaced only once it has been completely written
+             * @param file_path the path of the dictionary file
+             */
+            void save(const std::string& file_path) const;
+
+        private:
+            std::vector<std::wstring> names;
+            std::unordered_map<std::wstring, int32_t> ids;
+        };
+    }
+}
+
+#endif //LIBTPC_CATEGORYDICTIONARY_H
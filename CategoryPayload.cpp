@@ -0,0 +1,255 @@
+/**
+    Project: libtpc
+    File name: CategoryPayload.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "CategoryPayload.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace tpc::index;
+
+namespace {
+
+    void write_varint(string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    uint64_t read_varint(const char*& pos, const char* end) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) {
+                throw runtime_error("corrupted category payload: unexpected end of data");
+            }
+            auto byte = static_cast<uint8_t>(*pos++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw runtime_error("corrupted category payload: varint too long");
+    }
+
+    // names are converted character by character, without the locale machinery of wstring_convert
+    void append_utf8(string& out, const wstring& name) {
+        for (wchar_t wc : name) {
+            auto c = static_cast<uint32_t>(wc);
+            if (c < 0x80) {
+                out.push_back(static_cast<char>(c));
+            } else if (c < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            } else if (c < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | ((c >> 18) & 0x07)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+            }
+        }
+    }
+
+    wstring read_utf8(const char* pos, const char* end) {
+        wstring name;
+        while (pos < end) {
+            auto byte = static_cast<uint8_t>(*pos++);
+            int num_continuation_bytes;
+            uint32_t c;
+            if (byte < 0x80) {
+                num_continuation_bytes = 0;
+                c = byte;
+            } else if ((byte & 0xE0) == 0xC0) {
+                num_continuation_bytes = 1;
+                c = byte & 0x1F;
+            } else if ((byte & 0xF0) == 0xE0) {
+                num_continuation_bytes = 2;
+                c = byte & 0x0F;
+            } else if ((byte & 0xF8) == 0xF0) {
+                num_continuation_bytes = 3;
+                c = byte & 0x07;
+            } else {
+                throw runtime_error("corrupted category payload: invalid utf-8 name");
+            }
+            if (end - pos < num_continuation_bytes) {
+                throw runtime_error("corrupted category payload: invalid utf-8 name");
+            }
+            for (int i = 0; i < num_continuation_bytes; ++i) {
+                auto continuation_byte = static_cast<uint8_t>(*pos++);
+                if ((continuation_byte & 0xC0) != 0x80) {
+                    throw runtime_error("corrupted category payload: invalid utf-8 name");
+                }
+                c = (c << 6) | (continuation_byte & 0x3F);
+            }
+            name.push_back(static_cast<wchar_t>(c));
+        }
+        return name;
+    }
+}
+
+void CategoryPayload::clear() {
+    num_words = 0;
+    extra_names.clear();
+    extra_ids.clear();
+    word_indices.clear();
+    word_categories.clear();
+}
+
+void CategoryPayload::add_word_categories(uint32_t word_index, const vector<int32_t>& category_ids,
+                                          const CategoryDictionary& extra_categories) {
+    vector<uint32_t> references;
+    references.reserve(category_ids.size());
+    for (int32_t category_id : category_ids) {
+        if (category_id >= 0) {
+            references.push_back(static_cast<uint32_t>(category_id) << 1);
+            continue;
+        }
+        // sentences have few categories that are not in the dictionary, a linear scan of the table is enough
+        auto it = find(extra_ids.begin(), extra_ids.end(), category_id);
+        if (it == extra_ids.end()) {
+            extra_ids.push_back(category_id);
+            extra_names.push_back(extra_categories.get_name(-1 - category_id));
+            it = extra_ids.end() - 1;
+        }
+        references.push_back((static_cast<uint32_t>(it - extra_ids.begin()) << 1) | 1);
+    }
+    word_indices.push_back(word_index);
+    word_categories.push_back(std::move(references));
+}
+
+string CategoryPayload::encode() const {
+    string out;
+    out.push_back(static_cast<char>(CATEGORY_PAYLOAD_VERSION));
+    write_varint(out, num_words);
+    write_varint(out, extra_names.size());
+    string utf8_name;
+    for (const wstring& name : extra_names) {
+        utf8_name.clear();
+        append_utf8(utf8_name, name);
+        write_varint(out, utf8_name.size());
+        out.append(utf8_name);
+    }
+    write_varint(out, word_indices.size());
+    uint32_t next_word_index = 0;
+    for (size_t i = 0; i < word_indices.size(); ++i) {
+        write_varint(out, word_indices[i] - next_word_index);
+        next_word_index = word_indices[i] + 1;
+        write_varint(out, word_categories[i].size());
+        for (uint32_t reference : word_categories[i]) {
+            write_varint(out, reference);
+        }
+    }
+    return out;
+}
+
+void CategoryPayload::decode(const char* data, size_t size) {
+    clear();
+    const char* pos = data;
+    const char* end = data + size;
+    if (pos == end || static_cast<uint8_t>(*pos++) != CATEGORY_PAYLOAD_VERSION) {
+        throw runtime_error("corrupted category payload: unsupported version");
+    }
+    num_words = static_cast<uint32_t>(read_varint(pos, end));
+    uint64_t num_names = read_varint(pos, end);
+    for (uint64_t i = 0; i < num_names; ++i) {
+        uint64_t name_size = read_varint(pos, end);
+        if (name_size > static_cast<uint64_t>(end - pos)) {
+            throw runtime_error("corrupted category payload: unexpected end of data");
+        }
+        extra_names.push_back(read_utf8(pos, pos + name_size));
+        pos += name_size;
+    }
+    uint64_t num_categorized_words = read_varint(pos, end);
+    uint64_t next_word_index = 0;
+    for (uint64_t i = 0; i < num_categorized_words; ++i) {
+        uint64_t word_index = next_word_index + read_varint(pos, end);
+        if (word_index >= num_words) {
+            throw runtime_error("corrupted category payload: word index out of range");
+        }
+        uint64_t num_categories = read_varint(pos, end);
+        if (num_categories > static_cast<uint64_t>(end - pos)) {
+            throw runtime_error("corrupted category payload: unexpected end of data");
+        }
+        vector<uint32_t> references;
+        references.reserve(num_categories);
+        for (uint64_t j = 0; j < num_categories; ++j) {
+            uint64_t reference = read_varint(pos, end);
+            if (reference > UINT32_MAX || ((reference & 1) && (reference >> 1) >= extra_names.size())) {
+                throw runtime_error("corrupted category payload: category index out of range");
+            }
+            references.push_back(static_cast<uint32_t>(reference));
+        }
+        word_indices.push_back(static_cast<uint32_t>(word_index));
+        word_categories.push_back(std::move(references));
+        next_word_index = word_index + 1;
+    }
+    if (pos != end) {
+        throw runtime_error("corrupted category payload: unexpected data after the end of the payload");
+    }
+}
+
+const wstring& CategoryPayload::get_category_name(uint32_t reference, const CategoryDictionary& dictionary) const {
+    if (reference & 1) {
+        return extra_names[reference >> 1];
+    }
+    if ((reference >> 1) >= dictionary.size()) {
+        throw runtime_error("category payload refers to a category that is not in the dictionary");
+    }
+    return dictionary.get_name(static_cast<int32_t>(reference >> 1));
+}
+
+string CategoryPayload::get_categories_string(const CategoryDictionary& dictionary) const {
+    string result;
+    size_t categorized_word = 0;
+    for (uint32_t word_index = 0; word_index < num_words; ++word_index) {
+        if (word_index > 0) {
+            result.push_back('\t');
+        }
+        if (categorized_word < word_indices.size() && word_indices[categorized_word] == word_index) {
+            const vector<uint32_t>& references = word_categories[categorized_word++];
+            for (size_t i = 0; i < references.size(); ++i) {
+                if (i > 0) {
+                    result.push_back('|');
+                }
+                append_utf8(result, get_category_name(references[i], dictionary));
+            }
+        } else {
+            result.append("NA");
+        }
+    }
+    return result;
+}
+
+wstring CategoryPayload::get_indexed_text(const CategoryDictionary& dictionary) const {
+    wstring result;
+    size_t categorized_word = 0;
+    for (uint32_t word_index = 0; word_index < num_words; ++word_index) {
+        if (word_index > 0) {
+            result.push_back(L'\t');
+        }
+        if (categorized_word < word_indices.size() && word_indices[categorized_word] == word_index) {
+            const vector<uint32_t>& references = word_categories[categorized_word++];
+            for (size_t i = 0; i < references.size(); ++i) {
+                if (i > 0) {
+                    result.push_back(L'|');
+                }
+                result.append(get_category_name(references[i], dictionary));
+            }
+        } else {
+            // the gaps keep the positions of the words without categories as in the NA scheme, so that phrase
+            // queries match only adjacent categories and positions are the word indices of the sentence
+            result.append(CATEGORY_GAP_TOKEN);
+        }
+    }
+    return result;
+}
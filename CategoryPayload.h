@@ -0,0 +1,110 @@
+/**
+    Project: libtpc
+    File name: CategoryPayload.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_CATEGORYPAYLOAD_H
+#define LIBTPC_CATEGORYPAYLOAD_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "CategoryDictionary.h"
+
+namespace tpc {
+
+    namespace index {
+
+        static const uint8_t CATEGORY_PAYLOAD_VERSION = 2;
+        // placeholder for the words without categories in the indexed categories of a sentence, removed by
+        // CategoryAnalyzer while keeping its position
+        static const std::wstring CATEGORY_GAP_TOKEN(L"catgap");
+
+        /*!
+         * @brief compact binary encoding of the categories of the words of a sentence
+         *
+         * The payload contains the format version, the number of words of the sentence, a table with the names of the
+         * categories of the sentence that are not in the category dictionary of the index and, for each word with
+         * categories, the distance from the previous word with categories and the references to its categories. A
+         * reference is the id of the category in the dictionary of the index shifted left by one bit or, for the
+         * categories in the table, the table index shifted left by one bit with the lowest bit set. All integers are
+         * varint encoded and names are written in utf-8. Words without categories are not stored
+         */
+        class CategoryPayload {
+        public:
+            /*!
+             * remove all the words and categories from the payload
+             */
+            void clear();
+
+            /*!
+             * set the number of words of the sentence
+             * @param num_words the number of words
+             */
+            void set_num_words(uint32_t num_words) { this->num_words = num_words; }
+
+            /*!
+             * add the categories of a word. Words must be added in increasing order of position
+             * @param word_index the position of the word in the sentence
+             * @param category_ids the ids of the categories of the word in the category dictionary of the index, or
+             * -1 - id for the categories in the extra categories
+             * @param extra_categories the categories that are not in the dictionary of the index
+             */
+            void add_word_categories(uint32_t word_index, const std::vector<int32_t>& category_ids,
+                                     const CategoryDictionary& extra_categories);
+
+            /*!
+             * encode the payload
+             * @return the binary payload
+             */
+            std::string encode() const;
+
+            /*!
+             * decode a binary payload
+             * @param data pointer to the binary payload
+             * @param size the size of the payload
+             * @throw std::runtime_error if the payload is corrupted
+             */
+            void decode(const char* data, size_t size);
+
+            /*!
+             * get the categories of the words as a tab separated utf-8 string, with the categories of each word
+             * separated by "|" and NA for words without categories
+             * @param dictionary the category dictionary of the index
+             * @return the categories string
+             * @throw std::runtime_error if a category is not in the dictionary
+             */
+            std::string get_categories_string(const CategoryDictionary& dictionary) const;
+
+            /*!
+             * get the text to be indexed for category queries, with the categories of the words separated by tabs and
+             * a CATEGORY_GAP_TOKEN for each word without categories, so that the position of each word is its index
+             * in the sentence
+             * @param dictionary the category dictionary of the index
+             * @return the text to index
+             * @throw std::runtime_error if a category is not in the dictionary
+             */
+            std::wstring get_indexed_text(const CategoryDictionary& dictionary) const;
+
+            /*!
+             * get the number of categories of the payload that are not in the category dictionary of the index
+             * @return the number of categories stored by name in the payload
+             */
+            size_t get_num_extra_categories() const { return extra_names.size(); }
+
+        private:
+            const std::wstring& get_category_name(uint32_t reference, const CategoryDictionary& dictionary) const;
+
+            uint32_t num_words{0};
+            std::vector<std::wstring> extra_names;
+            std::vector<int32_t> extra_ids;
+            std::vector<uint32_t> word_indices;
+            std::vector<std::vector<uint32_t>> word_categories;
+        };
+    }
+}
+
+#endif //LIBTPC_CATEGORYPAYLOAD_H
@@ -0,0 +1,420 @@
+/**
+    Project: libtpc
+    File name: CompactCasSerializer.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "CompactCasSerializer.h"
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+using namespace tpc::cas;
+
+namespace {
+
+    const uint64_t NULL_STRING_REF = 0;
+    const uint64_t NEW_STRING_REF = 1;
+
+    void write_varint(ostream& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.put(static_cast<char>(value));
+    }
+
+    void write_zigzag(ostream& out, int64_t value) {
+        write_varint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void write_string(ostream& out, const string& value) {
+        write_varint(out, value.size());
+        out.write(value.data(), value.size());
+    }
+
+    template<typename T>
+    void write_fixed(ostream& out, T value) {
+        char bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        out.write(bytes, sizeof(T));
+    }
+
+    /*!
+     * sequential reader of the fields of a compact cas
+     */
+    class CompactCasReader {
+    public:
+        CompactCasReader(const string& data, size_t offset) :
+                pos(data.data() + min(offset, data.size())), end(data.data() + data.size()) { }
+
+        uint64_t read_varint() {
+            uint64_t value = 0;
+            int shift = 0;
+            while (true) {
+                check_available(1);
+                auto byte = static_cast<unsigned char>(*pos++);
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+                shift += 7;
+                if (shift > 63) {
+                    throw runtime_error("corrupted compact cas: varint too long");
+                }
+            }
+        }
+
+        int64_t read_zigzag() {
+            uint64_t value = read_varint();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        string read_string() {
+            uint64_t size = read_varint();
+            check_available(size);
+            string value(pos, size);
+            pos += size;
+            return value;
+        }
+
+        template<typename T>
+        T read_fixed() {
+            check_available(sizeof(T));
+            T value;
+            memcpy(&value, pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        char read_byte() {
+            check_available(1);
+            return *pos++;
+        }
+
+    private:
+        void check_available(uint64_t size) const {
+            if (size > static_cast<uint64_t>(end - pos)) {
+                throw runtime_error("corrupted compact cas: unexpected end of data");
+            }
+        }
+
+        const char* pos;
+        const char* end;
+    };
+}
+
+CompactFeatureKind CompactCasSerializer::get_feature_kind(const uima::Feature& feature) {
+    uima::Type range_type;
+    feature.getRangeType(range_type);
+    string range_name = range_type.getName().asUTF8();
+    if (range_name == "uima.cas.String") {
+        return CompactFeatureKind::string;
+    } else if (range_name == "uima.cas.Integer") {
+        return CompactFeatureKind::integer;
+    } else if (range_name == "uima.cas.Float") {
+        return CompactFeatureKind::floating;
+    } else if (range_name == "uima.cas.Boolean") {
+        return CompactFeatureKind::boolean;
+    } else if (range_name == "uima.cas.Byte") {
+        return CompactFeatureKind::byte;
+    } else if (range_name == "uima.cas.Short") {
+        return CompactFeatureKind::short_int;
+    } else if (range_name == "uima.cas.Long") {
+        return CompactFeatureKind::long_int;
+    } else if (range_name == "uima.cas.Double") {
+        return CompactFeatureKind::double_floating;
+    }
+    return CompactFeatureKind::unsupported;
+}
+
+void CompactCasSerializer::serialize(uima::CAS& cas, ostream& out) {
+    // collect the annotations and the table of their types
+    vector<uima::AnnotationFS> annotations;
+    vector<size_t> annotation_types;
+    vector<TypeEntry> types;
+    vector<vector<uima::Feature>> type_features;
+    map<string, size_t> type_indices;
+    uima::ANIterator aait = cas.getAnnotationIndex().iterator();
+    for (aait.moveToFirst(); aait.isValid(); aait.moveToNext()) {
+        uima::AnnotationFS annotation = aait.get();
+        uima::Type type = annotation.getType();
+        string type_name = type.getName().asUTF8();
+        // the document annotation is created by the cas when the sofa text is set
+        if (type_name == "uima.tcas.DocumentAnnotation") {
+            continue;
+        }
+        auto type_it = type_indices.find(type_name);
+        if (type_it == type_indices.end()) {
+            TypeEntry entry;
+            entry.name = type_name;
+            vector<uima::Feature> all_features;
+            type.getAppropriateFeatures(all_features);
+            vector<uima::Feature> features;
+            for (const uima::Feature& feature : all_features) {
+                string feature_name = feature.getName().asUTF8();
+                feature_name = feature_name.substr(feature_name.find_last_of(':') + 1);
+                if (feature_name == "sofa" || feature_name == "begin" || feature_name == "end") {
+                    continue;
+                }
+                entry.feature_names.push_back(feature_name);
+                entry.feature_kinds.push_back(get_feature_kind(feature));
+                features.push_back(feature);
+            }
+            type_it = type_indices.insert({type_name, types.size()}).first;
+            types.push_back(entry);
+            type_features.push_back(features);
+        }
+        annotations.push_back(annotation);
+        annotation_types.push_back(type_it->second);
+    }
+    out.write(COMPACT_CAS_MAGIC.data(), COMPACT_CAS_MAGIC.size());
+    write_varint(out, COMPACT_CAS_VERSION);
+    write_string(out, cas.getDocumentText().asUTF8());
+    write_varint(out, types.size());
+    for (const TypeEntry& type : types) {
+        write_string(out, type.name);
+        write_varint(out, type.feature_names.size());
+        for (size_t i = 0; i < type.feature_names.size(); ++i) {
+            write_string(out, type.feature_names[i]);
+            out.put(static_cast<char>(type.feature_kinds[i]));
+        }
+    }
+    write_varint(out, annotations.size());
+    map<string, uint64_t> string_refs;
+    int64_t prev_begin = 0;
+    for (size_t i = 0; i < annotations.size(); ++i) {
+        const TypeEntry& type = types[annotation_types[i]];
+        const vector<uima::Feature>& features = type_features[annotation_types[i]];
+        auto begin = static_cast<int64_t>(annotations[i].getBeginPosition());
+        auto end = static_cast<int64_t>(annotations[i].getEndPosition());
+        write_varint(out, annotation_types[i]);
+        write_zigzag(out, begin - prev_begin);
+        write_zigzag(out, end - begin);
+        prev_begin = begin;
+        for (size_t j = 0; j < features.size(); ++j) {
+            switch (type.feature_kinds[j]) {
+                case CompactFeatureKind::string: {
+                    uima::UnicodeStringRef value_ref = annotations[i].getStringValue(features[j]);
+                    if (value_ref.getBuffer() == nullptr) {
+                        write_varint(out, NULL_STRING_REF);
+                        break;
+                    }
+                    string value = value_ref.asUTF8();
+                    auto ref_it = string_refs.find(value);
+                    if (ref_it != string_refs.end()) {
+                        write_varint(out, ref_it->second);
+                    } else {
+                        // new strings are written inline and take the next reference
+                        write_varint(out, NEW_STRING_REF);
+                        write_string(out, value);
+                        string_refs.insert({value, string_refs.size() + 2});
+                    }
+                    break;
+                }
+                case CompactFeatureKind::integer:
+                    write_zigzag(out, annotations[i].getIntValue(features[j]));
+                    break;
+                case CompactFeatureKind::floating:
+                    write_fixed<float>(out, annotations[i].getFloatValue(features[j]));
+                    break;
+                case CompactFeatureKind::boolean:
+                    out.put(static_cast<char>(annotations[i].getBooleanValue(features[j]) ? 1 : 0));
+                    break;
+                case CompactFeatureKind::byte:
+                    out.put(annotations[i].getByteValue(features[j]));
+                    break;
+                case CompactFeatureKind::short_int:
+                    write_zigzag(out, annotations[i].getShortValue(features[j]));
+                    break;
+                case CompactFeatureKind::long_int:
+                    write_zigzag(out, annotations[i].getLongValue(features[j]));
+                    break;
+                case CompactFeatureKind::double_floating:
+                    write_fixed<double>(out, annotations[i].getDoubleValue(features[j]));
+                    break;
+                case CompactFeatureKind::unsupported:
+                    break;
+            }
+        }
+    }
+}
+
+void CompactCasSerializer::parse(const string& data, string& sofa, const AnnotationCallback& callback) {
+    if (!is_compact_cas(data)) {
+        throw runtime_error("not a compact cas");
+    }
+    CompactCasReader reader(data, COMPACT_CAS_MAGIC.size());
+    uint64_t version = reader.read_varint();
+    if (version > COMPACT_CAS_VERSION) {
+        throw runtime_error("unsupported compact cas version " + to_string(version));
+    }
+    sofa = reader.read_string();
+    vector<TypeEntry> types(reader.read_varint());
+    for (TypeEntry& type : types) {
+        type.name = reader.read_string();
+        uint64_t num_features = reader.read_varint();
+        for (uint64_t i = 0; i < num_features; ++i) {
+            type.feature_names.push_back(reader.read_string());
+            type.feature_kinds.push_back(static_cast<CompactFeatureKind>(reader.read_byte()));
+        }
+    }
+    uint64_t num_annotations = reader.read_varint();
+    vector<string> strings;
+    int64_t begin = 0;
+    vector<CompactFeatureValue> values;
+    for (uint64_t i = 0; i < num_annotations; ++i) {
+        uint64_t type_index = reader.read_varint();
+        if (type_index >= types.size()) {
+            throw runtime_error("corrupted compact cas: invalid type index");
+        }
+        const TypeEntry& type = types[type_index];
+        begin += reader.read_zigzag();
+        int64_t end = begin + reader.read_zigzag();
+        values.assign(type.feature_kinds.size(), CompactFeatureValue());
+        for (size_t j = 0; j < type.feature_kinds.size(); ++j) {
+            CompactFeatureValue& value = values[j];
+            value.kind = type.feature_kinds[j];
+            switch (value.kind) {
+                case CompactFeatureKind::string: {
+                    uint64_t ref = reader.read_varint();
+                    if (ref == NULL_STRING_REF) {
+                        value.is_null = true;
+                    } else if (ref == NEW_STRING_REF) {
+                        strings.push_back(reader.read_string());
+                        value.string_value = strings.back();
+                    } else if (ref - 2 < strings.size()) {
+                        value.string_value = strings[ref - 2];
+                    } else {
+                        throw runtime_error("corrupted compact cas: invalid string reference");
+                    }
+                    break;
+                }
+                case CompactFeatureKind::integer:
+                case CompactFeatureKind::short_int:
+                case CompactFeatureKind::long_int:
+                    value.int_value = reader.read_zigzag();
+                    break;
+                case CompactFeatureKind::floating:
+                    value.double_value = reader.read_fixed<float>();
+                    break;
+                case CompactFeatureKind::double_floating:
+                    value.double_value = reader.read_fixed<double>();
+                    break;
+                case CompactFeatureKind::boolean:
+                case CompactFeatureKind::byte:
+                    value.int_value = reader.read_byte();
+                    break;
+                case CompactFeatureKind::unsupported:
+                    break;
+            }
+        }
+        if (!callback(type, static_cast<size_t>(begin), static_cast<size_t>(end), values)) {
+            return;
+        }
+    }
+}
+
+void CompactCasSerializer::deserialize(const string& data, uima::CAS& cas) {
+    string sofa;
+    uima::FSIndexRepository& index_repository = cas.getIndexRepository();
+    const uima::TypeSystem& type_system = cas.getTypeSystem();
+    // the types of the cas are resolved once for each entry of the type table
+    map<string, pair<uima::Type, vector<uima::Feature>>> cas_types;
+    bool sofa_set = false;
+    parse(data, sofa, [&](const TypeEntry& type, size_t begin, size_t end,
+                          const vector<CompactFeatureValue>& values) {
+        if (!sofa_set) {
+            icu::UnicodeString usofa = icu::UnicodeString::fromUTF8(sofa);
+            cas.setDocumentText(usofa.getBuffer(), usofa.length(), true);
+            sofa_set = true;
+        }
+        auto type_it = cas_types.find(type.name);
+        if (type_it == cas_types.end()) {
+            uima::Type cas_type = type_system.getType(icu::UnicodeString::fromUTF8(type.name));
+            vector<uima::Feature> features;
+            for (const string& feature_name : type.feature_names) {
+                features.push_back(cas_type.isValid() ?
+                                   cas_type.getFeatureByBaseName(icu::UnicodeString::fromUTF8(feature_name)) :
+                                   uima::Feature());
+            }
+            type_it = cas_types.insert({type.name, {cas_type, features}}).first;
+        }
+        if (!type_it->second.first.isValid()) {
+            return true;
+        }
+        uima::AnnotationFS annotation = cas.createAnnotation(type_it->second.first, begin, end);
+        const vector<uima::Feature>& features = type_it->second.second;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (!features[i].isValid()) {
+                continue;
+            }
+            const CompactFeatureValue& value = values[i];
+            switch (value.kind) {
+                case CompactFeatureKind::string:
+                    if (!value.is_null) {
+                        annotation.setStringValue(features[i], icu::UnicodeString::fromUTF8(value.string_value));
+                    }
+                    break;
+                case CompactFeatureKind::integer:
+                    annotation.setIntValue(features[i], static_cast<int>(value.int_value));
+                    break;
+                case CompactFeatureKind::floating:
+                    annotation.setFloatValue(features[i], static_cast<float>(value.double_value));
+                    break;
+                case CompactFeatureKind::boolean:
+                    annotation.setBooleanValue(features[i], value.int_value != 0);
+                    break;
+                case CompactFeatureKind::byte:
+                    annotation.setByteValue(features[i], static_cast<char>(value.int_value));
+                    break;
+                case CompactFeatureKind::short_int:
+                    annotation.setShortValue(features[i], static_cast<short>(value.int_value));
+                    break;
+                case CompactFeatureKind::long_int:
+                    annotation.setLongValue(features[i], value.int_value);
+                    break;
+                case CompactFeatureKind::double_floating:
+                    annotation.setDoubleValue(features[i], value.double_value);
+                    break;
+                case CompactFeatureKind::unsupported:
+                    break;
+            }
+        }
+        index_repository.addFS(annotation);
+        return true;
+    });
+    // documents without annotations still get their text
+    if (!sofa_set) {
+        icu::UnicodeString usofa = icu::UnicodeString::fromUTF8(sofa);
+        cas.setDocumentText(usofa.getBuffer(), usofa.length(), true);
+    }
+}
+
+bool CompactCasSerializer::is_compact_cas(const string& data) {
+    return data.compare(0, COMPACT_CAS_MAGIC.size(), COMPACT_CAS_MAGIC) == 0;
+}
+
+string CompactCasSerializer::get_string_feature_value(const string& data, const string& type_name,
+                                                      const string& feature_name) {
+    string sofa;
+    string result;
+    parse(data, sofa, [&](const TypeEntry& type, size_t begin, size_t end,
+                          const vector<CompactFeatureValue>& values) {
+        if (type.name != type_name) {
+            return true;
+        }
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (type.feature_names[i] == feature_name) {
+                result = values[i].string_value;
+                return false;
+            }
+        }
+        return true;
+    });
+    return result;
+}
@@ -0,0 +1,125 @@
+/**
+    Project: libtpc
+    File name: CompactCasSerializer.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_COMPACTCASSERIALIZER_H
+#define LIBTPC_COMPACTCASSERIALIZER_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include <cstdint>
+#include "uima/api.hpp"
+
+namespace tpc {
+
+    namespace cas {
+
+        static const std::string COMPACT_CAS_MAGIC("TPCB");
+        static const uint64_t COMPACT_CAS_VERSION = 1;
+
+        /*!
+         * kinds of feature values stored in a compact cas
+         */
+        enum class CompactFeatureKind {
+            unsupported = 0, string = 1, integer = 2, floating = 3, boolean = 4, byte = 5, short_int = 6,
+            long_int = 7, double_floating = 8
+        };
+
+        /*!
+         * @struct CompactFeatureValue
+         * @brief a feature value read from a compact cas
+         *
+         * @var <b>kind</b> the kind of the value
+         * @var <b>is_null</b> whether the value of a string feature is null
+         * @var <b>string_value</b> the value of string features
+         * @var <b>int_value</b> the value of integer, boolean, byte, short and long features
+         * @var <b>double_value</b> the value of float and double features
+         */
+        struct CompactFeatureValue {
+            CompactFeatureKind kind{CompactFeatureKind::unsupported};
+            bool is_null{false};
+            std::string string_value;
+            int64_t int_value{0};
+            double double_value{0};
+        };
+
+        /*!
+         * @brief compact binary serialization of cas objects, as an alternative to xmi
+         *
+         * The format is composed of the magic string TPCB, the format version, the sofa text in utf-8, a type table
+         * with the names and value kinds of the features of each annotation type found in the cas, and the
+         * annotations in index order. Integers are varint encoded (zigzag for signed values), begin positions are
+         * delta encoded and each distinct string value is written once and then referenced by its index. Only the
+         * annotations of the default view and their primitive features are stored; references to other feature
+         * structures and arrays are not supported and are not restored
+         */
+        class CompactCasSerializer {
+        public:
+            /*!
+             * serialize a cas in compact format
+             * @param cas the cas to serialize
+             * @param out the output stream
+             */
+            static void serialize(uima::CAS& cas, std::ostream& out);
+
+            /*!
+             * fill a cas from its compact serialization. The types and features of the serialized annotations are
+             * looked up by name in the type system of the cas, annotations of unknown types and values of unknown
+             * features are skipped
+             * @param data the compact serialization
+             * @param cas the cas to fill, which must be empty
+             */
+            static void deserialize(const std::string& data, uima::CAS& cas);
+
+            /*!
+             * check whether some serialized data is in compact format
+             * @param data the serialized data
+             * @return true if the data starts with the compact format magic string, false otherwise
+             */
+            static bool is_compact_cas(const std::string& data);
+
+            /*!
+             * get the value of a string feature of the first annotation of a type, without creating a cas
+             * @param data the compact serialization
+             * @param type_name the full name of the annotation type
+             * @param feature_name the base name of the feature
+             * @return the value of the feature, or an empty string if not found
+             */
+            static std::string get_string_feature_value(const std::string& data, const std::string& type_name,
+                                                        const std::string& feature_name);
+
+        private:
+            /*!
+             * @struct TypeEntry
+             * @brief an annotation type in the type table of a compact cas
+             */
+            struct TypeEntry {
+                std::string name;
+                std::vector<std::string> feature_names;
+                std::vector<CompactFeatureKind> feature_kinds;
+            };
+
+            typedef std::function<bool(const TypeEntry& type, size_t begin, size_t end,
+                                       const std::vector<CompactFeatureValue>& values)> AnnotationCallback;
+
+            /*!
+             * parse a compact serialization, calling a function for each annotation
+             * @param data the compact serialization
+             * @param sofa the sofa text read from the data
+             * @param callback the function called for each annotation. The parsing stops if the function returns
+             * false
+             */
+            static void parse(const std::string& data, std::string& sofa, const AnnotationCallback& callback);
+
+            static CompactFeatureKind get_feature_kind(const uima::Feature& feature);
+        };
+    }
+}
+
+#endif //LIBTPC_COMPACTCASSERIALIZER_H
@@ -0,0 +1,294 @@
+/**
+    Project: libtpc
+    File name: CorpusClassifier.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "CorpusClassifier.h"
+#include <queue>
+#include <cctype>
+
+using namespace tpc::cas;
+using namespace std;
+
+// placeholder for the '.' wildcard in expanded patterns
+static const char WILDCARD('\0');
+
+CorpusClassifier::CorpusClassifier(const vector<pair<string, string>>& corpus_patterns) :
+        corpus_names(),
+        corpus_regexes(),
+        regex_only_corpora(),
+        nodes(1) {
+    nodes[0].fail = 0;
+    for (const auto& corpus_pattern : corpus_patterns) {
+        auto corpus = static_cast<int32_t>(corpus_names.size());
+        corpus_names.push_back(corpus_pattern.first);
+        corpus_regexes.emplace_back(corpus_pattern.second);
+        const string& re = corpus_pattern.second;
+        vector<string> expansions;
+        bool expanded = false;
+        if (re.length() >= 4 && re.compare(0, 2, ".*") == 0 && re.compare(re.length() - 2, 2, ".*") == 0 &&
+                re[re.length() - 3] != '\\') {
+            string inner = re.substr(2, re.length() - 4);
+            size_t pos = 0;
+            expanded = expand_alternation(inner, pos, expansions) && pos == inner.length();
+        }
+        vector<pair<string, bool>> keys;
+        for (const string& expansion : expansions) {
+            if (!expanded) {
+                break;
+            }
+            // the longest literal part of a string with wildcards is used as key and its matches are confirmed by
+            // the regular expression
+            size_t wildcard = expansion.find(WILDCARD);
+            string key;
+            if (wildcard == string::npos) {
+                key = expansion;
+            } else {
+                size_t begin = 0;
+                while (begin <= expansion.length()) {
+                    size_t end = expansion.find(WILDCARD, begin);
+                    end = end == string::npos ? expansion.length() : end;
+                    if (end - begin > key.length()) {
+                        key = expansion.substr(begin, end - begin);
+                    }
+                    begin = end + 1;
+                }
+            }
+            if (key.empty()) {
+                expanded = false;
+            } else {
+                keys.emplace_back(key, wildcard != string::npos);
+            }
+        }
+        if (expanded) {
+            for (const auto& key : keys) {
+                add_key(key.first, Key{corpus, key.second});
+            }
+        } else {
+            regex_only_corpora.push_back(corpus);
+        }
+    }
+    build_failure_links();
+}
+
+vector<string> CorpusClassifier::classify(const BibInfo& bib_info) const {
+    vector<bool> matched(corpus_names.size(), false);
+    match_field(bib_info.subject, matched);
+    match_field(bib_info.title, matched);
+    match_field(bib_info.journal, matched);
+    vector<string> matching_corpora;
+    for (size_t i = 0; i < corpus_names.size(); ++i) {
+        if (matched[i]) {
+            matching_corpora.push_back(corpus_names[i]);
+        }
+    }
+    if (matching_corpora.empty()) {
+        matching_corpora.push_back(PMCOA_UNCLASSIFIED);
+    }
+    return matching_corpora;
+}
+
+void CorpusClassifier::match_field(const string& field, vector<bool>& matched) const {
+    vector<bool> found(corpus_names.size(), false);
+    vector<bool> candidates(corpus_names.size(), false);
+    bool multiline = false;
+    int32_t state = 0;
+    for (char c : field) {
+        if (c == '\n' || c == '\r') {
+            // the wildcards of .*X.* patterns do not match line terminators, so these patterns cannot match the
+            // whole field
+            multiline = true;
+            break;
+        }
+        auto uc = static_cast<unsigned char>(c);
+        auto child = nodes[state].children.find(uc);
+        while (state != 0 && child == nodes[state].children.end()) {
+            state = nodes[state].fail;
+            child = nodes[state].children.find(uc);
+        }
+        state = child != nodes[state].children.end() ? child->second : 0;
+        for (const Key& key : nodes[state].keys) {
+            if (key.needs_confirmation) {
+                candidates[key.corpus] = true;
+            } else {
+                found[key.corpus] = true;
+            }
+        }
+    }
+    if (!multiline) {
+        for (size_t i = 0; i < corpus_names.size(); ++i) {
+            if (matched[i]) {
+                continue;
+            }
+            if (found[i] || (candidates[i] && regex_match(field, corpus_regexes[i]))) {
+                matched[i] = true;
+            }
+        }
+    }
+    for (int32_t corpus : regex_only_corpora) {
+        if (!matched[corpus] && regex_match(field, corpus_regexes[corpus])) {
+            matched[corpus] = true;
+        }
+    }
+}
+
+void CorpusClassifier::add_key(const string& key, const Key& value) {
+    int32_t state = 0;
+    for (char c : key) {
+        auto uc = static_cast<unsigned char>(c);
+        auto child = nodes[state].children.find(uc);
+        if (child == nodes[state].children.end()) {
+            nodes.emplace_back();
+            nodes.back().fail = 0;
+            int32_t new_state = static_cast<int32_t>(nodes.size()) - 1;
+            nodes[state].children[uc] = new_state;
+            state = new_state;
+        } else {
+            state = child->second;
+        }
+    }
+    nodes[state].keys.push_back(value);
+}
+
+void CorpusClassifier::build_failure_links() {
+    queue<int32_t> states;
+    for (const auto& child : nodes[0].children) {
+        nodes[child.second].fail = 0;
+        states.push(child.second);
+    }
+    while (!states.empty()) {
+        int32_t state = states.front();
+        states.pop();
+        for (const auto& child : nodes[state].children) {
+            int32_t fail = nodes[state].fail;
+            while (fail != 0 && nodes[fail].children.find(child.first) == nodes[fail].children.end()) {
+                fail = nodes[fail].fail;
+            }
+            auto fail_child = nodes[fail].children.find(child.first);
+            nodes[child.second].fail = fail_child != nodes[fail].children.end() ? fail_child->second : 0;
+            // keys ending at the failure state also end here
+            const vector<Key>& fail_keys = nodes[nodes[child.second].fail].keys;
+            nodes[child.second].keys.insert(nodes[child.second].keys.end(), fail_keys.begin(), fail_keys.end());
+            states.push(child.second);
+        }
+    }
+}
+
+bool CorpusClassifier::expand_alternation(const string& re, size_t& pos, vector<string>& result) {
+    result.clear();
+    while (true) {
+        vector<string> alternative;
+        if (!expand_sequence(re, pos, alternative)) {
+            return false;
+        }
+        result.insert(result.end(), alternative.begin(), alternative.end());
+        if (result.size() > MAX_EXPANSIONS) {
+            return false;
+        }
+        if (pos < re.length() && re[pos] == '|') {
+            ++pos;
+        } else {
+            return true;
+        }
+    }
+}
+
+bool CorpusClassifier::expand_sequence(const string& re, size_t& pos, vector<string>& result) {
+    result.assign(1, "");
+    while (pos < re.length() && re[pos] != '|' && re[pos] != ')') {
+        vector<string> atom;
+        if (!expand_atom(re, pos, atom)) {
+            return false;
+        }
+        if (pos < re.length() && re[pos] == '?') {
+            atom.emplace_back("");
+            ++pos;
+        }
+        if (pos < re.length() && (re[pos] == '*' || re[pos] == '+' || re[pos] == '{' || re[pos] == '?')) {
+            return false;
+        }
+        if (result.size() * atom.size() > MAX_EXPANSIONS) {
+            return false;
+        }
+        vector<string> combined;
+        combined.reserve(result.size() * atom.size());
+        for (const string& prefix : result) {
+            for (const string& suffix : atom) {
+                combined.push_back(prefix + suffix);
+            }
+        }
+        result.swap(combined);
+    }
+    return true;
+}
+
+bool CorpusClassifier::expand_atom(const string& re, size_t& pos, vector<string>& result) {
+    result.clear();
+    char c = re[pos];
+    switch (c) {
+        case '(':
+            ++pos;
+            if (pos >= re.length() || re[pos] == '?' || !expand_alternation(re, pos, result) || pos >= re.length() ||
+                    re[pos] != ')') {
+                return false;
+            }
+            ++pos;
+            return true;
+        case '[':
+            ++pos;
+            if (pos < re.length() && re[pos] == '^') {
+                return false;
+            }
+            while (pos < re.length() && re[pos] != ']') {
+                if (re[pos] == '\\' || re[pos] == '[') {
+                    return false;
+                }
+                if (pos + 2 < re.length() && re[pos + 1] == '-' && re[pos + 2] != ']') {
+                    for (int r = static_cast<unsigned char>(re[pos]); r <= static_cast<unsigned char>(re[pos + 2]);
+                         ++r) {
+                        result.emplace_back(1, static_cast<char>(r));
+                    }
+                    pos += 3;
+                } else {
+                    result.emplace_back(1, re[pos]);
+                    ++pos;
+                }
+                if (result.size() > MAX_EXPANSIONS) {
+                    return false;
+                }
+            }
+            if (pos >= re.length() || result.empty()) {
+                return false;
+            }
+            ++pos;
+            return true;
+        case '\\':
+            if (pos + 1 >= re.length() || isalnum(static_cast<unsigned char>(re[pos + 1]))) {
+                return false;
+            }
+            result.emplace_back(1, re[pos + 1]);
+            pos += 2;
+            return true;
+        case '.':
+            result.emplace_back(1, WILDCARD);
+            ++pos;
+            return true;
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+        case '}':
+        case '^':
+        case '$':
+        case ']':
+        case WILDCARD:
+            return false;
+        default:
+            result.emplace_back(1, c);
+            ++pos;
+            return true;
+    }
+}
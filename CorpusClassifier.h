@@ -0,0 +1,95 @@
+/**
+    Project: libtpc
+    File name: CorpusClassifier.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_CORPUSCLASSIFIER_H
+#define LIBTPC_CORPUSCLASSIFIER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <regex>
+#include <cstdint>
+#include "CASManager.h"
+
+namespace tpc {
+
+    namespace cas {
+
+        /*!
+         * @brief classifier of articles into corpora, based on regular expressions matched against their bibliographic
+         * information
+         *
+         * All the corpus patterns are compiled once, when the classifier is created, into a single Aho-Corasick
+         * automaton, so that each field of an article is scanned only once regardless of the number of corpora.
+         * Patterns of the form .*X.*, where X is made of literals, character classes, groups with alternatives and
+         * optional atoms, are expanded into the finite set of strings matched by X and added to the automaton.
+         * Strings containing wildcards contribute their longest literal part, and a match of that part is confirmed by
+         * the compiled regular expression. Patterns that cannot be expanded are always checked with their regular
+         * expression. The result is the same as matching each regular expression against the whole field
+         */
+        class CorpusClassifier {
+        public:
+            /*!
+             * create a classifier for a list of corpora
+             * @param corpus_patterns pairs of corpus names and regular expressions
+             */
+            explicit CorpusClassifier(const std::vector<std::pair<std::string, std::string>>& corpus_patterns =
+                    PMCOA_CAT_REGEX);
+
+            /*!
+             * get the corpora matching the subject, title or journal of an article
+             * @param bib_info the bibliographic information of the article
+             * @return the names of the matching corpora, in the order in which they were given to the constructor, or
+             * the unclassified corpus if no corpus matches
+             */
+            std::vector<std::string> classify(const BibInfo& bib_info) const;
+
+        private:
+            static const int32_t MAX_EXPANSIONS = 256;
+
+            /*!
+             * @struct Key
+             * @brief a string added to the automaton for a corpus
+             */
+            struct Key {
+                int32_t corpus;
+                bool needs_confirmation;
+            };
+
+            struct Node {
+                std::map<unsigned char, int32_t> children;
+                int32_t fail;
+                std::vector<Key> keys;
+            };
+
+            /*!
+             * mark the corpora matching a field of an article
+             * @param field the text of the field
+             * @param matched the corpora matched so far, updated by the function
+             */
+            void match_field(const std::string& field, std::vector<bool>& matched) const;
+
+            void add_key(const std::string& key, const Key& value);
+
+            void build_failure_links();
+
+            static bool expand_alternation(const std::string& re, size_t& pos, std::vector<std::string>& result);
+
+            static bool expand_sequence(const std::string& re, size_t& pos, std::vector<std::string>& result);
+
+            static bool expand_atom(const std::string& re, size_t& pos, std::vector<std::string>& result);
+
+            std::vector<std::string> corpus_names;
+            std::vector<std::regex> corpus_regexes;
+            std::vector<int32_t> regex_only_corpora;
+            std::vector<Node> nodes;
+        };
+    }
+}
+
+#endif //LIBTPC_CORPUSCLASSIFIER_H
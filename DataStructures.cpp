@@ -23,7 +23,6 @@ string Query::get_query_text() const {
         add_field_to_text_if_not_empty("sentence", keyword, false, query_text);
         add_field_to_text_if_not_empty("-sentence", exclude_keyword, false, query_text);
     }
-    add_field_to_text_if_not_empty("year", year, false, query_text);
     add_field_to_text_if_not_empty("accession", accession, false, query_text, true);
     add_field_to_text_if_not_empty("type", paper_type, false, query_text);
     add_field_to_text_if_not_empty("author", author, exact_match_author, query_text);
@@ -65,6 +65,20 @@ namespace tpc {
             std::string categories_string;
         };
 
+        /*!
+         * @struct MatchRange
+         * @brief range of characters of the text of a document or sentence that matches a term of a query
+         *
+         * @var <b>begin</b> offset of the first character of the match in the indexed text
+         * @var <b>end</b> offset of the character following the match in the indexed text
+         * @var <b>term</b> the indexed term that matches
+         */
+        struct MatchRange {
+            int begin{-1};
+            int end{-1};
+            std::string term;
+        };
+
         /*!
          * @struct Document
          * @brief generic information of a document
@@ -143,7 +157,8 @@ namespace tpc {
             std::vector<std::string> categories{};
 
             /*!
-             * combine the query fields and get the full query text
+             * combine the query fields and get the full query text. The year is not included, since it is matched as a
+             * numeric range by IndexManager::search_documents
              * @return the text for the Lucene query
              */
             std::string get_query_text() const;
@@ -177,6 +192,57 @@ namespace tpc {
 
             void update(const SearchResults &other);
         };
+
+        /*!
+         * @struct IndexWriterOptions
+         * @brief tuning options of the Lucene index writers used to build the subindexes
+         *
+         * The defaults reproduce the behavior of Lucene. For bulk builds of 50k-paper subindexes, a large RAM buffer
+         * (e.g., 512MB), a max merge size of a few GB, no compound files during the build and a final forced merge
+         * to a small number of segments reduce the build time and the segment fan-in at query time
+         *
+         * @var <b>ram_buffer_size_mb</b> size of the RAM buffer of each writer before flushing a new segment
+         * @var <b>merge_factor</b> number of segments of the same size merged together by the log byte size merge
+         * policy
+         * @var <b>max_merge_mb</b> segments larger than this size are not merged during the build
+         * @var <b>use_compound_file</b> whether to write compound files during the build
+         * @var <b>max_num_segments</b> number of segments of each subindex after the final forced merge, which always
+         * writes compound files. 0 disables the final merge
+         * @var <b>store_term_vectors</b> whether to store term vectors with positions and offsets for the fulltext of
+         * the documents and the text of the sentences, which are required by IndexManager::get_match_ranges
+         * @var <b>sentence_blocks</b> whether to store the text and the categories of all the sentences of a document
+         * in a single compressed block of the fulltext document instead of in each sentence document
+         */
+        struct IndexWriterOptions {
+            double ram_buffer_size_mb{16};
+            int merge_factor{10};
+            double max_merge_mb{DBL_MAX};
+            bool use_compound_file{true};
+            int max_num_segments{0};
+            bool store_term_vectors{false};
+            bool sentence_blocks{false};
+        };
+
+        /*!
+         * @struct IndexingPipelineOptions
+         * @brief number of threads and queue sizes of the pipeline that adds cas files to a subindex
+         *
+         * @var <b>num_read_threads</b> number of threads that read and decompress the cas files
+         * @var <b>num_deserialize_threads</b> number of threads that deserialize the xmi data into cas objects
+         * @var <b>queue_size</b> max number of files waiting between two stages. It also bounds the number of cas
+         * objects kept in memory
+         * @var <b>num_walk_threads</b> number of threads that enumerate the input directory tree
+         * @var <b>max_walk_depth</b> max depth of the input directory tree to enumerate, -1 for no limit
+         * @var <b>walk_batch_size</b> number of files enumerated in each batch
+         */
+        struct IndexingPipelineOptions {
+            int num_read_threads{2};
+            int num_deserialize_threads{2};
+            size_t queue_size{16};
+            int num_walk_threads{4};
+            int max_walk_depth{-1};
+            size_t walk_batch_size{256};
+        };
     }
 }
 
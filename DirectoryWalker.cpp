@@ -0,0 +1,152 @@
+/**
+    Project: libtpc
+    File name: DirectoryWalker.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "DirectoryWalker.h"
+#include <iostream>
+#include <stdexcept>
+#include <boost/algorithm/string.hpp>
+
+using namespace std;
+using namespace tpc;
+using namespace boost::filesystem;
+
+DirectoryWalker::DirectoryWalker(set<string> extensions, int max_depth, int num_threads, size_t batch_size) :
+        extensions(std::move(extensions)),
+        max_depth(max_depth),
+        num_threads(max(1, num_threads)),
+        batch_size(max(size_t(1), batch_size)),
+        threads(),
+        output(nullptr),
+        stopped(false),
+        root_error(),
+        directories(),
+        num_pending_directories(0),
+        num_active_threads(0) { }
+
+DirectoryWalker::~DirectoryWalker() {
+    if (!threads.empty()) {
+        stop();
+        for (auto& t : threads) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+}
+
+void DirectoryWalker::start(const string& root_dir, BoundedQueue<vector<FileEntry>>& output) {
+    boost::system::error_code ec;
+    if (!is_directory(path(root_dir), ec)) {
+        throw runtime_error("cannot list directory " + root_dir + ": not a directory");
+    }
+    this->output = &output;
+    stopped = false;
+    root_error.clear();
+    directories.emplace_back(path(root_dir), 0);
+    num_pending_directories = 1;
+    num_active_threads = num_threads;
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back(&DirectoryWalker::walk, this, std::ref(output));
+    }
+}
+
+void DirectoryWalker::stop() {
+    stopped = true;
+    if (output != nullptr) {
+        output->close();
+    }
+    {
+        // the flag is published under the lock, so that no thread misses the notification while going to wait
+        lock_guard<mutex> lock(directories_mutex);
+    }
+    directories_cv.notify_all();
+}
+
+void DirectoryWalker::join() {
+    for (auto& t : threads) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    threads.clear();
+    if (!root_error.empty()) {
+        throw runtime_error(root_error);
+    }
+}
+
+bool DirectoryWalker::has_valid_extension(const string& filename) const {
+    if (extensions.empty()) {
+        return true;
+    }
+    for (const string& extension : extensions) {
+        if (boost::algorithm::ends_with(filename, extension)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirectoryWalker::walk(BoundedQueue<vector<FileEntry>>& output) {
+    vector<FileEntry> batch;
+    while (true) {
+        pair<path, int> directory;
+        {
+            // a directory being listed by another thread can still add subdirectories to the queue
+            unique_lock<mutex> lock(directories_mutex);
+            directories_cv.wait(lock, [this] {
+                return stopped || !directories.empty() || num_pending_directories == 0;
+            });
+            if (stopped || directories.empty()) {
+                break;
+            }
+            directory = directories.front();
+            directories.pop_front();
+        }
+        vector<pair<path, int>> subdirectories;
+        boost::system::error_code ec;
+        for (directory_iterator dir_it(directory.first, ec); !ec && !stopped && dir_it != directory_iterator();
+             dir_it.increment(ec)) {
+            if (is_directory(dir_it->symlink_status())) {
+                if (max_depth < 0 || directory.second < max_depth) {
+                    subdirectories.emplace_back(dir_it->path(), directory.second + 1);
+                }
+            } else if (is_regular_file(dir_it->status()) &&
+                       has_valid_extension(dir_it->path().filename().string())) {
+                FileEntry entry;
+                entry.path = dir_it->path().string();
+                boost::system::error_code stat_ec;
+                entry.size = file_size(dir_it->path(), stat_ec);
+                entry.mtime = last_write_time(dir_it->path(), stat_ec);
+                batch.push_back(std::move(entry));
+                if (batch.size() >= batch_size) {
+                    if (!output.push(std::move(batch))) {
+                        stopped = true;
+                    }
+                    batch = vector<FileEntry>();
+                }
+            }
+        }
+        if (ec && directory.second == 0) {
+            root_error = "cannot list directory " + directory.first.string() + ": " + ec.message();
+        } else if (ec) {
+            cerr << "Error listing directory " << directory.first.string() << ": " << ec.message() << endl;
+        }
+        {
+            lock_guard<mutex> lock(directories_mutex);
+            directories.insert(directories.end(), subdirectories.begin(), subdirectories.end());
+            num_pending_directories += static_cast<int>(subdirectories.size()) - 1;
+        }
+        directories_cv.notify_all();
+    }
+    if (!batch.empty() && !stopped) {
+        output.push(std::move(batch));
+    }
+    if (--num_active_threads == 0) {
+        output.close();
+    }
+}
@@ -0,0 +1,107 @@
+/**
+    Project: libtpc
+    File name: DirectoryWalker.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_DIRECTORYWALKER_H
+#define LIBTPC_DIRECTORYWALKER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <boost/filesystem.hpp>
+#include "BoundedQueue.h"
+
+namespace tpc {
+
+    /*!
+     * @struct FileEntry
+     * @brief a file found by the directory walker
+     *
+     * @var <b>path</b> the path of the file
+     * @var <b>size</b> the size of the file
+     * @var <b>mtime</b> the last modification time of the file
+     */
+    struct FileEntry {
+        std::string path;
+        uintmax_t size{0};
+        std::time_t mtime{0};
+    };
+
+    /*!
+     * enumerate the files of a directory tree with a pool of threads, each one listing a different directory. The
+     * files are produced in batches to an output queue, so that their processing can start while the walk is still
+     * running. The output queue must outlive the walker. A walker destroyed while still running is stopped before
+     * its threads are joined, so that threads blocked on a full queue whose consumer has given up are released
+     */
+    class DirectoryWalker {
+    public:
+        /*!
+         * create a new directory walker
+         * @param extensions the suffixes of the file names to enumerate (e.g., .tpcas.gz). All the files are
+         * enumerated if empty
+         * @param max_depth the max depth of the subdirectories to visit, relative to the root directory. -1 for no limit
+         * @param num_threads the number of threads that list the directories
+         * @param batch_size the max number of files in each batch
+         */
+        DirectoryWalker(std::set<std::string> extensions, int max_depth = -1, int num_threads = 4,
+                        size_t batch_size = 256);
+
+        ~DirectoryWalker();
+
+        DirectoryWalker(const DirectoryWalker&) = delete;
+        DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+        /*!
+         * start the enumeration of a directory tree in background threads. Symbolic links to directories are not
+         * followed and subdirectories that cannot be listed are skipped. The output queue is closed when all the
+         * directories have been listed
+         * @param root_dir the root directory
+         * @param output the queue that receives the batches of files
+         * @throw std::runtime_error if the root directory does not exist or is not a directory
+         */
+        void start(const std::string& root_dir, BoundedQueue<std::vector<FileEntry>>& output);
+
+        /*!
+         * stop the enumeration. The output queue is closed and the threads exit without listing other directories
+         */
+        void stop();
+
+        /*!
+         * wait for the end of the enumeration
+         * @throw std::runtime_error if the root directory could not be listed
+         */
+        void join();
+
+    private:
+        void walk(BoundedQueue<std::vector<FileEntry>>& output);
+
+        bool has_valid_extension(const std::string& filename) const;
+
+        std::set<std::string> extensions;
+        int max_depth;
+        int num_threads;
+        size_t batch_size;
+        std::vector<std::thread> threads;
+        BoundedQueue<std::vector<FileEntry>>* output;
+        std::atomic<bool> stopped;
+        // set by the thread that lists the root directory, read after the threads are joined
+        std::string root_error;
+        std::deque<std::pair<boost::filesystem::path, int>> directories;
+        int num_pending_directories;
+        std::atomic<int> num_active_threads;
+        std::mutex directories_mutex;
+        std::condition_variable directories_cv;
+    };
+}
+
+#endif //LIBTPC_DIRECTORYWALKER_H
@@ -13,6 +13,7 @@
 #include "IndexManager.h"
 #include "Utils.h"
 #include "lucene-custom/CaseSensitiveAnalyzer.h"
+#include "lucene-custom/CategoryAnalyzer.h"
 #include "lucene-custom/LazySelector.h"
 #include "uima-custom-analyzers/Tpcas2SingleIndex/CASUtils.h"
 #include <lucene++/LuceneHeaders.h>
@@ -26,8 +27,10 @@
 #include <uima/exceptions.hpp>
 #include <uima/resmgr.hpp>
 #include <uima/engine.hpp>
+#include <unicode/unistr.h>
 #include <xercesc/util/XMLString.hpp>
 #include <uima/xmideserializer.hpp>
+#include <xercesc/framework/MemBufInputSource.hpp>
 #include <boost/filesystem.hpp>
 #include <regex>
 #include "CASManager.h"
@@ -39,6 +42,21 @@
 #include <dbstl_map.h>
 #include <dbstl_vector.h>
 #include "DataStructures.h"
+#include "BoundedQueue.h"
+#include "DirectoryWalker.h"
+#include "CategoryPayload.h"
+#include "SentenceBlock.h"
+#include "uima-annotators/globaldefinitions.h"
+#include "uima-annotators/TpLexiconAnnotatorFromPg/AllMyParents.h"
+#include <pqxx/pqxx>
+#include <codecvt>
+#include <locale>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <cstdlib>
 
 using namespace std;
 using namespace tpc::index;
@@ -46,13 +64,231 @@ using namespace Lucene;
 using namespace xercesc;
 using namespace boost::filesystem;
 
+namespace {
+    /*!
+     * cas file read from disk and decompressed, waiting to be deserialized
+     */
+    struct InflatedCasFile {
+        size_t sequence_num{0};
+        bool valid{false};
+        string file_path;
+        string bib_filename;
+        string bib_content;
+        string xmi;
+    };
+
+    /*!
+     * cas file deserialized into a cas object, waiting to be indexed. Files that could not be read or deserialized
+     * have no cas object and only keep their place in the sequence
+     */
+    struct DeserializedCasFile {
+        size_t sequence_num{0};
+        string file_path;
+        string bib_filename;
+        string bib_content;
+        string content_hash;
+        uima::CAS* cas{nullptr};
+    };
+
+    /*!
+     * raw file converted to the text stream read by the tokenizers, waiting to be processed
+     */
+    struct RawFileStream {
+        string file_path;
+        string filename;
+        string bib_filename;
+        string bib_content;
+        string stream;
+        string content_hash;
+    };
+
+    /*!
+     * the value of a parameter in the configuration parameter settings of a uima descriptor
+     */
+    bool get_descriptor_parameter(const string& descriptor, const string& name, string& value) {
+        std::ifstream ifs(descriptor);
+        string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        smatch match;
+        if (!regex_search(content, match, regex("<name>\\s*" + name +
+                "\\s*</name>\\s*<value>\\s*<string>\\s*([^<]*?)\\s*</string>"))) {
+            return false;
+        }
+        value = match[1];
+        return true;
+    }
+
+    /*!
+     * add the categories assigned by TpLexiconAnnotatorFromPg to the terms of a lexicon table: the category of each
+     * term and, with the pAaCh prefix, the category itself and all its parents
+     */
+    void add_pg_lexicon_categories(const string& lexicon_table_name, CategoryDictionary& category_dictionary) {
+        pqxx::connection cn(PGONTOLOGY);
+        pqxx::work w(cn);
+        pqxx::result r = w.exec("select distinct category from " + lexicon_table_name + " order by category");
+        w.commit();
+        cn.disconnect();
+        AllMyParents all_my_parents;
+        std::multimap<string, string> category_parents(all_my_parents.GetCPs());
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+        for (pqxx::result::size_type i = 0; i != r.size(); i++) {
+            string category;
+            if (!r[i]["category"].to(category)) {
+                continue;
+            }
+            category_dictionary.get_or_add_id(converter.from_bytes(category));
+            category_dictionary.get_or_add_id(converter.from_bytes("pAaCh" + category));
+            auto parents = category_parents.equal_range(category);
+            for (auto parent_it = parents.first; parent_it != parents.second; ++parent_it) {
+                category_dictionary.get_or_add_id(converter.from_bytes("pAaCh" + parent_it->second));
+            }
+        }
+    }
+}
+
+/*!
+ * @brief the document and sentence dbs of an index, opened once for the searches on the index
+ *
+ * The dbs are opened read-only in a private environment with its own memory pool, so that the pages read by a search
+ * stay cached for the next ones. The handles are free-threaded and are shared by concurrent searches
+ */
+class IndexManager::IndexDbs {
+public:
+    explicit IndexDbs(const string& db_dir);
+    ~IndexDbs();
+
+    /*!
+     * look up the value of a key in one of the dbs
+     * @param db the db, or null if the db does not exist
+     * @param key the key, as written by dbstl::db_map<int, string>
+     * @param value the value of the key, empty if the key is not in the db
+     * @return whether the key is in the db
+     */
+    static bool get_value(Db* db, int key, string& value);
+
+    /*!
+     * look up a bounded number of keys spread over the dbs, loading the internal pages of their btrees and a sample
+     * of their leaf pages in the memory pool
+     */
+    void warm_up();
+
+    DbCacheStats get_cache_stats();
+
+    Db* doc_map{nullptr};
+    Db* sent_map{nullptr};
+
+private:
+    Db* open_db(const char* db_name);
+
+    DbEnv env;
+    bool env_open{false};
+};
+
+IndexManager::IndexDbs::IndexDbs(const string& db_dir) : env(DB_CXX_NO_EXCEPTIONS) {
+    env.set_error_stream(&cerr);
+    env.set_cachesize(0, BDB_SEARCH_CACHE_SIZE, 1);
+    env_open = env.open(db_dir.c_str(), DB_CREATE | DB_PRIVATE | DB_INIT_MPOOL | DB_THREAD, 0) == 0;
+    if (env_open) {
+        doc_map = open_db("doc_map.db");
+        sent_map = open_db("sent_map.db");
+    }
+}
+
+IndexManager::IndexDbs::~IndexDbs() {
+    for (Db* db : {doc_map, sent_map}) {
+        if (db != nullptr) {
+            db->close(0);
+            delete db;
+        }
+    }
+    env.close(0);
+}
+
+Db* IndexManager::IndexDbs::open_db(const char* db_name) {
+    Db* db = new Db(&env, DB_CXX_NO_EXCEPTIONS);
+    if (db->open(NULL, db_name, NULL, DB_BTREE, DB_RDONLY | DB_THREAD, 0) != 0) {
+        db->close(0);
+        delete db;
+        return nullptr;
+    }
+    return db;
+}
+
+bool IndexManager::IndexDbs::get_value(Db* db, int key, string& value) {
+    value.clear();
+    if (db == nullptr) {
+        return false;
+    }
+    Dbt db_key(&key, sizeof(int));
+    Dbt data;
+    // the handle is shared between threads, so the value is returned in memory allocated for this lookup
+    data.set_flags(DB_DBT_MALLOC);
+    if (db->get(NULL, &db_key, &data, 0) != 0) {
+        return false;
+    }
+    // values are null terminated strings
+    const char* bytes = static_cast<const char*>(data.get_data());
+    value.assign(bytes, strnlen(bytes, data.get_size()));
+    free(data.get_data());
+    return true;
+}
+
+void IndexManager::IndexDbs::warm_up() {
+    for (Db* db : {doc_map, sent_map}) {
+        if (db == nullptr) {
+            continue;
+        }
+        // the fast stat only reads the meta page, so the number of keys is an estimate
+        DB_BTREE_STAT* stat = NULL;
+        u_int32_t num_probes = 0;
+        if (db->stat(NULL, &stat, DB_FAST_STAT) == 0) {
+            num_probes = min<u_int32_t>(stat->bt_nkeys, BDB_WARM_UP_MAX_PROBES);
+            free(stat);
+        }
+        Dbc* cursor;
+        if (num_probes == 0 || db->cursor(NULL, &cursor, 0) != 0) {
+            continue;
+        }
+        for (u_int32_t i = 0; i < num_probes; ++i) {
+            // the keys are ints compared as bytes by the default btree comparison, so the probes are spread over the
+            // byte order of the keys and each of them goes down a different path of the btree
+            uint32_t position = static_cast<uint32_t>((uint64_t(i) << 32) / num_probes);
+            unsigned char key_bytes[sizeof(int)] = {static_cast<unsigned char>(position >> 24),
+                                                    static_cast<unsigned char>(position >> 16),
+                                                    static_cast<unsigned char>(position >> 8),
+                                                    static_cast<unsigned char>(position)};
+            int key;
+            memcpy(&key, key_bytes, sizeof(int));
+            Dbt probe(&key, sizeof(int));
+            probe.set_ulen(sizeof(int));
+            probe.set_flags(DB_DBT_USERMEM);
+            // only the key is returned, the leaf page is loaded all the same
+            Dbt data;
+            data.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+            cursor->get(&probe, &data, DB_SET_RANGE);
+        }
+        cursor->close();
+    }
+}
+
+DbCacheStats IndexManager::IndexDbs::get_cache_stats() {
+    DbCacheStats stats;
+    DB_MPOOL_STAT* mpool_stat = NULL;
+    if (env_open && env.memp_stat(&mpool_stat, NULL, 0) == 0) {
+        stats.cache_hits = mpool_stat->st_cache_hit;
+        stats.cache_misses = mpool_stat->st_cache_miss;
+        free(mpool_stat);
+    }
+    return stats;
+}
+
 SearchResults IndexManager::search_documents(const Query& query, bool matches_only, const set<string>& doc_ids,
                                              const SearchResults& partialResults)
 {
     Collection<ScoreDocPtr> matchesCollection;
     Collection<ScoreDocPtr> externalMatchesCollection;
-    Collection<IndexReaderPtr> subReaders = get_subreaders(query.type, query.case_sensitive);
-    MultiReaderPtr multireader = newLucene<MultiReader>(subReaders, false);
+    // the dbs are taken together with the readers, so that the matches are looked up in the dbs of the same index
+    shared_ptr<IndexDbs> dbs;
+    MultiReaderPtr multireader = open_multireader(query.type, query.case_sensitive, &dbs);
     SearcherPtr searcher = newLucene<IndexSearcher>(multireader);
     if ((!partialResults.partialIndexMatches || partialResults.partialIndexMatches.empty()) && (!partialResults.partialExternalMatches ||
             partialResults.partialExternalMatches.empty())) {
@@ -68,13 +304,22 @@ SearchResults IndexManager::search_documents(const Query& query, bool matches_on
         QueryParserPtr parser = newLucene<QueryParser>(
                 LuceneVersion::LUCENE_30, query.type == QueryType::document ? L"fulltext" : L"sentence", analyzer);
         string query_text = query.get_query_text();
-        if (query_text.empty()) {
+        QueryPtr yearQuery = get_year_query(query.year);
+        if (query_text.empty() && !yearQuery) {
             throw tpc_exception("empty query");
         }
-        String query_str = String(query_text.begin(), query_text.end());
         string joined_lit = boost::algorithm::join(query.literatures, "ED\" OR corpus:\"BG");
-        query_str = L"(corpus:\"BG" +  String(joined_lit.begin(), joined_lit.end()) + L"ED\") AND (" + query_str + L")";
+        String query_str = L"(corpus:\"BG" +  String(joined_lit.begin(), joined_lit.end()) + L"ED\")";
+        if (!query_text.empty()) {
+            query_str += L" AND (" + String(query_text.begin(), query_text.end()) + L")";
+        }
         QueryPtr luceneQuery = parser->parse(query_str);
+        if (yearQuery) {
+            BooleanQueryPtr yearBooleanQuery = newLucene<BooleanQuery>();
+            yearBooleanQuery->add(luceneQuery, BooleanClause::MUST);
+            yearBooleanQuery->add(yearQuery, BooleanClause::MUST);
+            luceneQuery = yearBooleanQuery;
+        }
         String key_query_str;
         TopScoreDocCollectorPtr collector = TopScoreDocCollector::create(MAX_HITS, true);
         if (!doc_ids.empty()) {
@@ -103,14 +348,14 @@ SearchResults IndexManager::search_documents(const Query& query, bool matches_on
     SearchResults externalResults = SearchResults();
     if (!matches_only) {
         if (query.type == QueryType::document) {
-            result = read_documents_summaries(matchesCollection, query.sort_by_year);
+            result = read_documents_summaries(matchesCollection, query.sort_by_year, dbs);
             if (has_external_index() && externalMatchesCollection) {
                 externalResults = externalIndexManager->read_documents_summaries(externalMatchesCollection,
                                                                                 query.sort_by_year);
                 result.update(externalResults);
             }
         } else if (query.type == QueryType::sentence) {
-            result = read_sentences_summaries(matchesCollection, query.sort_by_year);
+            result = read_sentences_summaries(matchesCollection, query.sort_by_year, dbs);
             result.query = query;
             result.total_num_sentences = matchesCollection.size();
             if (has_external_index() && externalMatchesCollection) {
@@ -138,6 +383,66 @@ SearchResults IndexManager::search_documents(const Query& query, bool matches_on
     return result;
 }
 
+vector<vector<MatchRange>> IndexManager::get_match_ranges(const Query& query, const vector<int>& lucene_internal_ids)
+{
+    String text_field = query.type == QueryType::document ? L"fulltext" : L"sentence";
+    string query_text = query.get_query_text();
+    if (query_text.empty()) {
+        throw tpc_exception("empty query");
+    }
+    AnalyzerPtr analyzer;
+    if (query.case_sensitive) {
+        analyzer = newLucene<CaseSensitiveAnalyzer>(LuceneVersion::LUCENE_30);
+    } else {
+        analyzer = newLucene<StandardAnalyzer>(LuceneVersion::LUCENE_30);
+    }
+    QueryParserPtr parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, text_field, analyzer);
+    // multi-term queries are rewritten into boolean queries of the matching terms so that their terms can be
+    // extracted
+    parser->setMultiTermRewriteMethod(MultiTermQuery::SCORING_BOOLEAN_QUERY_REWRITE());
+    MultiReaderPtr multireader = open_multireader(query.type, query.case_sensitive);
+    SearcherPtr searcher = newLucene<IndexSearcher>(multireader);
+    QueryPtr luceneQuery = searcher->rewrite(parser->parse(String(query_text.begin(), query_text.end())));
+    SetTerm query_terms = SetTerm::newInstance();
+    luceneQuery->extractTerms(query_terms);
+    vector<vector<MatchRange>> result;
+    result.reserve(lucene_internal_ids.size());
+    for (int lucene_id : lucene_internal_ids) {
+        vector<MatchRange> ranges;
+        TermPositionVectorPtr term_vector = boost::dynamic_pointer_cast<TermPositionVector>(
+                multireader->getTermFreqVector(lucene_id, text_field));
+        if (term_vector) {
+            for (const TermPtr& term : query_terms) {
+                if (term->field() != text_field) {
+                    continue;
+                }
+                int32_t term_idx = term_vector->indexOf(term->text());
+                if (term_idx < 0) {
+                    continue;
+                }
+                Collection<TermVectorOffsetInfoPtr> offsets = term_vector->getOffsets(term_idx);
+                if (!offsets) {
+                    continue;
+                }
+                string term_text = StringUtils::toUTF8(term->text());
+                for (const TermVectorOffsetInfoPtr& offset : offsets) {
+                    MatchRange range;
+                    range.begin = offset->getStartOffset();
+                    range.end = offset->getEndOffset();
+                    range.term = term_text;
+                    ranges.push_back(range);
+                }
+            }
+            sort(ranges.begin(), ranges.end(), [](const MatchRange& a, const MatchRange& b) {
+                return a.begin < b.begin || (a.begin == b.begin && a.end < b.end);
+            });
+        }
+        result.push_back(ranges);
+    }
+    multireader->close();
+    return result;
+}
+
 set<String> IndexManager::compose_field_set(const set<string> &include_fields, const set<string> &exclude_fields,
                                             const set<string> &required_fields)
 {
@@ -151,9 +456,36 @@ set<String> IndexManager::compose_field_set(const set<string> &include_fields, c
     for (const auto& f : required_fields) {
         fields.insert(String(f.begin(), f.end()));
     }
+    // the categories of the sentences are stored in binary format in new indexes
+    if (fields.find(L"sentence_cat_compressed") != fields.end()) {
+        fields.insert(L"sentence_cat_binary");
+    }
     return fields;
 }
 
+QueryPtr IndexManager::get_year_query(const string& year)
+{
+    if (boost::algorithm::trim_copy(year).empty()) {
+        return QueryPtr();
+    }
+    smatch match;
+    if (!regex_match(year, match, regex("\\s*([0-9]{4})\\s*(?:(?:-|TO)\\s*([0-9]{4})\\s*)?"))) {
+        throw tpc_exception("invalid year in query, expected a year or a range of years");
+    }
+    int from = stoi(match[1].str());
+    int to = match[2].matched ? stoi(match[2].str()) : from;
+    QueryPtr range_query = NumericRangeQuery::newIntRange(L"year", from, to, true, true);
+    if (match[2].matched) {
+        return range_query;
+    }
+    // indexes created before the introduction of the numeric year field contain the year as analyzed text
+    BooleanQueryPtr year_query = newLucene<BooleanQuery>();
+    year_query->add(range_query, BooleanClause::SHOULD);
+    year_query->add(newLucene<TermQuery>(newLucene<Term>(L"year", StringUtils::toString(match[1].str().c_str()))),
+                    BooleanClause::SHOULD);
+    return year_query;
+}
+
 Collection<IndexReaderPtr> IndexManager::get_subreaders(QueryType type, bool case_sensitive)
 {
 
@@ -184,45 +516,71 @@ Collection<IndexReaderPtr> IndexManager::get_subreaders(QueryType type, bool cas
     return subReaders;
 }
 
+MultiReaderPtr IndexManager::open_multireader(QueryType type, bool case_sensitive, shared_ptr<IndexDbs>* dbs)
+{
+    lock_guard<mutex> lock(state_mutex);
+    if (dbs != nullptr) {
+        if (!index_dbs) {
+            index_dbs = make_shared<IndexDbs>(index_dir + "/db");
+        }
+        *dbs = index_dbs;
+    }
+    // the multireader takes a reference to the subreaders, which are closed by switch_to_index only once all the
+    // multireaders using them have been closed
+    return newLucene<MultiReader>(get_subreaders(type, case_sensitive), false);
+}
+
+shared_ptr<IndexManager::IndexDbs> IndexManager::get_index_dbs()
+{
+    lock_guard<mutex> lock(state_mutex);
+    if (!index_dbs) {
+        index_dbs = make_shared<IndexDbs>(index_dir + "/db");
+    }
+    return index_dbs;
+}
+
+void IndexManager::reset_index_dbs()
+{
+    lock_guard<mutex> lock(state_mutex);
+    index_dbs.reset();
+}
+
+DbCacheStats IndexManager::get_db_cache_stats()
+{
+    lock_guard<mutex> lock(state_mutex);
+    return index_dbs ? index_dbs->get_cache_stats() : DbCacheStats();
+}
+
+string IndexManager::get_index_dir() const
+{
+    lock_guard<mutex> lock(state_mutex);
+    return index_dir;
+}
+
+shared_ptr<const CategoryDictionary> IndexManager::get_current_category_dictionary() const
+{
+    lock_guard<mutex> lock(state_mutex);
+    return category_dictionary;
+}
+
 SearchResults IndexManager::read_documents_summaries(const Collection<ScoreDocPtr> &matches_collection,
-                                                     bool sort_by_year)
+                                                     bool sort_by_year, shared_ptr<IndexDbs> dbs)
 {
     SearchResults result = SearchResults();
-    DbEnv env(DB_CXX_NO_EXCEPTIONS);
-    Db* pdb = NULL;
-    try {
-        env.set_error_stream(&cerr);
-        env.open((index_dir + "/db").c_str(), DB_INIT_MPOOL, 0);
-        typedef dbstl::db_map<int, string> HugeMap;
-        HugeMap huge_map_year;
-        if (sort_by_year) {
-            pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
-            pdb->open(NULL, "doc_map.db", NULL, DB_BTREE, DB_RDONLY, 0);
-            huge_map_year = HugeMap(pdb, &env);
-        }
-        for (const auto& docresult : matches_collection) {
-            DocumentSummary document;
-            if (external) {
-                document.documentType = DocumentType::external;
-            }
-            document.lucene_internal_id = docresult->doc;
-            document.score = docresult->score;
-            if (sort_by_year) {
-                document.year = huge_map_year[docresult->doc];
-            }
-            result.hit_documents.push_back(document);
+    if (sort_by_year && !dbs) {
+        dbs = get_index_dbs();
+    }
+    for (const auto& docresult : matches_collection) {
+        DocumentSummary document;
+        if (external) {
+            document.documentType = DocumentType::external;
         }
-        if (pdb != NULL) {
-            pdb->close(0);
-            delete pdb;
+        document.lucene_internal_id = docresult->doc;
+        document.score = docresult->score;
+        if (sort_by_year) {
+            IndexDbs::get_value(dbs->doc_map, docresult->doc, document.year);
         }
-        env.close(0);
-    } catch (DbException& e) {
-        cerr << "DbException: " << e.what() << endl;
-        exit(EXIT_FAILURE);
-    } catch (std::exception& e) {
-        cerr << e.what() << endl;
-        exit(EXIT_FAILURE);
+        result.hit_documents.push_back(document);
     }
     // check and update max and min scores for result
     for (const DocumentSummary& doc : result.hit_documents) {
@@ -236,52 +594,39 @@ SearchResults IndexManager::read_documents_summaries(const Collection<ScoreDocPt
 }
 
 SearchResults IndexManager::read_sentences_summaries(const Collection<ScoreDocPtr> &matches_collection,
-                                                     bool sort_by_year)
+                                                     bool sort_by_year, shared_ptr<IndexDbs> dbs)
 {
     SearchResults result = SearchResults();
     unordered_map<string, DocumentSummary> doc_map;
-    DbEnv env(DB_CXX_NO_EXCEPTIONS);
-    Db* pdb;
-    try {
-        env.set_error_stream(&cerr);
-        env.open((index_dir + "/db").c_str(), DB_INIT_MPOOL, 0);
-        pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
-        pdb->open(NULL, "sent_map.db", NULL, DB_BTREE, DB_RDONLY, 0);
-        typedef dbstl::db_map<int, string> HugeMap;
-        HugeMap huge_map(pdb, &env);
-        for (const auto& scoredoc : matches_collection) {
-            vector<string> id_year_arr;
-            string line = huge_map[scoredoc->doc];
-            boost::algorithm::split(id_year_arr, line, boost::is_any_of("|"));
-            if (doc_map.find(id_year_arr[0]) == doc_map.end()) {
-                DocumentSummary document;
-                if (external) {
-                    document.documentType = DocumentType::external;
-                }
-                document.identifier = id_year_arr[0];
-                if (sort_by_year) {
-                    document.year = id_year_arr[1];
-                }
-                document.score = 0;
-                doc_map.insert({id_year_arr[0], document});
+    if (!dbs) {
+        dbs = get_index_dbs();
+    }
+    if (dbs->sent_map == nullptr) {
+        cerr << "sentence db not found in " << get_index_dir() << "/db" << endl;
+        exit(EXIT_FAILURE);
+    }
+    for (const auto& scoredoc : matches_collection) {
+        vector<string> id_year_arr;
+        string line;
+        IndexDbs::get_value(dbs->sent_map, scoredoc->doc, line);
+        boost::algorithm::split(id_year_arr, line, boost::is_any_of("|"));
+        if (doc_map.find(id_year_arr[0]) == doc_map.end()) {
+            DocumentSummary document;
+            if (external) {
+                document.documentType = DocumentType::external;
             }
-            doc_map[id_year_arr[0]].score += scoredoc->score;
-            SentenceSummary sentence;
-            sentence.lucene_internal_id = scoredoc->doc;
-            sentence.score = scoredoc->score;
-            doc_map[id_year_arr[0]].matching_sentences.push_back(sentence);
-        }
-        if (pdb != NULL) {
-            pdb->close(0);
-            delete pdb;
+            document.identifier = id_year_arr[0];
+            if (sort_by_year && id_year_arr.size() > 1) {
+                document.year = id_year_arr[1];
+            }
+            document.score = 0;
+            doc_map.insert({id_year_arr[0], document});
         }
-        env.close(0);
-    } catch (DbException& e) {
-        cerr << "DbException: " << e.what() << endl;
-        exit(EXIT_FAILURE);
-    } catch (std::exception& e) {
-        cerr << e.what() << endl;
-        exit(EXIT_FAILURE);
+        doc_map[id_year_arr[0]].score += scoredoc->score;
+        SentenceSummary sentence;
+        sentence.lucene_internal_id = scoredoc->doc;
+        sentence.score = scoredoc->score;
+        doc_map[id_year_arr[0]].matching_sentences.push_back(sentence);
     }
     std::transform(doc_map.begin(), doc_map.end(), std::back_inserter(result.hit_documents),
                    boost::bind(&map<string, DocumentSummary>::value_type::second, _1));
@@ -319,8 +664,7 @@ vector<DocumentDetails> IndexManager::get_documents_details(const vector<Documen
     set<String> doc_f = compose_field_set(include_doc_fields, exclude_doc_fields, {"year", "doc_id"});
     FieldSelectorPtr doc_fsel = newLucene<LazySelector>(doc_f);
     AnalyzerPtr analyzer = newLucene<KeywordAnalyzer>();
-    Collection<IndexReaderPtr> docSubReaders = get_subreaders(QueryType::document);
-    MultiReaderPtr docMultireader = newLucene<MultiReader>(docSubReaders, false);
+    MultiReaderPtr docMultireader = open_multireader(QueryType::document);
     QueryParserPtr docParser = newLucene<QueryParser>(LuceneVersion::LUCENE_30,
                                                       String(DOCUMENT_INDEXNAME.begin(), DOCUMENT_INDEXNAME.end()),
                                                       analyzer);
@@ -330,14 +674,12 @@ vector<DocumentDetails> IndexManager::get_documents_details(const vector<Documen
     set<String> all_sent_f;
     FieldSelectorPtr all_sent_fsel;
     SearcherPtr sent_searcher;
-    Collection<IndexReaderPtr> sentSubReaders;
     MultiReaderPtr sentMultireader;
     QueryParserPtr sentParser;
     if (include_sentences) {
-        sent_f = compose_field_set(include_match_sentences_fields, exclude_match_sentences_fields);
+        sent_f = compose_field_set(include_match_sentences_fields, exclude_match_sentences_fields, {"sentence_id"});
         sent_fsel = newLucene<LazySelector>(sent_f);
-        sentSubReaders = get_subreaders(QueryType::sentence);
-        sentMultireader = newLucene<MultiReader>(sentSubReaders, false);
+        sentMultireader = open_multireader(QueryType::sentence);
         sentParser = newLucene<QueryParser>(LuceneVersion::LUCENE_30,
                                             String(SENTENCE_INDEXNAME.begin(), SENTENCE_INDEXNAME.end()),
                                             analyzer);
@@ -359,20 +701,20 @@ vector<DocumentDetails> IndexManager::get_documents_details(const vector<Documen
                 update_match_sentences_details_for_document(doc_summaries_map[to_string(docDetails.lucene_internal_id)],
                                                             docDetails, sentParser,
                                                             sent_searcher, sent_fsel, sent_f, true,
-                                                            sentMultireader);
+                                                            sentMultireader, searcher);
             } else {
                 update_match_sentences_details_for_document(doc_summaries_map[docDetails.identifier],
                                                             docDetails, sentParser,
                                                             sent_searcher, sent_fsel, sent_f, true,
-                                                            sentMultireader);
+                                                            sentMultireader, searcher);
             }
         }
     }
     if (include_all_sentences) {
-        all_sent_f = compose_field_set(include_all_sentences_fields, exclude_all_sentences_fields);
+        all_sent_f = compose_field_set(include_all_sentences_fields, exclude_all_sentences_fields, {"sentence_id"});
         all_sent_fsel = newLucene<LazySelector>(all_sent_f);
         for (DocumentDetails &docDetails : results) {
-            update_all_sentences_details_for_document(docDetails, all_sent_fsel, all_sent_f);
+            update_all_sentences_details_for_document(docDetails, all_sent_fsel, all_sent_f, searcher);
         }
     }
     docMultireader->close();
@@ -539,34 +881,20 @@ void IndexManager::update_match_sentences_details_for_document(const DocumentSum
                                                                QueryParserPtr sent_parser,
                                                                SearcherPtr searcher,
                                                                FieldSelectorPtr fsel, const set<String> &fields,
-                                                               bool use_lucene_internal_ids, MultiReaderPtr sent_reader)
+                                                               bool use_lucene_internal_ids, MultiReaderPtr sent_reader,
+                                                               SearcherPtr doc_searcher)
 {
     vector<string> sentencesIds;
     map<int, double> sentScoreMap;
+    // in sentence block mode the text of all the matching sentences is read from a single block
+    shared_ptr<SentenceBlock> sentenceBlock;
     if (use_lucene_internal_ids) {
         for (const SentenceSummary &sent : doc_summary.matching_sentences) {
             SentenceDetails sentenceDetails = SentenceDetails();
+            DocumentPtr sentPtr = sent_reader->document(sent.lucene_internal_id, fsel);
             for (const auto &f : fields) {
-                if (f == L"sentence_id") {
-                    sentenceDetails.sentence_id = StringUtils::toInt(
-                            sent_reader->document(sent.lucene_internal_id, fsel)->get(L"sentence_id"));
-                } else if (f == L"begin") {
-                    sentenceDetails.doc_position_begin = StringUtils::toInt(
-                            sent_reader->document(sent.lucene_internal_id, fsel)->get(L"begin"));
-                } else if (f == L"end") {
-                    sentenceDetails.doc_position_end = StringUtils::toInt(sent_reader->document(
-                            sent.lucene_internal_id, fsel)->get(L"end"));
-                } else if (f == L"sentence_compressed") {
-                    String sentence = CompressionTools::decompressString(
-                            sent_reader->document(sent.lucene_internal_id, fsel)->getBinaryValue(
-                                    L"sentence_compressed"));
-                    sentenceDetails.sentence_text = string(sentence.begin(), sentence.end());
-                } else if (f == L"sentence_cat_compressed") {
-                    String sentence_cat = CompressionTools::decompressString(
-                            sent_reader->document(sent.lucene_internal_id, fsel)->getBinaryValue(
-                                    L"sentence_cat_compressed"));
-                    sentenceDetails.categories_string = string(sentence_cat.begin(), sentence_cat.end());
-                }
+                update_sentence_details(sentenceDetails, f, sentPtr, doc_details.identifier, doc_searcher,
+                                        sentenceBlock);
             }
             sentenceDetails.score = sent.score;
             doc_details.sentences_details.push_back(sentenceDetails);
@@ -599,24 +927,8 @@ void IndexManager::update_match_sentences_details_for_document(const DocumentSum
                 SentenceDetails sentenceDetails = SentenceDetails();
                 DocumentPtr sentPtr = searcher->doc(sentscoredoc->doc, fsel);
                 for (const auto &f : fields) {
-                    if (f == L"sentence_id") {
-                        sentenceDetails.sentence_id = StringUtils::toInt(
-                                sentPtr->get(StringUtils::toString("sentence_id")));
-                    } else if (f == L"begin") {
-                        sentenceDetails.doc_position_begin = StringUtils::toInt(
-                                sentPtr->get(StringUtils::toString("begin")));
-                    } else if (f == L"end") {
-                        sentenceDetails.doc_position_end = StringUtils::toInt(sentPtr->get(
-                                StringUtils::toString("end")));
-                    } else if (f == L"sentence_compressed") {
-                        String sentence = CompressionTools::decompressString(
-                                sentPtr->getBinaryValue(StringUtils::toString("sentence_compressed")));
-                        sentenceDetails.sentence_text = string(sentence.begin(), sentence.end());
-                    } else if (f == L"sentence_cat_compressed") {
-                        String sentence_cat = CompressionTools::decompressString(
-                                sentPtr->getBinaryValue(StringUtils::toString("sentence_cat_compressed")));
-                        sentenceDetails.categories_string = string(sentence_cat.begin(), sentence_cat.end());
-                    }
+                    update_sentence_details(sentenceDetails, f, sentPtr, doc_details.identifier, doc_searcher,
+                                        sentenceBlock);
                 }
                 sentenceDetails.score = sentScoreMap[sentenceDetails.sentence_id];
                 doc_details.sentences_details.push_back(sentenceDetails);
@@ -629,10 +941,12 @@ void IndexManager::update_match_sentences_details_for_document(const DocumentSum
 
 void IndexManager::update_all_sentences_details_for_document(DocumentDetails &doc_details,
                                                              FieldSelectorPtr fsel,
-                                                             const set<String> &fields)
+                                                             const set<String> &fields,
+                                                             SearcherPtr doc_searcher)
 {
-    Collection<IndexReaderPtr> subreaders = get_subreaders(QueryType::sentence, false);
-    MultiReaderPtr multireader = newLucene<MultiReader>(subreaders, false);
+    // in sentence block mode the text of all the sentences is read from a single block
+    shared_ptr<SentenceBlock> sentenceBlock;
+    MultiReaderPtr multireader = open_multireader(QueryType::sentence, false);
     AnalyzerPtr analyzer = newLucene<KeywordAnalyzer>();
     QueryParserPtr parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30,
                                                    String(SENTENCE_INDEXNAME.begin(), SENTENCE_INDEXNAME.end()),
@@ -647,215 +961,1056 @@ void IndexManager::update_all_sentences_details_for_document(DocumentDetails &do
         SentenceDetails sentenceDetails = SentenceDetails();
         DocumentPtr sentPtr = searcher->doc(sentscoredoc->doc, fsel);
         for (const auto &f : fields) {
-            if (f == L"sentence_id") {
-                sentenceDetails.sentence_id = StringUtils::toInt(
-                        sentPtr->get(StringUtils::toString("sentence_id")));
-            } else if (f == L"begin") {
-                sentenceDetails.doc_position_begin = StringUtils::toInt(
-                        sentPtr->get(StringUtils::toString("begin")));
-            } else if (f == L"end") {
-                sentenceDetails.doc_position_end = StringUtils::toInt(sentPtr->get(
-                        StringUtils::toString("end")));
-            } else if (f == L"sentence_compressed") {
-                String sentence = CompressionTools::decompressString(
-                        sentPtr->getBinaryValue(StringUtils::toString("sentence_compressed")));
-                sentenceDetails.sentence_text = string(sentence.begin(), sentence.end());
-            } else if (f == L"sentence_cat_compressed") {
-                String sentence_cat = CompressionTools::decompressString(
-                        sentPtr->getBinaryValue(StringUtils::toString("sentence_cat_compressed")));
-                sentenceDetails.categories_string = string(sentence_cat.begin(), sentence_cat.end());
-            }
+            update_sentence_details(sentenceDetails, f, sentPtr, doc_details.identifier, doc_searcher,
+                                        sentenceBlock);
         }
         doc_details.all_sentences_details.push_back(sentenceDetails);
     }
     multireader->close();
 }
 
+void IndexManager::update_sentence_details(SentenceDetails& sentence_details, const String& field,
+                                           const DocumentPtr& sent_doc, const string& doc_id,
+                                           const SearcherPtr& doc_searcher,
+                                           shared_ptr<SentenceBlock>& sentence_block)
+{
+    auto get_stored_sentence = [&]() {
+        if (!sentence_block) {
+            sentence_block = make_shared<SentenceBlock>();
+            read_sentence_block(doc_id, doc_searcher, *sentence_block);
+        }
+        return sentence_block->get_sentence(StringUtils::toInt(sent_doc->get(L"sentence_id")));
+    };
+    if (field == L"sentence_id") {
+        sentence_details.sentence_id = StringUtils::toInt(sent_doc->get(L"sentence_id"));
+    } else if (field == L"begin") {
+        sentence_details.doc_position_begin = StringUtils::toInt(sent_doc->get(L"begin"));
+    } else if (field == L"end") {
+        sentence_details.doc_position_end = StringUtils::toInt(sent_doc->get(L"end"));
+    } else if (field == L"sentence_compressed") {
+        String sentence;
+        ByteArray sentence_compressed = sent_doc->getBinaryValue(L"sentence_compressed");
+        if (sentence_compressed) {
+            sentence = CompressionTools::decompressString(sentence_compressed);
+        } else if (const StoredSentence* stored_sentence = get_stored_sentence()) {
+            sentence = StringUtils::toUnicode(stored_sentence->text);
+        }
+        sentence_details.sentence_text = string(sentence.begin(), sentence.end());
+    } else if (field == L"sentence_cat_compressed") {
+        if (sent_doc->getBinaryValue(L"sentence_cat_binary") || sent_doc->getBinaryValue(L"sentence_cat_compressed")) {
+            sentence_details.categories_string = get_sentence_categories_string(sent_doc,
+                                                                                *get_current_category_dictionary());
+        } else if (const StoredSentence* stored_sentence = get_stored_sentence()) {
+            CategoryPayload cat_payload;
+            try {
+                cat_payload.decode(stored_sentence->categories_payload.data(),
+                                   stored_sentence->categories_payload.size());
+                sentence_details.categories_string = cat_payload.get_categories_string(
+                        *get_current_category_dictionary());
+            } catch (std::runtime_error& e) {
+                cerr << e.what() << endl;
+            }
+        }
+    }
+}
+
+bool IndexManager::read_sentence_block(const string& doc_id, const SearcherPtr& doc_searcher,
+                                       SentenceBlock& sentence_block)
+{
+    sentence_block.clear();
+    TopDocsPtr topDocs = doc_searcher->search(newLucene<TermQuery>(newLucene<Term>(
+            L"doc_id", String(doc_id.begin(), doc_id.end()))), 1);
+    bool found = false;
+    if (topDocs->totalHits > 0) {
+        FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"sentences_block"}));
+        ByteArray block_compressed = doc_searcher->doc(topDocs->scoreDocs[0]->doc, fsel)->getBinaryValue(
+                L"sentences_block");
+        if (block_compressed) {
+            ByteArray block = CompressionTools::decompress(block_compressed);
+            try {
+                sentence_block.decode(reinterpret_cast<const char*>(block.get()), block.size());
+                found = true;
+            } catch (std::runtime_error& e) {
+                cerr << e.what() << endl;
+            }
+        }
+    }
+    return found;
+}
+
 void IndexManager::create_index_from_existing_cas_dir(const string &input_cas_dir, const set<string>& file_list,
-                                                      int max_num_papers_per_subindex)
+                                                      int max_num_papers_per_subindex, bool resume)
 {
-    path input_cas_dir_path(input_cas_dir);
     if (!boost::filesystem::exists(index_dir + "/db")) {
         boost::filesystem::create_directory(index_dir + "/db");
     }
+    update_category_dictionary();
+    map<string, ManifestEntry> manifest;
+    // files already committed to the index, by filepath
+    map<string, pair<string, string>> indexed_files;
+    int counter_cas_files(0);
+    if (resume) {
+        manifest = read_manifest();
+        indexed_files = get_indexed_files();
+        // files committed by a run that died before recording them in the manifest are counted as well
+        set<string> recorded_filepaths;
+        for (const auto& entry : manifest) {
+            recorded_filepaths.insert(boost::replace_all_copy(entry.first, ".gz", ""));
+        }
+        counter_cas_files = manifest.size();
+        for (const auto& indexed_file : indexed_files) {
+            if (recorded_filepaths.find(indexed_file.first) == recorded_filepaths.end()) {
+                ++counter_cas_files;
+            }
+        }
+    } else {
+        boost::filesystem::remove(index_dir + "/" + INDEX_MANIFEST_FILENAME);
+        boost::filesystem::remove(index_dir + "/db/" + CONTENT_HASH_DB_NAME);
+    }
+    map<string, string> content_hashes = load_content_hashes_from_db();
+    // content hashes of the files committed by a run that died before recording them in the manifest
+    map<string, string> recovered_hashes;
+    if (resume) {
+        for (const auto& content_hash : content_hashes) {
+            if (manifest.find(content_hash.second) == manifest.end()) {
+                recovered_hashes[boost::replace_all_copy(content_hash.second, ".gz", "")] = content_hash.first;
+            }
+        }
+    }
     string out_dir = index_dir + "/" + SUBINDEX_NAME;
     string subindex_dir;
-    int counter_cas_files(0);
-    bool first_paper;
+    int subindex_num(-1);
     TmpConf tmp_conf = TmpConf();
-    recursive_directory_iterator it_end;
-    for (recursive_directory_iterator dir_it(input_cas_dir_path); dir_it != it_end; ++dir_it) {
-        if (counter_cas_files % max_num_papers_per_subindex == 0 && first_paper == false) {
-            // create new subindex
-            subindex_dir = out_dir + "_" + to_string(counter_cas_files / max_num_papers_per_subindex);
-            tmp_conf = write_tmp_conf_files(subindex_dir);
-            first_paper = true;
-            if (!exists(tmp_conf.new_index_flag)) {
-                std::ofstream f_newindexflag(tmp_conf.new_index_flag.c_str());
-                f_newindexflag << "newindexflag";
-                f_newindexflag.close();
+    // the input tree is enumerated in background threads while the files found so far are indexed. If indexing
+    // throws, the walker is stopped by its destructor, which releases the threads blocked on the full queue
+    tpc::BoundedQueue<vector<tpc::FileEntry>> file_batches(max(size_t(1), pipeline_options.queue_size));
+    tpc::DirectoryWalker walker({".tpcas.gz"}, pipeline_options.max_walk_depth, pipeline_options.num_walk_threads,
+                                pipeline_options.walk_batch_size);
+    walker.start(input_cas_dir, file_batches);
+    vector<string> files_to_index;
+    vector<tpc::FileEntry> file_batch;
+    bool walk_running = true;
+    while (walk_running) {
+        walk_running = file_batches.pop(file_batch);
+        vector<ManifestEntry> recovered_entries;
+        for (const tpc::FileEntry& file_entry : file_batch) {
+            path file_path(file_entry.path);
+            string file_id = file_path.parent_path().parent_path().filename().string()
+                             + "/" + file_path.parent_path().filename().string();
+            if (!file_list.empty() && file_list.find(file_id) == file_list.end()) {
+                continue;
             }
-            create_subindex_dir_structure(subindex_dir);
-        }
-        string file_id = dir_it->path().parent_path().parent_path().filename().string()
-                         + "/" + dir_it->path().parent_path().filename().string();
-        if (is_regular_file(dir_it->status()) && boost::algorithm::ends_with(
-                dir_it->path().filename().string(), ".tpcas.gz") && (file_list.empty() ||
-                file_list.find(file_id) != file_list.end())) {
-            std::string filepath(dir_it->path().string());
-            if (!process_single_file(filepath, first_paper, tmp_conf)) {
+            string identifier = get_file_identifier(file_entry.path);
+            auto manifest_it = manifest.find(identifier);
+            if (manifest_it != manifest.end()) {
+                if (file_entry.size != manifest_it->second.size || file_entry.mtime != manifest_it->second.mtime) {
+                    // the old version is removed from the index and the registry, and the file is indexed again
+                    cout << "file changed since it was indexed, reindexing: " << file_entry.path << endl;
+                    auto hash_it = content_hashes.find(manifest_it->second.content_hash);
+                    if (hash_it != content_hashes.end() && hash_it->second == identifier) {
+                        content_hashes.erase(hash_it);
+                    }
+                    remove_file_from_index(identifier);
+                    // deletions are committed when the readers are closed
+                    close();
+                    readers_map.clear();
+                    // the file is counted again when it is indexed
+                    manifest.erase(manifest_it);
+                    --counter_cas_files;
+                    files_to_index.push_back(file_entry.path);
+                }
+                continue;
+            }
+            string filepath = boost::replace_all_copy(identifier, ".gz", "");
+            auto indexed_it = indexed_files.find(filepath);
+            if (indexed_it != indexed_files.end()) {
+                recovered_entries.push_back(create_manifest_entry(file_entry.path, indexed_it->second.first,
+                                                                  indexed_it->second.second,
+                                                                  recovered_hashes[filepath]));
                 continue;
             }
-            ++counter_cas_files;
-            cout << "total number of cas files added: "
-                 << to_string(counter_cas_files) << endl;
+            files_to_index.push_back(file_entry.path);
+        }
+        write_manifest_entries(recovered_entries, manifest);
+        file_batch.clear();
+        // index the full checkpoints, and the remaining files once the walk is over
+        while (!files_to_index.empty()) {
+            size_t num_files_in_checkpoint = min(INDEX_CHECKPOINT_NUM_FILES, max_num_papers_per_subindex -
+                                                 counter_cas_files % max_num_papers_per_subindex);
+            if (walk_running && files_to_index.size() < num_files_in_checkpoint) {
+                break;
+            }
+            num_files_in_checkpoint = min(num_files_in_checkpoint, files_to_index.size());
+            if (counter_cas_files / max_num_papers_per_subindex != subindex_num) {
+                if (!tmp_conf.tmp_dir.empty()) {
+                    boost::filesystem::remove_all(tmp_conf.tmp_dir);
+                }
+                subindex_num = counter_cas_files / max_num_papers_per_subindex;
+                subindex_dir = out_dir + "_" + to_string(subindex_num);
+                // files removed on resume can leave an existing subindex at the start of a new count
+                bool new_subindex = !exists(subindex_dir);
+                tmp_conf = create_tmp_conf(subindex_dir, new_subindex);
+                if (new_subindex) {
+                    create_subindex_dir_structure(subindex_dir);
+                }
+            }
+            // each checkpoint is committed to the subindex before being recorded in the manifest
+            vector<string> checkpoint_files(files_to_index.begin(), files_to_index.begin() + num_files_in_checkpoint);
+            files_to_index.erase(files_to_index.begin(), files_to_index.begin() + num_files_in_checkpoint);
+            vector<pair<string, string>> checkpoint_indexed_files = add_cas_files_to_index(checkpoint_files,
+                                                                                           tmp_conf,
+                                                                                           content_hashes);
+            append_to_manifest(checkpoint_indexed_files, subindex_dir, manifest);
+            counter_cas_files += checkpoint_indexed_files.size();
+            cout << "total number of cas files added: " << to_string(counter_cas_files) << endl;
         }
     }
+    walker.join();
+    if (!tmp_conf.tmp_dir.empty()) {
+        boost::filesystem::remove_all(tmp_conf.tmp_dir);
+    }
+    readers_map.clear();
+    if (writer_options.max_num_segments > 0) {
+        merge_subindex_segments(writer_options.max_num_segments);
+    }
+    for (const auto& num_segments : get_num_segments_per_subindex()) {
+        cout << num_segments.first << ": " << num_segments.second << " segments" << endl;
+    }
     update_corpus_counter();
     save_corpus_counter();
 }
 
-void IndexManager::create_subindex_dir_structure(const string &index_path) {
-    if (!exists(index_path)) {
-        create_directories(index_path);
-        create_directories(index_path + "/fulltext");
-        create_directories(index_path + "/fulltext_cs");
-        create_directories(index_path + "/sentence");
-        create_directories(index_path + "/sentence_cs");
+void IndexManager::merge_subindex_segments(int max_num_segments) {
+    readers_map.clear();
+    for (directory_iterator dir_it(index_dir); dir_it != directory_iterator(); ++dir_it) {
+        if (!boost::algorithm::starts_with(dir_it->path().filename().string(), SUBINDEX_NAME + "_")) {
+            continue;
+        }
+        for (const string& index_type : INDEX_TYPES) {
+            string index_path = dir_it->path().string() + "/" + index_type;
+            FSDirectoryPtr fs_dir = FSDirectory::open(String(index_path.begin(), index_path.end()));
+            if (!exists(index_path) || !IndexReader::indexExists(fs_dir)) {
+                continue;
+            }
+            AnalyzerPtr analyzer;
+            if (index_type == DOCUMENT_INDEXNAME_CS || index_type == SENTENCE_INDEXNAME_CS) {
+                analyzer = newLucene<CaseSensitiveAnalyzer>(LuceneVersion::LUCENE_30);
+            } else {
+                analyzer = newLucene<StandardAnalyzer>(LuceneVersion::LUCENE_30);
+            }
+            IndexWriterPtr writer = newLucene<IndexWriter>(fs_dir, analyzer, false,
+                                                           IndexWriter::MaxFieldLengthUNLIMITED);
+            configure_index_writer(writer, true);
+            writer->optimize(max_num_segments);
+            writer->close();
+        }
     }
 }
 
-TmpConf IndexManager::write_tmp_conf_files(const string &index_path) {
-    // temp conf files
-    std::string temp_dir;
-    bool dir_created = false;
-    while (!dir_created) {
-        temp_dir = Utils::get_temp_dir_path();
-        dir_created = create_directories(temp_dir);
-    }
-    Utils::write_index_descriptor(index_path, temp_dir + "/Tpcas2SingleIndex.xml", temp_dir);
-    TmpConf tmpConf = TmpConf();
-    tmpConf.index_descriptor = temp_dir + "/Tpcas2SingleIndex.xml";
-    tmpConf.new_index_flag = temp_dir + "/newindexflag";
-    tmpConf.tmp_dir = temp_dir;
-    return tmpConf;
+void IndexManager::configure_index_writer(const IndexWriterPtr& writer, bool use_compound_file) const {
+    writer->setRAMBufferSizeMB(writer_options.ram_buffer_size_mb);
+    LogByteSizeMergePolicyPtr merge_policy = newLucene<LogByteSizeMergePolicy>(writer);
+    merge_policy->setMergeFactor(writer_options.merge_factor);
+    merge_policy->setMaxMergeMB(writer_options.max_merge_mb);
+    merge_policy->setUseCompoundFile(use_compound_file);
+    merge_policy->setUseCompoundDocStore(use_compound_file);
+    writer->setMergePolicy(merge_policy);
 }
 
-int IndexManager::add_cas_file_to_index(const char* file_path, string index_descriptor, string temp_dir_path,
-                                        bool update_db) {
-    std::string gzfile(file_path);
-    string source_file = gzfile;
-    boost::replace_all(source_file, ".tpcas.gz", ".bib");
-    string bib_file = source_file;
-    path source = source_file;
-    string filename = source.filename().string();
-    boost::replace_all(filename, ".tpcas.gz", ".bib");
-    if(gzfile.find(".tpcas") == std::string::npos) {
-        //std::cerr << "No .tpcas file found for file " << source.filename().string() << endl;
-        return 0;
-    }
-    if(!exists(bib_file)) {
-        //std::cerr << "No .bib file found for file " << source.filename().string() << endl;
-        return 0;
-    }
-    string bib_file_temp = temp_dir_path + "/" + filename;
-    path dst  = temp_dir_path + "/" + filename;
-    boost::filesystem::copy_file(source,dst,copy_option::overwrite_if_exists);
-    const char * descriptor = index_descriptor.c_str();
-    string tpcasfile = Utils::decompress_gzip(gzfile, temp_dir_path);
-
-    try {
-        /* Create/link up to a UIMACPP resource manager instance (singleton) */
-        (void) uima::ResourceManager::createInstance("TPCAS2LINDEXAE");
-        uima::ErrorInfo errorInfo;
-        uima::AnalysisEngine * pEngine
-                = uima::Framework::createAnalysisEngine(descriptor, errorInfo);
-        if (errorInfo.getErrorId() != UIMA_ERR_NONE) {
-            std::cerr << std::endl
-                      << "  Error string  : "
-                      << uima::AnalysisEngine::getErrorIdAsCString(errorInfo.getErrorId())
-                      << std::endl
-                      << "  UIMACPP Error info:" << std::endl
-                      << errorInfo << std::endl;
-            exit((int) errorInfo.getErrorId());
-        }
-        uima::TyErrorId utErrorId; // Variable to store UIMACPP return codes
-        /* Get a new CAS */
-        uima::CAS* cas = pEngine->newCAS();
-        if (cas == nullptr) {
-            std::cerr << "pEngine->newCAS() failed." << std::endl;
-            exit(1);
+void IndexManager::reindex_from_stored_fields(const string& output_index_dir,
+                                              const map<string, AnalyzerPtr>& analyzers) {
+    if (!exists(output_index_dir + "/db")) {
+        create_directories(output_index_dir + "/db");
+    }
+    readers_map.clear();
+    for (directory_iterator dir_it(index_dir); dir_it != directory_iterator(); ++dir_it) {
+        string subindex = dir_it->path().filename().string();
+        if (!boost::algorithm::starts_with(subindex, SUBINDEX_NAME + "_")) {
+            continue;
         }
-        /* process input / cas */
-        try {
-            /* initialize from an xmicas */
-            XMLCh* native = XMLString::transcode(tpcasfile.c_str());
-            LocalFileInputSource fileIS(native);
-            XMLString::release(&native);
-            uima::XmiDeserializer::deserialize(fileIS, *cas, true);
-            std::string filename(tpcasfile);
-            string filehash = gettpfnvHash(*cas);
-            /* process the CAS */
-            auto text = getFulltext(*cas);
-            if (text.length() > 0) {
-                ((uima::AnalysisEngine *) pEngine)->process(*cas);
+        cout << "reindexing " << subindex << endl;
+        create_subindex_dir_structure(output_index_dir + "/" + subindex);
+        // bib fields of the documents are indexed but not stored in the sentence indexes
+        map<String, map<String, String>> bib_fields_by_doc_id;
+        // the sentence blocks are stored in the document index of the same subindex
+        IndexReaderPtr block_reader;
+        SearcherPtr block_searcher;
+        string block_index_path = dir_it->path().string() + "/" + DOCUMENT_INDEXNAME;
+        FSDirectoryPtr block_index_dir = FSDirectory::open(String(block_index_path.begin(), block_index_path.end()));
+        if (exists(block_index_path) && IndexReader::indexExists(block_index_dir)) {
+            block_reader = IndexReader::open(block_index_dir, true);
+            block_searcher = newLucene<IndexSearcher>(block_reader);
+        }
+        for (const string& index_type : {DOCUMENT_INDEXNAME, DOCUMENT_INDEXNAME_CS, SENTENCE_INDEXNAME,
+                                         SENTENCE_INDEXNAME_CS}) {
+            string input_path = dir_it->path().string() + "/" + index_type;
+            FSDirectoryPtr input_dir = FSDirectory::open(String(input_path.begin(), input_path.end()));
+            if (!exists(input_path) || !IndexReader::indexExists(input_dir)) {
+                continue;
+            }
+            AnalyzerPtr analyzer;
+            if (analyzers.find(index_type) != analyzers.end()) {
+                analyzer = analyzers.at(index_type);
+            } else if (index_type == DOCUMENT_INDEXNAME_CS || index_type == SENTENCE_INDEXNAME_CS) {
+                analyzer = newLucene<CaseSensitiveAnalyzer>(LuceneVersion::LUCENE_30);
             } else {
-                cout << "Skip file." << endl;
+                analyzer = newLucene<StandardAnalyzer>(LuceneVersion::LUCENE_30);
             }
-        } catch (uima::Exception e) {
-            uima::ErrorInfo errInfo = e.getErrorInfo();
-            std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
-            std::cerr << errInfo << std::endl;
+            // the gap tokens in the categories of the sentences are not indexed
+            if (index_type == SENTENCE_INDEXNAME || index_type == SENTENCE_INDEXNAME_CS) {
+                analyzer = CategoryAnalyzer::wrapSentenceAnalyzer(analyzer, CATEGORY_GAP_TOKEN);
+            }
+            string output_path = output_index_dir + "/" + subindex + "/" + index_type;
+            IndexWriterPtr writer = newLucene<IndexWriter>(
+                    FSDirectory::open(String(output_path.begin(), output_path.end())), analyzer, true,
+                    IndexWriter::MaxFieldLengthUNLIMITED);
+            configure_index_writer(writer, writer_options.use_compound_file);
+            IndexReaderPtr reader = IndexReader::open(input_dir, true);
+            // sentences indexed in block mode are regenerated from the block of their document
+            String block_doc_id;
+            SentenceBlock sentence_block;
+            for (int i = 0; i < reader->maxDoc(); ++i) {
+                if (reader->isDeleted(i)) {
+                    continue;
+                }
+                DocumentPtr stored_doc = reader->document(i);
+                DocumentPtr doc;
+                try {
+                    doc = rebuild_document_from_stored_fields(stored_doc, *category_dictionary,
+                                                              writer_options.store_term_vectors);
+                } catch (std::runtime_error& e) {
+                    cerr << "skipping document " << i << " of " << input_path << ": " << e.what() << endl;
+                    continue;
+                }
+                if (index_type == DOCUMENT_INDEXNAME) {
+                    map<String, String>& bib_fields = bib_fields_by_doc_id[doc->get(L"doc_id")];
+                    for (const String& field_name : SENTENCE_BIB_FIELDS) {
+                        bib_fields[field_name] = doc->get(field_name);
+                    }
+                } else if (index_type == SENTENCE_INDEXNAME || index_type == SENTENCE_INDEXNAME_CS) {
+                    if (!stored_doc->getBinaryValue(L"sentence_compressed") && block_searcher) {
+                        String doc_id = doc->get(L"doc_id");
+                        if (doc_id != block_doc_id) {
+                            read_sentence_block(string(doc_id.begin(), doc_id.end()), block_searcher,
+                                                sentence_block);
+                            block_doc_id = doc_id;
+                        }
+                        const StoredSentence* stored_sentence = sentence_block.get_sentence(
+                                StringUtils::toInt(doc->get(L"sentence_id")));
+                        if (stored_sentence != nullptr) {
+                            try {
+                                add_sentence_fields_from_block(doc, *stored_sentence, *category_dictionary,
+                                                               writer_options.store_term_vectors);
+                            } catch (std::runtime_error& e) {
+                                cerr << "skipping document " << i << " of " << input_path << ": " << e.what()
+                                     << endl;
+                                continue;
+                            }
+                        }
+                    }
+                    auto bib_fields_it = bib_fields_by_doc_id.find(doc->get(L"doc_id"));
+                    if (bib_fields_it != bib_fields_by_doc_id.end()) {
+                        for (const auto& bib_field : bib_fields_it->second) {
+                            doc->add(newLucene<Field>(bib_field.first, bib_field.second, Field::STORE_NO,
+                                                      Field::INDEX_ANALYZED));
+                        }
+                    }
+                }
+                writer->addDocument(doc);
+            }
+            reader->close();
+            writer->commit();
+            writer->close();
         }
-        /* call collectionProcessComplete */
-        utErrorId = pEngine->collectionProcessComplete();
-        /* Free annotator */
-        utErrorId = pEngine->destroy();
-        delete cas;
-        delete pEngine;
-        std::remove(tpcasfile.c_str()); //delete uncompressed temp casfile
-        std::remove(bib_file_temp.c_str());
-
-        readers_map.clear();
-        if (update_db) {
-            string file_id = boost::filesystem::path(file_path).parent_path().parent_path().filename().string() + "/" +
-                             boost::filesystem::path(file_path).parent_path().filename().string() + "/" +
-                             boost::filesystem::path(file_path).filename().string();
-            add_doc_and_sentences_to_bdb(file_id);
+        if (block_reader) {
+            block_reader->close();
         }
-
-        return 1;
-    } catch (uima::Exception e) {
-        std::cerr << "Exception: " << e << std::endl;
-        return 0;
     }
+    // the manifest and the category dictionary of the index are shared by all the subindexes
+    for (const string& index_file : {INDEX_MANIFEST_FILENAME, CATEGORY_DICTIONARY_FILENAME}) {
+        if (exists(index_dir + "/" + index_file)) {
+            copy_file(index_dir + "/" + index_file, output_index_dir + "/" + index_file,
+                      copy_option::overwrite_if_exists);
+        }
+    }
+    if (exists(index_dir + "/db/" + CONTENT_HASH_DB_NAME)) {
+        copy_file(index_dir + "/db/" + CONTENT_HASH_DB_NAME, output_index_dir + "/db/" + CONTENT_HASH_DB_NAME,
+                  copy_option::overwrite_if_exists);
+    }
+    // lucene doc numbers change with the deleted documents, so the dbs and the counters are rebuilt
+    IndexManager output_index_manager(output_index_dir, false, external);
+    output_index_manager.save_all_years_for_documents_to_db();
+    output_index_manager.save_all_doc_ids_for_sentences_to_db();
+    output_index_manager.update_corpus_counter();
+    output_index_manager.save_corpus_counter();
 }
 
-bool IndexManager::process_single_file(const string& filepath, bool& first_paper, const TmpConf& tmp_conf,
-                                       bool update_db) {
-    if (filepath.find(".tpcas.gz") == std::string::npos)
-        return false;
-    cout << "processing cas file: " << filepath << endl;
-    if (first_paper) {
-        if (add_cas_file_to_index(filepath.c_str(), tmp_conf.index_descriptor, tmp_conf.tmp_dir, update_db) == 1) {
-            first_paper = false;
-            boost::filesystem::remove(tmp_conf.new_index_flag);
-        } else {
-            return false;
-        }
-    } else {
-        if (add_cas_file_to_index(filepath.c_str(), tmp_conf.index_descriptor, tmp_conf.tmp_dir, update_db) == 0) {
-            return false;
+string IndexManager::get_sentence_categories_string(const DocumentPtr& sentence_doc,
+                                                    const CategoryDictionary& category_dictionary) {
+    ByteArray cat_payload_bytes = sentence_doc->getBinaryValue(L"sentence_cat_binary");
+    if (!cat_payload_bytes) {
+        // sentences indexed before the introduction of the binary format
+        ByteArray cat_compressed_bytes = sentence_doc->getBinaryValue(L"sentence_cat_compressed");
+        if (!cat_compressed_bytes) {
+            return "";
         }
+        String sentence_cat = CompressionTools::decompressString(cat_compressed_bytes);
+        return string(sentence_cat.begin(), sentence_cat.end());
     }
+    CategoryPayload cat_payload;
+    try {
+        cat_payload.decode(reinterpret_cast<const char*>(cat_payload_bytes.get()), cat_payload_bytes.size());
+        return cat_payload.get_categories_string(category_dictionary);
+    } catch (std::runtime_error& e) {
+        cerr << e.what() << endl;
+        return "";
+    }
+}
+
+DocumentPtr IndexManager::rebuild_document_from_stored_fields(const DocumentPtr& stored_doc,
+                                                              const CategoryDictionary& category_dictionary,
+                                                              bool store_term_vectors) {
+    DocumentPtr doc = newLucene<Document>();
+    for (const FieldablePtr& field : stored_doc->getFields()) {
+        String field_name = field->name();
+        if (field->isBinary()) {
+            ByteArray value = field->getBinaryValue();
+            doc->add(newLucene<Field>(field_name, value, Field::STORE_YES));
+            // indexed fields are regenerated from their stored compressed version
+            String indexed_field_name = boost::algorithm::erase_tail_copy(field_name, String(L"_compressed").size());
+            if (boost::algorithm::ends_with(field_name, L"_compressed") &&
+                INDEXED_FIELDS_FROM_COMPRESSED.find(indexed_field_name) != INDEXED_FIELDS_FROM_COMPRESSED.end()) {
+                bool text_field = indexed_field_name == L"fulltext" || indexed_field_name == L"sentence";
+                doc->add(newLucene<Field>(indexed_field_name, CompressionTools::decompressString(value),
+                                          Field::STORE_NO, Field::INDEX_ANALYZED,
+                                          store_term_vectors && text_field ? Field::TERMVECTOR_WITH_POSITIONS_OFFSETS :
+                                          Field::TERMVECTOR_NO));
+            } else if (field_name == L"sentence_cat_binary") {
+                CategoryPayload cat_payload;
+                cat_payload.decode(reinterpret_cast<const char*>(value.get()), value.size());
+                doc->add(newLucene<Field>(L"sentence_cat", cat_payload.get_indexed_text(category_dictionary),
+                                          Field::STORE_NO, Field::INDEX_ANALYZED));
+            }
+        } else if (field_name == L"doc_id" || field_name == L"sentence_id") {
+            doc->add(newLucene<Field>(field_name, field->stringValue(), Field::STORE_YES,
+                                      Field::INDEX_NOT_ANALYZED_NO_NORMS));
+        } else if (field_name == L"filepath") {
+            doc->add(newLucene<Field>(field_name, field->stringValue(), Field::STORE_YES,
+                                      Field::INDEX_NOT_ANALYZED));
+        } else if (field_name == L"begin" || field_name == L"end") {
+            NumericFieldPtr numeric_field = newLucene<NumericField>(field_name, Field::STORE_YES, true);
+            numeric_field->setIntValue(StringUtils::toInt(field->stringValue()));
+            doc->add(numeric_field);
+        } else if (field_name == L"year") {
+            addYearFields(doc, field->stringValue());
+        } else {
+            doc->add(newLucene<Field>(field_name, field->stringValue(), Field::STORE_YES, Field::INDEX_ANALYZED));
+        }
+    }
+    return doc;
+}
+
+void IndexManager::add_sentence_fields_from_block(const DocumentPtr& doc, const StoredSentence& stored_sentence,
+                                                  const CategoryDictionary& category_dictionary,
+                                                  bool store_term_vectors) {
+    doc->add(newLucene<Field>(L"sentence", StringUtils::toUnicode(stored_sentence.text), Field::STORE_NO,
+                              Field::INDEX_ANALYZED, store_term_vectors ? Field::TERMVECTOR_WITH_POSITIONS_OFFSETS :
+                              Field::TERMVECTOR_NO));
+    CategoryPayload cat_payload;
+    cat_payload.decode(stored_sentence.categories_payload.data(), stored_sentence.categories_payload.size());
+    doc->add(newLucene<Field>(L"sentence_cat", cat_payload.get_indexed_text(category_dictionary), Field::STORE_NO,
+                              Field::INDEX_ANALYZED));
+}
+
+map<string, int> IndexManager::get_num_segments_per_subindex() {
+    map<string, int> num_segments;
+    for (directory_iterator dir_it(index_dir); dir_it != directory_iterator(); ++dir_it) {
+        string subindex = dir_it->path().filename().string();
+        if (!boost::algorithm::starts_with(subindex, SUBINDEX_NAME + "_")) {
+            continue;
+        }
+        for (const string& index_type : INDEX_TYPES) {
+            string index_path = dir_it->path().string() + "/" + index_type;
+            FSDirectoryPtr fs_dir = FSDirectory::open(String(index_path.begin(), index_path.end()));
+            if (!exists(index_path) || !IndexReader::indexExists(fs_dir)) {
+                continue;
+            }
+            IndexReaderPtr reader = IndexReader::open(fs_dir, true);
+            num_segments[subindex + "/" + index_type] = reader->getSequentialSubReaders().size();
+            reader->close();
+        }
+    }
+    return num_segments;
+}
+
+string IndexManager::create_index_generation(const string& root_dir) {
+    create_directories(root_dir);
+    int generation_num = 0;
+    for (const string& generation : get_index_generations(root_dir)) {
+        generation_num = max(generation_num, stoi(path(generation).filename().string().substr(
+                INDEX_GENERATION_PREFIX.size())) + 1);
+    }
+    string generation_path = (path(root_dir) / (INDEX_GENERATION_PREFIX + to_string(generation_num))).string();
+    create_directories(generation_path + "/db");
+    return generation_path;
+}
+
+vector<string> IndexManager::get_index_generations(const string& root_dir) {
+    vector<pair<int, string>> generations;
+    if (!exists(root_dir)) {
+        return {};
+    }
+    regex generation_regex(INDEX_GENERATION_PREFIX + "([0-9]+)");
+    for (directory_iterator dir_it(root_dir); dir_it != directory_iterator(); ++dir_it) {
+        smatch match;
+        string filename = dir_it->path().filename().string();
+        if (is_directory(dir_it->symlink_status()) && regex_match(filename, match, generation_regex)) {
+            generations.emplace_back(stoi(match[1].str()), dir_it->path().string());
+        }
+    }
+    sort(generations.begin(), generations.end());
+    vector<string> generation_paths;
+    transform(generations.begin(), generations.end(), back_inserter(generation_paths),
+              [](const pair<int, string>& generation) { return generation.second; });
+    return generation_paths;
+}
+
+string IndexManager::get_current_index_generation(const string& root_dir) {
+    path current_link = path(root_dir) / CURRENT_INDEX_GENERATION_LINK;
+    if (!is_symlink(current_link)) {
+        return "";
+    }
+    return (path(root_dir) / read_symlink(current_link).filename()).string();
+}
+
+void IndexManager::publish_index_generation(const string& root_dir, const string& generation_path) {
+    path generation = path(generation_path);
+    if (!is_directory(path(root_dir) / generation.filename())) {
+        throw tpc_exception("the generation to publish is not in the root directory");
+    }
+    // the new link is created aside and renamed over the old one, which is an atomic replacement
+    path tmp_link = path(root_dir) / (CURRENT_INDEX_GENERATION_LINK + ".tmp");
+    boost::filesystem::remove(tmp_link);
+    create_directory_symlink(generation.filename(), tmp_link);
+    boost::filesystem::rename(tmp_link, path(root_dir) / CURRENT_INDEX_GENERATION_LINK);
+}
+
+void IndexManager::remove_index_generation(const string& root_dir, const string& generation_path) {
+    string current_generation = get_current_index_generation(root_dir);
+    if (!current_generation.empty() && path(current_generation).filename() == path(generation_path).filename()) {
+        throw tpc_exception("the current generation cannot be removed");
+    }
+    boost::filesystem::remove_all(path(root_dir) / path(generation_path).filename());
+}
+
+void IndexManager::switch_to_index(const string& index_path) {
+    // everything is opened and loaded before the switch, which only swaps the pointers
+    map<string, IndexReaderPtr> new_readers_map = open_warm_subreaders(index_path, readonly);
+    shared_ptr<IndexDbs> new_index_dbs = make_shared<IndexDbs>(index_path + "/db");
+    new_index_dbs->warm_up();
+    shared_ptr<CategoryDictionary> new_category_dictionary = make_shared<CategoryDictionary>();
+    new_category_dictionary->load(index_path + "/" + CATEGORY_DICTIONARY_FILENAME);
+    map<string, int> new_corpus_doc_counter;
+    read_corpus_counter(index_path, new_corpus_doc_counter);
+    map<string, IndexReaderPtr> old_readers_map;
+    {
+        lock_guard<mutex> lock(state_mutex);
+        old_readers_map = std::move(readers_map);
+        readers_map = std::move(new_readers_map);
+        // the searches running on the previous dbs keep them open until they end
+        index_dbs = std::move(new_index_dbs);
+        index_dir = index_path;
+        category_dictionary = std::move(new_category_dictionary);
+        corpus_doc_counter = std::move(new_corpus_doc_counter);
+    }
+    // closing a reader releases the reference of the index manager, the reader is actually closed when the
+    // multireaders of the searches running on it are closed
+    for (auto& old_reader : old_readers_map) {
+        old_reader.second->close();
+    }
+}
+
+bool IndexManager::switch_to_current_index_generation(const string& root_dir) {
+    string current_generation = get_current_index_generation(root_dir);
+    if (current_generation.empty()) {
+        throw tpc_exception("no generation has been published in the root directory");
+    }
+    string current_index_dir = get_index_dir();
+    if (exists(current_index_dir) && equivalent(current_generation, current_index_dir)) {
+        return false;
+    }
+    // the link is resolved once, so that the index manager keeps using the same generation until the next switch
+    switch_to_index(current_generation);
     return true;
 }
 
+map<string, IndexReaderPtr> IndexManager::open_warm_subreaders(const string& index_path, bool read_only) {
+    map<string, IndexReaderPtr> subreaders;
+    for (directory_iterator dir_it(index_path); dir_it != directory_iterator(); ++dir_it) {
+        if (!is_directory(dir_it->status()) || !regex_match(dir_it->path().string(),
+                                                            regex(".*\\/" + SUBINDEX_NAME + "\\_[0-9]+"))) {
+            continue;
+        }
+        for (const string& index_type : INDEX_TYPES) {
+            string index_id = dir_it->path().string() + "/" + index_type;
+            if (!exists(path(index_id + "/segments.gen"))) {
+                continue;
+            }
+            IndexReaderPtr reader = IndexReader::open(FSDirectory::open(String(index_id.begin(), index_id.end())),
+                                                      read_only);
+            // norms are otherwise loaded by the first search on each field
+            String text_field = boost::algorithm::starts_with(index_type, DOCUMENT_INDEXNAME) ? L"fulltext" :
+                                L"sentence";
+            if (reader->hasNorms(text_field)) {
+                reader->norms(text_field);
+            }
+            subreaders[index_id] = reader;
+        }
+    }
+    return subreaders;
+}
+
+map<string, ManifestEntry> IndexManager::read_manifest() const {
+    map<string, ManifestEntry> manifest;
+    std::ifstream ifs(index_dir + "/" + INDEX_MANIFEST_FILENAME);
+    string line;
+    while (getline(ifs, line)) {
+        vector<string> fields;
+        boost::split(fields, line, boost::is_any_of("\t"));
+        // the last line can be truncated if a run died while writing it
+        if (fields.size() != 6) {
+            continue;
+        }
+        ManifestEntry entry;
+        entry.identifier = fields[0];
+        entry.size = stoull(fields[1]);
+        entry.mtime = stoll(fields[2]);
+        entry.content_hash = fields[3];
+        entry.doc_id = fields[4];
+        entry.subindex = fields[5];
+        manifest[entry.identifier] = entry;
+    }
+    return manifest;
+}
+
+ManifestEntry IndexManager::create_manifest_entry(const string& file_path, const string& doc_id,
+                                                  const string& subindex, const string& content_hash) {
+    ManifestEntry entry;
+    entry.identifier = get_file_identifier(file_path);
+    entry.size = file_size(file_path);
+    entry.mtime = last_write_time(file_path);
+    entry.content_hash = content_hash;
+    entry.doc_id = doc_id;
+    entry.subindex = subindex;
+    return entry;
+}
+
+void IndexManager::write_manifest_entries(const vector<ManifestEntry>& entries,
+                                          map<string, ManifestEntry>& manifest) {
+    std::ofstream ofs(index_dir + "/" + INDEX_MANIFEST_FILENAME, std::ios::app);
+    for (const ManifestEntry& entry : entries) {
+        ofs << entry.identifier << "\t" << entry.size << "\t" << entry.mtime << "\t" << entry.content_hash << "\t"
+            << entry.doc_id << "\t" << entry.subindex << "\n";
+        manifest[entry.identifier] = entry;
+    }
+    ofs.flush();
+}
+
+void IndexManager::append_to_manifest(const vector<pair<string, string>>& files, const string& subindex_dir,
+                                      map<string, ManifestEntry>& manifest) {
+    if (files.empty()) {
+        return;
+    }
+    string fulltext_dir = subindex_dir + "/" + DOCUMENT_INDEXNAME;
+    IndexReaderPtr reader = IndexReader::open(FSDirectory::open(String(fulltext_dir.begin(), fulltext_dir.end())),
+                                              true);
+    SearcherPtr searcher = newLucene<IndexSearcher>(reader);
+    FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"doc_id"}));
+    string subindex = path(subindex_dir).filename().string();
+    vector<ManifestEntry> entries;
+    for (const auto& file : files) {
+        string filepath = get_file_identifier(file.first);
+        boost::replace_all(filepath, ".gz", "");
+        TopDocsPtr top_docs = searcher->search(newLucene<TermQuery>(newLucene<Term>(
+                L"filepath", String(filepath.begin(), filepath.end()))), 1);
+        string doc_id;
+        if (top_docs->totalHits > 0) {
+            String w_doc_id = reader->document(top_docs->scoreDocs[0]->doc, fsel)->get(L"doc_id");
+            doc_id = string(w_doc_id.begin(), w_doc_id.end());
+        }
+        entries.push_back(create_manifest_entry(file.first, doc_id, subindex, file.second));
+    }
+    reader->close();
+    write_manifest_entries(entries, manifest);
+}
+
+map<string, pair<string, string>> IndexManager::get_indexed_files() {
+    map<string, pair<string, string>> indexed_files;
+    FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"doc_id", L"filepath"}));
+    for (directory_iterator dir_it(index_dir); dir_it != directory_iterator(); ++dir_it) {
+        string subindex = dir_it->path().filename().string();
+        string fulltext_dir = dir_it->path().string() + "/" + DOCUMENT_INDEXNAME;
+        if (!boost::algorithm::starts_with(subindex, SUBINDEX_NAME + "_") || !exists(fulltext_dir)) {
+            continue;
+        }
+        FSDirectoryPtr fs_dir = FSDirectory::open(String(fulltext_dir.begin(), fulltext_dir.end()));
+        if (!IndexReader::indexExists(fs_dir)) {
+            continue;
+        }
+        IndexReaderPtr reader = IndexReader::open(fs_dir, true);
+        for (int i = 0; i < reader->maxDoc(); ++i) {
+            if (reader->isDeleted(i)) {
+                continue;
+            }
+            DocumentPtr doc = reader->document(i, fsel);
+            String filepath = doc->get(L"filepath");
+            String doc_id = doc->get(L"doc_id");
+            indexed_files[string(filepath.begin(), filepath.end())] = {string(doc_id.begin(), doc_id.end()),
+                                                                       subindex};
+        }
+        reader->close();
+    }
+    return indexed_files;
+}
+
+void IndexManager::create_subindex_dir_structure(const string &index_path) {
+    if (!exists(index_path)) {
+        create_directories(index_path);
+        create_directories(index_path + "/fulltext");
+        create_directories(index_path + "/fulltext_cs");
+        create_directories(index_path + "/sentence");
+        create_directories(index_path + "/sentence_cs");
+    }
+}
+
+TmpConf IndexManager::create_tmp_conf(const string &index_path, bool new_index) {
+    // temp dir for the bib files
+    std::string temp_dir;
+    bool dir_created = false;
+    while (!dir_created) {
+        temp_dir = Utils::get_temp_dir_path();
+        dir_created = create_directories(temp_dir);
+    }
+    TmpConf tmpConf = TmpConf();
+    tmpConf.new_index = new_index;
+    tmpConf.index_descriptor = Utils::get_index_descriptor(index_path, temp_dir, writer_options, false);
+    tmpConf.new_index_descriptor = Utils::get_index_descriptor(index_path, temp_dir, writer_options, true);
+    tmpConf.tmp_dir = temp_dir;
+    return tmpConf;
+}
+
+uima::AnalysisEngine* IndexManager::create_index_engine(const string& index_descriptor) {
+    /* Create/link up to a UIMACPP resource manager instance (singleton) */
+    (void) uima::ResourceManager::createInstance("TPCAS2LINDEXAE");
+    uima::ErrorInfo errorInfo;
+    icu::UnicodeString descriptor_buffer = icu::UnicodeString::fromUTF8(index_descriptor);
+    uima::AnalysisEngine * pEngine = uima::Framework::createAnalysisEngine(descriptor_buffer.getBuffer(),
+                                                                           descriptor_buffer.length(), errorInfo);
+    if (errorInfo.getErrorId() != UIMA_ERR_NONE) {
+        std::cerr << std::endl
+                  << "  Error string  : "
+                  << uima::AnalysisEngine::getErrorIdAsCString(errorInfo.getErrorId())
+                  << std::endl
+                  << "  UIMACPP Error info:" << std::endl
+                  << errorInfo << std::endl;
+        exit((int) errorInfo.getErrorId());
+    }
+    return pEngine;
+}
+
+void IndexManager::destroy_index_engine(uima::AnalysisEngine* engine) {
+    /* call collectionProcessComplete */
+    engine->collectionProcessComplete();
+    /* Free annotator (commits and closes the index writers) */
+    engine->destroy();
+    delete engine;
+}
+
+string IndexManager::get_file_identifier(const string& file_path) {
+    path p(file_path);
+    return p.parent_path().parent_path().filename().string() + "/" + p.parent_path().filename().string() + "/" +
+           p.filename().string();
+}
+
+vector<pair<string, string>> IndexManager::add_cas_files_to_index(const vector<string>& file_paths,
+                                                                  TmpConf& tmp_conf,
+                                                                  map<string, string>& content_hashes) {
+    vector<pair<string, string>> indexed_files;
+    uima::AnalysisEngine* pEngine = create_index_engine(tmp_conf.new_index ? tmp_conf.new_index_descriptor :
+                                                        tmp_conf.index_descriptor);
+    // the annotator creates the subindex while initializing its writers, next engines add to it
+    tmp_conf.new_index = false;
+    int num_read_threads = max(1, pipeline_options.num_read_threads);
+    int num_deserialize_threads = max(1, pipeline_options.num_deserialize_threads);
+    size_t queue_size = max(size_t(1), pipeline_options.queue_size);
+    tpc::BoundedQueue<InflatedCasFile> inflated_queue(queue_size);
+    tpc::BoundedQueue<DeserializedCasFile> deserialized_queue(queue_size);
+    // cas objects are created by the engine in this thread and recycled through the pipeline. There is one for each
+    // slot of the deserialized queue, plus one for each deserializer and one for the index stage
+    size_t num_cases = queue_size + num_deserialize_threads + 1;
+    tpc::BoundedQueue<uima::CAS*> free_cases(num_cases);
+    vector<uima::CAS*> cases;
+    for (size_t i = 0; i < num_cases; ++i) {
+        uima::CAS* cas = pEngine->newCAS();
+        if (cas == nullptr) {
+            std::cerr << "pEngine->newCAS() failed." << std::endl;
+            exit(1);
+        }
+        cases.push_back(cas);
+        free_cases.push(cas);
+    }
+    // files are indexed in the order of file_paths. Readers do not start a file more than num_cases positions after
+    // the next file to index, so that the files waiting to be reordered never hold all the cas objects
+    mutex order_mutex;
+    condition_variable order_cv;
+    size_t next_file_to_index(0);
+    atomic<bool> aborted(false);
+    // stage 1: read bib files and decompress cas files in memory. Unreadable files, including corrupted gzip files,
+    // are skipped
+    auto read_file = [&](InflatedCasFile& inflated) {
+        if (inflated.file_path.find(".tpcas.gz") == std::string::npos) {
+            return false;
+        }
+        string bib_file = inflated.file_path;
+        boost::replace_all(bib_file, ".tpcas.gz", ".bib");
+        if (!exists(bib_file)) {
+            return false;
+        }
+        inflated.bib_filename = path(bib_file).filename().string();
+        try {
+            std::ifstream bib_ifs(bib_file, std::ios::binary);
+            inflated.bib_content.assign(std::istreambuf_iterator<char>(bib_ifs), std::istreambuf_iterator<char>());
+            inflated.xmi = Utils::decompress_gzip_to_string(inflated.file_path);
+        } catch (std::exception& e) {
+            cerr << "Error reading file " << inflated.file_path << ": " << e.what() << endl;
+            return false;
+        }
+        return true;
+    };
+    atomic<size_t> next_file(0);
+    atomic<int> num_active_readers(num_read_threads);
+    auto read_stage = [&]() {
+        size_t file_idx;
+        while ((file_idx = next_file++) < file_paths.size()) {
+            {
+                unique_lock<mutex> lock(order_mutex);
+                order_cv.wait(lock, [&] { return aborted || file_idx < next_file_to_index + num_cases; });
+            }
+            if (aborted) {
+                break;
+            }
+            InflatedCasFile inflated;
+            inflated.sequence_num = file_idx;
+            inflated.file_path = file_paths[file_idx];
+            inflated.valid = read_file(inflated);
+            if (!inflated.valid) {
+                inflated.xmi.clear();
+            }
+            if (!inflated_queue.push(std::move(inflated))) {
+                break;
+            }
+        }
+        if (--num_active_readers == 0) {
+            inflated_queue.close();
+        }
+    };
+    // stage 2: deserialize the xmi or compact cas data into free cas objects. The deserializers run in parallel
+    // without locks: each cas object is owned by a single stage at a time, since it is handed over through the
+    // queues, and the type system shared by the cas objects is committed by the engine before the pipeline starts
+    // and is only read afterwards. Deserializers only write to the cas object they popped
+    atomic<int> num_active_deserializers(num_deserialize_threads);
+    auto deserialize_stage = [&]() {
+        InflatedCasFile inflated;
+        while (!aborted && inflated_queue.pop(inflated)) {
+            DeserializedCasFile deserialized;
+            deserialized.sequence_num = inflated.sequence_num;
+            deserialized.file_path = std::move(inflated.file_path);
+            if (inflated.valid) {
+                uima::CAS* cas;
+                if (!free_cases.pop(cas)) {
+                    break;
+                }
+                try {
+                    tpc::cas::CASManager::deserialize_cas(inflated.xmi, *cas, deserialized.file_path);
+                    deserialized.content_hash = Utils::gettpfnvHash(*cas);
+                    deserialized.cas = cas;
+                } catch (uima::Exception e) {
+                    uima::ErrorInfo errInfo = e.getErrorInfo();
+                    std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
+                    std::cerr << errInfo << std::endl;
+                    cas->reset();
+                    free_cases.push(cas);
+                } catch (...) {
+                    std::cerr << "Error deserializing file " << deserialized.file_path << std::endl;
+                    cas->reset();
+                    free_cases.push(cas);
+                }
+            }
+            deserialized.bib_filename = std::move(inflated.bib_filename);
+            deserialized.bib_content = std::move(inflated.bib_content);
+            inflated = InflatedCasFile();
+            if (!deserialized_queue.push(std::move(deserialized))) {
+                break;
+            }
+        }
+        if (--num_active_deserializers == 0) {
+            deserialized_queue.close();
+        }
+    };
+    // stage 3: process the cas objects with the annotator in this thread, since the engine and its index writers are
+    // not shared between threads. Files with the same content as a file in the registry, or as a previous file of
+    // the list, are skipped
+    vector<pair<string, string>> indexed_hashes;
+    auto index_file = [&](DeserializedCasFile& deserialized) {
+        auto hash_it = content_hashes.find(deserialized.content_hash);
+        if (!deserialized.content_hash.empty() && hash_it != content_hashes.end()) {
+            cerr << "skipping " << deserialized.file_path << ", same content as " << hash_it->second << endl;
+            return;
+        }
+        cout << "processing cas file: " << deserialized.file_path << endl;
+        string bib_file_temp = tmp_conf.tmp_dir + "/" + deserialized.bib_filename;
+        std::ofstream bib_ofs(bib_file_temp, std::ios::binary);
+        bib_ofs << deserialized.bib_content;
+        bib_ofs.close();
+        try {
+            auto text = getFulltext(*deserialized.cas);
+            if (text.length() > 0) {
+                pEngine->process(*deserialized.cas);
+                indexed_files.emplace_back(deserialized.file_path, deserialized.content_hash);
+                if (!deserialized.content_hash.empty()) {
+                    string identifier = get_file_identifier(deserialized.file_path);
+                    content_hashes[deserialized.content_hash] = identifier;
+                    indexed_hashes.emplace_back(deserialized.content_hash, identifier);
+                }
+            } else {
+                cout << "Skip file." << endl;
+            }
+        } catch (uima::Exception e) {
+            uima::ErrorInfo errInfo = e.getErrorInfo();
+            std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
+            std::cerr << errInfo << std::endl;
+        }
+        std::remove(bib_file_temp.c_str());
+    };
+    vector<thread> threads;
+    // the threads are stopped and joined on every path, before the queues and the cas objects they use are released
+    auto stop_pipeline = [&]() {
+        {
+            lock_guard<mutex> lock(order_mutex);
+            aborted = true;
+        }
+        order_cv.notify_all();
+        inflated_queue.close();
+        deserialized_queue.close();
+        free_cases.close();
+        for (auto& t : threads) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    };
+    try {
+        for (int i = 0; i < num_read_threads; ++i) {
+            threads.emplace_back(read_stage);
+        }
+        for (int i = 0; i < num_deserialize_threads; ++i) {
+            threads.emplace_back(deserialize_stage);
+        }
+        // files deserialized ahead of the next file to index wait in the reorder buffer
+        map<size_t, DeserializedCasFile> reorder_buffer;
+        size_t next_sequence_num(0);
+        DeserializedCasFile deserialized;
+        while (deserialized_queue.pop(deserialized)) {
+            size_t sequence_num = deserialized.sequence_num;
+            reorder_buffer.emplace(sequence_num, std::move(deserialized));
+            auto next_it = reorder_buffer.begin();
+            while (next_it != reorder_buffer.end() && next_it->first == next_sequence_num) {
+                DeserializedCasFile next_file_to_process = std::move(next_it->second);
+                reorder_buffer.erase(next_it);
+                if (next_file_to_process.cas != nullptr) {
+                    index_file(next_file_to_process);
+                    next_file_to_process.cas->reset();
+                    free_cases.push(next_file_to_process.cas);
+                }
+                {
+                    lock_guard<mutex> lock(order_mutex);
+                    next_file_to_index = ++next_sequence_num;
+                }
+                order_cv.notify_all();
+                next_it = reorder_buffer.begin();
+            }
+        }
+        stop_pipeline();
+    } catch (...) {
+        stop_pipeline();
+        for (uima::CAS* cas : cases) {
+            delete cas;
+        }
+        // the files processed before the error are committed when the engine is destroyed
+        destroy_index_engine(pEngine);
+        add_content_hashes_to_db(indexed_hashes);
+        throw;
+    }
+    for (uima::CAS* cas : cases) {
+        delete cas;
+    }
+    destroy_index_engine(pEngine);
+    add_content_hashes_to_db(indexed_hashes);
+    return indexed_files;
+}
+
 void IndexManager::add_file_to_index(const std::string &file_path, int max_num_papers_per_subindex)
 {
+    add_files_to_index({file_path}, max_num_papers_per_subindex);
+}
+
+void IndexManager::add_files_to_index(const vector<string>& file_paths, int max_num_papers_per_subindex)
+{
+    update_category_dictionary();
+    map<string, string> content_hashes = load_content_hashes_from_db();
     string out_dir = index_dir + "/" + SUBINDEX_NAME;
-    string subindex_dir(SUBINDEX_NAME + "_0");
-    int counter_cas_files(0);
+    int largest_subindex_num = get_largest_subindex_num();
+    MultiReaderPtr multireader = open_multireader(QueryType::document, false);
+    int counter_cas_files = multireader->numDocs();
+    multireader->close();
+    vector<string> added_files;
+    auto files_it = file_paths.begin();
+    while (files_it != file_paths.end()) {
+        TmpConf tmp_conf;
+        int num_free_slots = max_num_papers_per_subindex - counter_cas_files % max_num_papers_per_subindex;
+        if (counter_cas_files % max_num_papers_per_subindex == 0) {
+            // create new subindex
+            string subindex_dir = out_dir + "_" + to_string(++largest_subindex_num);
+            tmp_conf = create_tmp_conf(subindex_dir, true);
+            create_subindex_dir_structure(subindex_dir);
+        } else {
+            tmp_conf = create_tmp_conf(out_dir + "_" + to_string(largest_subindex_num));
+        }
+        bool new_subindex = tmp_conf.new_index;
+        auto chunk_end = distance(files_it, file_paths.end()) <= num_free_slots ? file_paths.end() :
+                         files_it + num_free_slots;
+        // all the files of the chunk go through a single writer session and a single commit
+        vector<pair<string, string>> indexed_files = add_cas_files_to_index(vector<string>(files_it, chunk_end),
+                                                                            tmp_conf, content_hashes);
+        boost::filesystem::remove_all(tmp_conf.tmp_dir);
+        if (indexed_files.empty() && new_subindex) {
+            // all the files of the chunk were skipped, e.g. because their content is already in the index
+            boost::filesystem::remove_all(out_dir + "_" + to_string(largest_subindex_num--));
+        }
+        counter_cas_files += indexed_files.size();
+        for (const auto& indexed_file : indexed_files) {
+            added_files.push_back(indexed_file.first);
+        }
+        files_it = chunk_end;
+    }
+    readers_map.clear();
+    vector<string> identifiers;
+    transform(added_files.begin(), added_files.end(), back_inserter(identifiers), get_file_identifier);
+    add_docs_and_sentences_to_bdb(identifiers);
+    cout << "total number of cas files added: " << to_string(added_files.size()) << endl;
+}
+
+int IndexManager::get_largest_subindex_num() const {
     int largest_subindex_num(0);
     for (directory_iterator dir_it(index_dir); dir_it != directory_iterator(); ++dir_it) {
         string actual_subidx_name = dir_it->path().filename().string().substr(0, dir_it->path().filename()
@@ -867,32 +2022,279 @@ void IndexManager::add_file_to_index(const std::string &file_path, int max_num_p
             largest_subindex_num = stoi(actual_subidx_num);
         }
     }
-    Collection<IndexReaderPtr> subReaders = get_subreaders(QueryType::document, false);
-    MultiReaderPtr multireader = newLucene<MultiReader>(subReaders, false);
-    counter_cas_files = multireader->numDocs();
-    bool first_paper;
-    TmpConf tmp_conf = write_tmp_conf_files(out_dir + "_" + to_string(largest_subindex_num));
-    if (counter_cas_files % max_num_papers_per_subindex == 0) {
-        // create new subindex
-        subindex_dir = out_dir + "_" + to_string(largest_subindex_num + 1);
-        tmp_conf = write_tmp_conf_files(subindex_dir);
-        first_paper = true;
-        if (!exists(tmp_conf.new_index_flag)) {
-            std::ofstream f_newindexflag(tmp_conf.new_index_flag.c_str());
-            f_newindexflag << "newindexflag";
-            f_newindexflag.close();
+    return largest_subindex_num;
+}
+
+void IndexManager::add_raw_files_to_index(const vector<string>& file_paths, tpc::cas::FileType type,
+                                          const string& literature, const string& archive_cas_dir,
+                                          int max_num_papers_per_subindex, tpc::cas::CasFormat archive_cas_format)
+{
+    update_category_dictionary();
+    map<string, string> content_hashes = load_content_hashes_from_db();
+    string out_dir = index_dir + "/" + SUBINDEX_NAME;
+    int largest_subindex_num = get_largest_subindex_num();
+    MultiReaderPtr multireader = open_multireader(QueryType::document, false);
+    int counter_cas_files = multireader->numDocs();
+    multireader->close();
+    vector<string> identifiers;
+    auto files_it = file_paths.begin();
+    while (files_it != file_paths.end()) {
+        TmpConf tmp_conf;
+        int num_free_slots = max_num_papers_per_subindex - counter_cas_files % max_num_papers_per_subindex;
+        if (counter_cas_files % max_num_papers_per_subindex == 0) {
+            // create new subindex
+            string subindex_dir = out_dir + "_" + to_string(++largest_subindex_num);
+            tmp_conf = create_tmp_conf(subindex_dir, true);
+            create_subindex_dir_structure(subindex_dir);
+        } else {
+            tmp_conf = create_tmp_conf(out_dir + "_" + to_string(largest_subindex_num));
+        }
+        bool new_subindex = tmp_conf.new_index;
+        auto chunk_end = distance(files_it, file_paths.end()) <= num_free_slots ? file_paths.end() :
+                         files_it + num_free_slots;
+        vector<string> indexed_files = add_raw_files_to_subindex(vector<string>(files_it, chunk_end), type,
+                                                                 literature, archive_cas_dir, archive_cas_format,
+                                                                 tmp_conf, content_hashes);
+        boost::filesystem::remove_all(tmp_conf.tmp_dir);
+        if (indexed_files.empty() && new_subindex) {
+            // all the articles of the chunk were skipped, e.g. because their content is already in the index
+            boost::filesystem::remove_all(out_dir + "_" + to_string(largest_subindex_num--));
+        }
+        counter_cas_files += indexed_files.size();
+        move(indexed_files.begin(), indexed_files.end(), back_inserter(identifiers));
+        files_it = chunk_end;
+    }
+    readers_map.clear();
+    add_docs_and_sentences_to_bdb(identifiers);
+    cout << "total number of raw files added: " << to_string(identifiers.size()) << endl;
+}
+
+vector<string> IndexManager::add_raw_files_to_subindex(const vector<string>& file_paths, tpc::cas::FileType type,
+                                                       const string& literature, const string& archive_cas_dir,
+                                                       tpc::cas::CasFormat archive_cas_format, TmpConf& tmp_conf,
+                                                       map<string, string>& content_hashes) {
+    vector<string> indexed_files;
+    string tokenizer_descriptor = type == tpc::cas::FileType::pdf ? tpc::cas::PDF2TPCAS_DESCRIPTOR :
+                                  tpc::cas::XML2TPCAS_DESCRIPTOR;
+    // the lexicon annotator assigns the category ids of the dictionary of the index, if available
+    string category_dictionary_file = index_dir + "/" + CATEGORY_DICTIONARY_FILENAME;
+    uima::AnalysisEngine* pEngine = create_index_engine(Utils::get_raw_file_index_descriptor(
+            tokenizer_descriptor, tpc::cas::TPCAS1_2_TPCAS2_DESCRIPTOR,
+            tmp_conf.new_index ? tmp_conf.new_index_descriptor : tmp_conf.index_descriptor,
+            exists(category_dictionary_file) ? category_dictionary_file : ""));
+    tmp_conf.new_index = false;
+    uima::CAS* cas = pEngine->newCAS();
+    if (cas == nullptr) {
+        std::cerr << "pEngine->newCAS() failed." << std::endl;
+        exit(1);
+    }
+    // raw files are converted to text streams by parallel threads, while the engine processes them in this thread
+    int num_read_threads = max(1, pipeline_options.num_read_threads);
+    tpc::BoundedQueue<RawFileStream> streams_queue(max(size_t(1), pipeline_options.queue_size));
+    atomic<size_t> next_file(0);
+    atomic<int> num_active_readers(num_read_threads);
+    auto read_stage = [&]() {
+        size_t file_idx;
+        while ((file_idx = next_file++) < file_paths.size()) {
+            path raw_path(file_paths[file_idx]);
+            string paper = raw_path.parent_path().filename().string();
+            RawFileStream raw;
+            raw.file_path = raw_path.string();
+            raw.filename = literature + "/" + paper + "/" + raw_path.stem().string() + ".tpcas";
+            raw.bib_filename = raw_path.stem().string() + ".bib";
+            // images extracted from pdf files are kept only with the archival cas files
+            string image_dir = archive_cas_dir.empty() ? tmp_conf.tmp_dir + "/images/" + paper :
+                               archive_cas_dir + "/" + literature + "/" + paper + "/images";
+            try {
+                path bib_file = raw_path.parent_path() / raw.bib_filename;
+                if (exists(bib_file)) {
+                    std::ifstream bib_ifs(bib_file.string(), std::ios::binary);
+                    raw.bib_content.assign(std::istreambuf_iterator<char>(bib_ifs), std::istreambuf_iterator<char>());
+                } else if (type == tpc::cas::FileType::xml) {
+                    std::ifstream xml_ifs(raw.file_path, std::ios::binary);
+                    string xml_text((std::istreambuf_iterator<char>(xml_ifs)), std::istreambuf_iterator<char>());
+                    raw.bib_content = tpc::cas::CASManager::get_bib_file_content(
+                            tpc::cas::CASManager::get_bib_info_from_xml_text(xml_text));
+                } else {
+                    cerr << "bib file not found, skipping: " << raw.file_path << endl;
+                    continue;
+                }
+                create_directories(image_dir);
+                tpc::cas::CASManager::get_raw_file_stream(raw.file_path, type,
+                                                          image_dir + "/" + raw_path.stem().string(), raw.stream);
+                if (!raw.stream.empty()) {
+                    raw.content_hash = tpc::cas::CASManager::get_tpfnv_hash_from_stream(raw.stream, raw.filename);
+                }
+            } catch (std::exception& e) {
+                cerr << "Error reading file " << raw.file_path << ": " << e.what() << endl;
+                continue;
+            }
+            if (!streams_queue.push(std::move(raw))) {
+                break;
+            }
+        }
+        if (--num_active_readers == 0) {
+            streams_queue.close();
+        }
+    };
+    vector<pair<string, string>> indexed_hashes;
+    auto index_file = [&](RawFileStream& raw) {
+        if (raw.stream.empty()) {
+            cout << "Skip file." << endl;
+            return;
+        }
+        // documents with the same content as a document in the registry are not converted nor indexed again
+        auto hash_it = content_hashes.find(raw.content_hash);
+        if (hash_it != content_hashes.end()) {
+            cerr << "skipping " << raw.file_path << ", same content as " << hash_it->second << endl;
+            return;
+        }
+        cout << "processing raw file: " << raw.file_path << endl;
+        string identifier = raw.filename + ".gz";
+        string bib_file_temp = tmp_conf.tmp_dir + "/" + raw.bib_filename;
+        std::ofstream bib_ofs(bib_file_temp, std::ios::binary);
+        bib_ofs << raw.bib_content;
+        bib_ofs.close();
+        try {
+            tpc::cas::CASManager::set_cas_text_from_stream(*cas, raw.stream, raw.filename);
+            pEngine->process(*cas);
+            indexed_files.push_back(identifier);
+            content_hashes[raw.content_hash] = identifier;
+            indexed_hashes.emplace_back(raw.content_hash, identifier);
+            if (!archive_cas_dir.empty()) {
+                path archive_file = path(archive_cas_dir) / identifier;
+                create_directories(archive_file.parent_path());
+                tpc::cas::CASManager::write_compressed_cas(*cas, archive_file.string(), archive_cas_format);
+                std::ofstream archive_bib_ofs((archive_file.parent_path() / raw.bib_filename).string(),
+                                              std::ios::binary);
+                archive_bib_ofs << raw.bib_content;
+            }
+        } catch (uima::Exception e) {
+            uima::ErrorInfo errInfo = e.getErrorInfo();
+            std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
+            std::cerr << errInfo << std::endl;
+        } catch (std::runtime_error& e) {
+            // the article has been indexed, only its archival cas file is missing
+            std::cerr << e.what() << std::endl;
+        }
+        std::remove(bib_file_temp.c_str());
+        cas->reset();
+    };
+    vector<thread> threads;
+    // the readers are stopped and joined on every path, before the queue they use is released
+    auto stop_pipeline = [&]() {
+        streams_queue.close();
+        for (auto& t : threads) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    };
+    try {
+        for (int i = 0; i < num_read_threads; ++i) {
+            threads.emplace_back(read_stage);
+        }
+        RawFileStream raw;
+        while (streams_queue.pop(raw)) {
+            index_file(raw);
+        }
+        stop_pipeline();
+    } catch (...) {
+        stop_pipeline();
+        delete cas;
+        // the documents processed before the error are committed when the engine is destroyed
+        destroy_index_engine(pEngine);
+        add_content_hashes_to_db(indexed_hashes);
+        throw;
+    }
+    delete cas;
+    destroy_index_engine(pEngine);
+    add_content_hashes_to_db(indexed_hashes);
+    return indexed_files;
+}
+
+map<string, string> IndexManager::load_content_hashes_from_db() const {
+    map<string, string> content_hashes;
+    if (!exists(index_dir + "/db/" + CONTENT_HASH_DB_NAME)) {
+        return content_hashes;
+    }
+    DbEnv env(DB_CXX_NO_EXCEPTIONS);
+    try {
+        env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
+        Db* pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
+        pdb->open(NULL, CONTENT_HASH_DB_NAME.c_str(), NULL, DB_BTREE, DB_RDONLY, 0);
+        typedef dbstl::db_map<string, string> HashMap;
+        HashMap hash_map(pdb, &env);
+        // the registry is keyed by identifier, the lookups during indexing are by hash
+        for (auto it = hash_map.begin(); it != hash_map.end(); ++it) {
+            content_hashes[it->second] = it->first;
+        }
+        pdb->close(0);
+        delete pdb;
+        env.close(0);
+    } catch (DbException& e) {
+        cerr << "DbException: " << e.what() << endl;
+    } catch (std::exception& e) {
+        cerr << e.what() << endl;
+    }
+    return content_hashes;
+}
+
+void IndexManager::add_content_hashes_to_db(const vector<pair<string, string>>& entries) {
+    if (entries.empty()) {
+        return;
+    }
+    if (!exists(index_dir + "/db")) {
+        create_directories(index_dir + "/db");
+    }
+    DbEnv env(DB_CXX_NO_EXCEPTIONS);
+    try {
+        env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
+        Db* pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
+        pdb->open(NULL, CONTENT_HASH_DB_NAME.c_str(), NULL, DB_BTREE, DB_CREATE, 0);
+        typedef dbstl::db_map<string, string> HashMap;
+        HashMap hash_map(pdb, &env);
+        for (const auto& entry : entries) {
+            hash_map[boost::replace_all_copy(entry.second, ".gz", "")] = entry.first;
         }
-        create_subindex_dir_structure(subindex_dir);
+        pdb->close(0);
+        delete pdb;
+        env.close(0);
+    } catch (DbException& e) {
+        cerr << "DbException: " << e.what() << endl;
+    } catch (std::exception& e) {
+        cerr << e.what() << endl;
+    }
+}
+
+void IndexManager::remove_content_hash_from_db(string identifier) {
+    if (!exists(index_dir + "/db/" + CONTENT_HASH_DB_NAME)) {
+        return;
+    }
+    boost::replace_all(identifier, ".gz", "");
+    DbEnv env(DB_CXX_NO_EXCEPTIONS);
+    try {
+        env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
+        Db* pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
+        pdb->open(NULL, CONTENT_HASH_DB_NAME.c_str(), NULL, DB_BTREE, DB_RDWRMASTER, 0);
+        typedef dbstl::db_map<string, string> HashMap;
+        HashMap hash_map(pdb, &env);
+        hash_map.erase(identifier);
+        pdb->close(0);
+        delete pdb;
+        env.close(0);
+    } catch (DbException& e) {
+        cerr << "DbException: " << e.what() << endl;
+    } catch (std::exception& e) {
+        cerr << e.what() << endl;
     }
-    process_single_file(file_path, first_paper, tmp_conf, true);
-    ++counter_cas_files;
-    cout << "total number of cas files added: " << to_string(counter_cas_files) << endl;
 }
 
 void IndexManager::remove_file_from_index(const std::string &identifier) {
     // document - case insensitive index
     string doc_id = remove_document_from_index(identifier, false);
     if (doc_id != "not_found") {
+        remove_content_hash_from_db(identifier);
         // document - case sensitive index
         remove_document_from_index(identifier, true);
         // sentence - case insensitive index
@@ -903,8 +2305,7 @@ void IndexManager::remove_file_from_index(const std::string &identifier) {
 }
 
 string IndexManager::remove_document_from_index(std::string identifier, bool case_sensitive) {
-    Collection<IndexReaderPtr> subreaders = get_subreaders(QueryType::document, case_sensitive);
-    MultiReaderPtr multireader = newLucene<MultiReader>(subreaders, false);
+    MultiReaderPtr multireader = open_multireader(QueryType::document, case_sensitive);
     AnalyzerPtr analyzer = newLucene<KeywordAnalyzer>();
     QueryParserPtr parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, L"filepath", analyzer);
     boost::replace_all(identifier, ".gz", "");
@@ -945,85 +2346,77 @@ string IndexManager::remove_document_from_index(std::string identifier, bool cas
     }
     multireader->close();
     readers_map.clear();
+    reset_index_dbs();
     return string(doc_id.begin(), doc_id.end());
 }
 
 void IndexManager::add_doc_and_sentences_to_bdb(string identifier)
 {
-    // remove doc
-    Collection<IndexReaderPtr> subreaders = get_subreaders(QueryType::document, false);
-    MultiReaderPtr multireader = newLucene<MultiReader>(subreaders, false);
+    add_docs_and_sentences_to_bdb({identifier});
+}
+
+void IndexManager::add_docs_and_sentences_to_bdb(const vector<string>& identifiers)
+{
+    if (identifiers.empty()) {
+        return;
+    }
+    MultiReaderPtr doc_multireader = open_multireader(QueryType::document, false);
+    SearcherPtr doc_searcher = newLucene<IndexSearcher>(doc_multireader);
+    MultiReaderPtr sent_multireader = open_multireader(QueryType::sentence, false);
+    SearcherPtr sent_searcher = newLucene<IndexSearcher>(sent_multireader);
     AnalyzerPtr analyzer = newLucene<KeywordAnalyzer>();
-    QueryParserPtr parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, L"filepath", analyzer);
-    boost::replace_all(identifier, ".gz", "");
-    String query_str = L"filepath:\"" + String(identifier.begin(), identifier.end()) + L"\"";
-    QueryPtr luceneQuery = parser->parse(query_str);
-    SearcherPtr searcher = newLucene<IndexSearcher>(multireader);
-    TopScoreDocCollectorPtr collector = TopScoreDocCollector::create(MAX_HITS, true);
-    searcher->search(luceneQuery, collector);
-    Collection<ScoreDocPtr> matchesCollection = collector->topDocs()->scoreDocs;
+    QueryParserPtr doc_parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, L"filepath", analyzer);
+    QueryParserPtr sent_parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, L"doc_id", analyzer);
     FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"doc_id", L"year"}));
-    String doc_id = multireader->document(matchesCollection[0]->doc, fsel)->get(L"doc_id");
-    String year = multireader->document(matchesCollection[0]->doc, fsel)->get(L"year");
     DbEnv env(DB_CXX_NO_EXCEPTIONS);
-    Db* pdb;
     try {
         env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
-        pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
-        pdb->open(NULL, "doc_map.db", NULL, DB_BTREE, DB_RDWRMASTER, 0);
-        typedef dbstl::db_map<int, string> HugeMap;
-        HugeMap huge_map(pdb, &env);
-        huge_map[matchesCollection[0]->doc] = string(year.begin(), year.end());
-        if (pdb != NULL) {
-            pdb->close(0);
-            delete pdb;
-        }
-        env.close(0);
-    } catch (DbException& e) {
-        cerr << "DbException: " << e.what() << endl;
-    } catch (std::exception& e) {
-        cerr << e.what() << endl;
-    }
-    multireader->close();
-
-    // remove doc sentences
-    subreaders = get_subreaders(QueryType::sentence, false);
-    multireader = newLucene<MultiReader>(subreaders, false);
-    analyzer = newLucene<KeywordAnalyzer>();
-    parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, L"doc_id", analyzer);
-    query_str = L"doc_id:" + doc_id;
-    luceneQuery = parser->parse(query_str);
-    searcher = newLucene<IndexSearcher>(multireader);
-    collector = TopScoreDocCollector::create(MAX_HITS, true);
-    searcher->search(luceneQuery, collector);
-    matchesCollection = collector->topDocs()->scoreDocs;
-    try {
-        DbEnv sent_env(DB_CXX_NO_EXCEPTIONS);
-        Db* sent_pdb;
-        sent_env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
-        sent_pdb = new Db(&sent_env, DB_CXX_NO_EXCEPTIONS);
+        Db* doc_pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
+        doc_pdb->open(NULL, "doc_map.db", NULL, DB_BTREE, DB_RDWRMASTER, 0);
+        Db* sent_pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
         sent_pdb->open(NULL, "sent_map.db", NULL, DB_BTREE, DB_RDWRMASTER, 0);
         typedef dbstl::db_map<int, string> HugeMap;
-        HugeMap huge_map(sent_pdb, &sent_env);
-        for (auto& sentence : matchesCollection) {
-            huge_map[sentence->doc] = string(doc_id.begin(), doc_id.end()) + "|" + string(year.begin(), year.end());
-        }
-        if (sent_pdb != NULL) {
-            sent_pdb->close(0);
-            delete sent_pdb;
+        HugeMap doc_map(doc_pdb, &env);
+        HugeMap sent_map(sent_pdb, &env);
+        for (string identifier : identifiers) {
+            boost::replace_all(identifier, ".gz", "");
+            String query_str = L"filepath:\"" + String(identifier.begin(), identifier.end()) + L"\"";
+            TopScoreDocCollectorPtr collector = TopScoreDocCollector::create(MAX_HITS, true);
+            doc_searcher->search(doc_parser->parse(query_str), collector);
+            Collection<ScoreDocPtr> matchesCollection = collector->topDocs()->scoreDocs;
+            if (matchesCollection.size() == 0) {
+                continue;
+            }
+            DocumentPtr doc = doc_multireader->document(matchesCollection[0]->doc, fsel);
+            String doc_id = doc->get(L"doc_id");
+            String year = doc->get(L"year");
+            doc_map[matchesCollection[0]->doc] = string(year.begin(), year.end());
+            collector = TopScoreDocCollector::create(MAX_HITS, true);
+            sent_searcher->search(sent_parser->parse(L"doc_id:" + doc_id), collector);
+            string sent_value = string(doc_id.begin(), doc_id.end()) + "|" + string(year.begin(), year.end());
+            for (auto& sentence : collector->topDocs()->scoreDocs) {
+                sent_map[sentence->doc] = sent_value;
+            }
         }
-        sent_env.close(0);
+        doc_pdb->close(0);
+        delete doc_pdb;
+        sent_pdb->close(0);
+        delete sent_pdb;
+        env.close(0);
     } catch (DbException& e) {
         cerr << "DbException: " << e.what() << endl;
     } catch (std::exception& e) {
         cerr << e.what() << endl;
     }
-    multireader->close();
+    doc_multireader->close();
+    sent_multireader->close();
+    // the dbs of the searches are reopened on the next search, so that they do not serve the pages cached before
+    // the update
+    reset_index_dbs();
 }
 
 void IndexManager::remove_sentences_for_document(const std::string &doc_id, bool case_sensitive) {
-    Collection<IndexReaderPtr> subreaders = get_subreaders(QueryType::sentence, case_sensitive);
-    MultiReaderPtr multireader = newLucene<MultiReader>(subreaders, false);
+    MultiReaderPtr multireader = open_multireader(QueryType::sentence, case_sensitive);
     AnalyzerPtr analyzer = newLucene<KeywordAnalyzer>();
     QueryParserPtr parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, L"doc_id", analyzer);
     String query_str = L"doc_id:" + String(doc_id.begin(), doc_id.end());
@@ -1058,6 +2451,7 @@ void IndexManager::remove_sentences_for_document(const std::string &doc_id, bool
     }
     readers_map.clear();
     multireader->close();
+    reset_index_dbs();
 }
 
 std::vector<std::string> IndexManager::get_available_corpora() {
@@ -1074,12 +2468,48 @@ std::vector<std::string> IndexManager::get_available_corpora() {
 std::vector<std::string> IndexManager::get_additional_corpora() {
     vector<string> corpora_vec;
     load_corpus_counter();
+    lock_guard<mutex> lock(state_mutex);
     for (const auto& cd_conter_map : corpus_doc_counter) {
         corpora_vec.push_back(cd_conter_map.first);
     }
     return corpora_vec;
 }
 
+CategoryDictionary IndexManager::get_category_dictionary() const {
+    CategoryDictionary category_dictionary;
+    category_dictionary.load(get_index_dir() + "/" + CATEGORY_DICTIONARY_FILENAME);
+    return category_dictionary;
+}
+
+void IndexManager::create_category_dictionary(const string& lexicon_file) {
+    CategoryDictionary category_dictionary = get_category_dictionary();
+    category_dictionary.add_lexicon_categories(lexicon_file);
+    save_category_dictionary(category_dictionary);
+}
+
+void IndexManager::update_category_dictionary(const string& annotator_descriptor) {
+    CategoryDictionary category_dictionary = get_category_dictionary();
+    string lexicon;
+    try {
+        if (get_descriptor_parameter(annotator_descriptor, "LexiconTableName", lexicon)) {
+            add_pg_lexicon_categories(lexicon, category_dictionary);
+        } else if (get_descriptor_parameter(annotator_descriptor, "LocalLexiconFile", lexicon)) {
+            category_dictionary.add_lexicon_categories(lexicon);
+        } else {
+            cerr << "no lexicon found in " << annotator_descriptor << endl;
+        }
+    } catch (std::exception& e) {
+        cerr << "cannot read the lexicon of " << annotator_descriptor << ": " << e.what() << endl;
+    }
+    save_category_dictionary(category_dictionary);
+}
+
+void IndexManager::save_category_dictionary(const CategoryDictionary& dictionary) {
+    dictionary.save(index_dir + "/" + CATEGORY_DICTIONARY_FILENAME);
+    lock_guard<mutex> lock(state_mutex);
+    category_dictionary = make_shared<CategoryDictionary>(dictionary);
+}
+
 vector<string> IndexManager::get_external_corpora() {
     if (has_external_index()) {
         return externalIndexManager->get_additional_corpora();
@@ -1095,7 +2525,9 @@ int IndexManager::get_num_articles_in_corpus(const string &corpus, bool external
         }
     } else {
         load_corpus_counter();
-        return corpus_doc_counter[corpus];
+        lock_guard<mutex> lock(state_mutex);
+        auto counter_it = corpus_doc_counter.find(corpus);
+        return counter_it != corpus_doc_counter.end() ? counter_it->second : 0;
     }
 }
 
@@ -1108,13 +2540,23 @@ void IndexManager::save_corpus_counter() {
 }
 
 void IndexManager::load_corpus_counter() {
-    std::ifstream ifs(index_dir + "/" + CORPUS_COUNTER_FILENAME, std::ios::binary);
-    if (ifs) {
-        boost::archive::text_iarchive ia(ifs);
-        ia >> corpus_doc_counter;
+    map<string, int> corpus_counter;
+    if (read_corpus_counter(get_index_dir(), corpus_counter)) {
+        lock_guard<mutex> lock(state_mutex);
+        corpus_doc_counter = std::move(corpus_counter);
     }
 }
 
+bool IndexManager::read_corpus_counter(const string& index_path, map<string, int>& corpus_counter) {
+    std::ifstream ifs(index_path + "/" + CORPUS_COUNTER_FILENAME, std::ios::binary);
+    if (!ifs) {
+        return false;
+    }
+    boost::archive::text_iarchive ia(ifs);
+    ia >> corpus_counter;
+    return true;
+}
+
 void IndexManager::update_corpus_counter() {
     if (!external) {
         for (const auto &corpus_regex : tpc::cas::PMCOA_CAT_REGEX) {
@@ -1139,8 +2581,7 @@ void IndexManager::update_corpus_counter() {
 
 int IndexManager::get_num_docs_in_corpus_from_index(const string& corpus) {
     Collection<ScoreDocPtr> matchesCollection;
-    Collection<IndexReaderPtr> subReaders = get_subreaders(QueryType::document, false);
-    MultiReaderPtr multireader = newLucene<MultiReader>(subReaders, false);
+    MultiReaderPtr multireader = open_multireader(QueryType::document, false);
     SearcherPtr searcher = newLucene<IndexSearcher>(multireader);
     AnalyzerPtr analyzer = newLucene<StandardAnalyzer>(LuceneVersion::LUCENE_30);
     QueryParserPtr parser = newLucene<QueryParser>(LuceneVersion::LUCENE_30, L"fulltext", analyzer);
@@ -1157,62 +2598,102 @@ void IndexManager::calculate_and_save_corpus_counter() {
     save_corpus_counter();
 }
 
-void IndexManager::save_all_doc_ids_for_sentences_to_db() {
+void IndexManager::bulk_load_db_map(const string& db_name, vector<pair<int, string>>& entries) {
+    // keys are written in the byte order used by the default btree comparison, so that every page is filled
+    // sequentially and never split twice
+    sort(entries.begin(), entries.end(), [](const pair<int, string>& a, const pair<int, string>& b) {
+        return memcmp(&a.first, &b.first, sizeof(int)) < 0;
+    });
     DbEnv env(DB_CXX_NO_EXCEPTIONS);
-    Db* pdb;
+    // the db is closed before the environment on every path
+    auto close_db = [](Db* db) {
+        db->close(0);
+        delete db;
+    };
+    unique_ptr<Db, decltype(close_db)> pdb(nullptr, close_db);
     try {
         env.set_error_stream(&cerr);
-        env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
-        pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
-        pdb->open(NULL, "sent_map.db", NULL, DB_BTREE, DB_CREATE, 0);
-        typedef dbstl::db_map<int, string> HugeMap;
-        HugeMap huge_map(pdb, &env);
-        Collection<IndexReaderPtr> subReaders = get_subreaders(QueryType::sentence, false);
-        MultiReaderPtr multireader = newLucene<MultiReader>(subReaders, false);
-        FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"doc_id", L"sentence_id", L"year"}));
-        for (int i = 0; i < multireader->maxDoc(); i++) {
-            String doc_id = multireader->document(i, fsel)->get(L"doc_id");
-            String year = multireader->document(i, fsel)->get(L"year");
-            huge_map[i] = string(doc_id.begin(), doc_id.end()) + "|" + string(year.begin(), year.end());
+        env.set_cachesize(0, BDB_BULK_CACHE_SIZE, 1);
+        int ret = env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
+        if (ret != 0) {
+            throw DbException(("cannot open the db environment of " + index_dir).c_str(), ret);
         }
-        if (pdb != NULL) {
-            pdb->close(0);
-            delete pdb;
+        // the map is rebuilt from scratch, so that entries of deleted documents do not survive the rebuild
+        env.dbremove(NULL, db_name.c_str(), NULL, 0);
+        pdb.reset(new Db(&env, DB_CXX_NO_EXCEPTIONS));
+        pdb->set_pagesize(BDB_BULK_PAGE_SIZE);
+        ret = pdb->open(NULL, db_name.c_str(), NULL, DB_BTREE, DB_CREATE, 0);
+        if (ret != 0) {
+            throw DbException(("cannot open " + db_name).c_str(), ret);
+        }
+        vector<char> buffer(BDB_BULK_BUFFER_SIZE);
+        Dbt multiple_kv(buffer.data(), (u_int32_t) buffer.size());
+        multiple_kv.set_ulen((u_int32_t) buffer.size());
+        multiple_kv.set_flags(DB_DBT_USERMEM | DB_DBT_BULK);
+        Dbt unused_data;
+        auto put_multiple = [&](Dbt& kv) {
+            int put_ret = pdb->put(NULL, &kv, &unused_data, DB_MULTIPLE_KEY);
+            if (put_ret != 0) {
+                throw DbException(("cannot write " + db_name).c_str(), put_ret);
+            }
+        };
+        auto builder = unique_ptr<DbMultipleKeyDataBuilder>(new DbMultipleKeyDataBuilder(multiple_kv));
+        bool buffer_empty = true;
+        for (auto& entry : entries) {
+            // same layout as dbstl::db_map<int, string>: raw int key, null terminated string value
+            if (!builder->append(&entry.first, sizeof(int), (void *) entry.second.c_str(),
+                                 entry.second.length() + 1)) {
+                put_multiple(multiple_kv);
+                builder.reset(new DbMultipleKeyDataBuilder(multiple_kv));
+                builder->append(&entry.first, sizeof(int), (void *) entry.second.c_str(), entry.second.length() + 1);
+            }
+            buffer_empty = false;
+        }
+        if (!buffer_empty) {
+            put_multiple(multiple_kv);
         }
+        pdb.reset();
         env.close(0);
     } catch (DbException& e) {
         cerr << "DbException: " << e.what() << endl;
-    } catch (std::exception& e) {
-        cerr << e.what() << endl;
+        reset_index_dbs();
+        throw;
     }
+    reset_index_dbs();
 }
 
-void IndexManager::save_all_years_for_documents_to_db() {
-    DbEnv env(DB_CXX_NO_EXCEPTIONS);
-    Db* pdb;
-    try {
-        env.open((index_dir + "/db").c_str(), DB_CREATE | DB_INIT_MPOOL, 0);
-        pdb = new Db(&env, DB_CXX_NO_EXCEPTIONS);
-        pdb->open(NULL, "doc_map.db", NULL, DB_BTREE, DB_CREATE, 0);
-        typedef dbstl::db_map<int, string> HugeMap;
-        HugeMap huge_map(pdb, &env);
-        Collection<IndexReaderPtr> subReaders = get_subreaders(QueryType::document, false);
-        MultiReaderPtr multireader = newLucene<MultiReader>(subReaders, false);
-        FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"year"}));
-        for (int i = 0; i < multireader->maxDoc(); i++) {
-            String year = multireader->document(i, fsel)->get(L"year");
-            huge_map[i] = string(year.begin(), year.end());
+void IndexManager::save_all_doc_ids_for_sentences_to_db() {
+    MultiReaderPtr multireader = open_multireader(QueryType::sentence, false);
+    FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"doc_id", L"year"}));
+    vector<pair<int, string>> entries;
+    entries.reserve(multireader->maxDoc());
+    for (int i = 0; i < multireader->maxDoc(); i++) {
+        if (multireader->isDeleted(i)) {
+            continue;
         }
-        if (pdb != NULL) {
-            pdb->close(0);
-            delete pdb;
+        DocumentPtr doc = multireader->document(i, fsel);
+        String doc_id = doc->get(L"doc_id");
+        String year = doc->get(L"year");
+        entries.emplace_back(i, string(doc_id.begin(), doc_id.end()) + "|" + string(year.begin(), year.end()));
+    }
+    multireader->close();
+    bulk_load_db_map("sent_map.db", entries);
+}
+
+void IndexManager::save_all_years_for_documents_to_db() {
+    MultiReaderPtr multireader = open_multireader(QueryType::document, false);
+    FieldSelectorPtr fsel = newLucene<LazySelector>(set<String>({L"year"}));
+    vector<pair<int, string>> entries;
+    entries.reserve(multireader->maxDoc());
+    for (int i = 0; i < multireader->maxDoc(); i++) {
+        if (multireader->isDeleted(i)) {
+            continue;
         }
-        env.close(0);
-    } catch (DbException& e) {
-        cerr << "DbException: " << e.what() << endl;
-    } catch (std::exception& e) {
-        cerr << e.what() << endl;
+        String year = multireader->document(i, fsel)->get(L"year");
+        entries.emplace_back(i, string(year.begin(), year.end()));
     }
+    multireader->close();
+    bulk_load_db_map("doc_map.db", entries);
 }
 
 void IndexManager::set_external_index(std::string external_idx_path) {
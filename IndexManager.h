@@ -13,8 +13,17 @@
 #include <string>
 #include <lucene++/LuceneHeaders.h>
 #include <cfloat>
+#include <ctime>
+#include <memory>
+#include <mutex>
 #include "CASManager.h"
 #include "DataStructures.h"
+#include "CategoryDictionary.h"
+#include "SentenceBlock.h"
+
+namespace uima {
+    class AnalysisEngine;
+}
 
 namespace tpc {
 
@@ -33,6 +42,20 @@ namespace tpc {
         static const int MAX_NUM_SENTENCES_IN_QUERY(200);
         static const int MAX_NUM_DOCIDS_IN_QUERY(200);
 
+        static const uint32_t BDB_BULK_CACHE_SIZE(256 * 1024 * 1024);
+        static const uint32_t BDB_BULK_PAGE_SIZE(64 * 1024);
+        static const size_t BDB_BULK_BUFFER_SIZE(16 * 1024 * 1024);
+        // maximum number of lookups per db when warming up the dbs of an index
+        static const uint32_t BDB_WARM_UP_MAX_PROBES(4096);
+        // size of the memory pool of the dbs opened for searches
+        static const uint32_t BDB_SEARCH_CACHE_SIZE(64 * 1024 * 1024);
+
+        static const std::string INDEX_MANIFEST_FILENAME("manifest.tsv");
+        static const std::string CONTENT_HASH_DB_NAME("hash_map.db");
+        static const std::string INDEX_GENERATION_PREFIX("gen_");
+        static const std::string CURRENT_INDEX_GENERATION_LINK("current");
+        static const int INDEX_CHECKPOINT_NUM_FILES(1000);
+
         static const std::set<std::string> INDEX_TYPES{DOCUMENT_INDEXNAME, SENTENCE_INDEXNAME, DOCUMENT_INDEXNAME_CS,
                                                        SENTENCE_INDEXNAME_CS};
         static const std::string SUBINDEX_NAME = "subindex";
@@ -42,23 +65,62 @@ namespace tpc {
                                                                     "corpus", "doc_id",
                                                                     "fulltext_compressed", "type_compressed",
                                                                      "fulltext_cat_compressed"};
+        static const std::set<Lucene::String> INDEXED_FIELDS_FROM_COMPRESSED{L"fulltext", L"fulltext_cat", L"author",
+                                                                           L"accession", L"type", L"title",
+                                                                           L"journal", L"sentence", L"sentence_cat"};
+        static const std::set<Lucene::String> SENTENCE_BIB_FIELDS{L"author", L"accession", L"type", L"title",
+                                                                L"journal", L"citation", L"corpus"};
         static const std::set<std::string> SENTENCE_FIELDS_DETAILED{"sentence_id", "begin", "end",
                                                                     "sentence_compressed", "sentence_cat_compressed"};
 
         /*!
          * @struct TmpConf
-         * @brief data structure that represents information about temporary configuration files of an index
+         * @brief data structure that represents the temporary configuration of a subindex
          *
-         * @var <b>new_index_flag</b> location of file which, if exists, indicates that a new index must be created
-         * @var <b>index_descriptor</b> the location of the descriptor file for the index
-         * @var <b>tmp_dir</b> the temporary directory where the configuration is stored
+         * @var <b>new_index</b> whether the next engine for the subindex must create a new index
+         * @var <b>index_descriptor</b> the in-memory descriptor of the engines that add files to the subindex
+         * @var <b>new_index_descriptor</b> the in-memory descriptor of the engine that creates the subindex
+         * @var <b>tmp_dir</b> the temporary directory where the bibliography files are stored during indexing
          */
         struct TmpConf {
-            std::string new_index_flag;
+            bool new_index{false};
             std::string index_descriptor;
+            std::string new_index_descriptor;
             std::string tmp_dir;
         };
 
+        /*!
+         * @struct ManifestEntry
+         * @brief data structure that represents a file recorded in the manifest of an index
+         *
+         * @var <b>identifier</b> the identifier of the file, in the form literature/paper/filename
+         * @var <b>size</b> the size of the file at the time it was indexed
+         * @var <b>mtime</b> the last modification time of the file at the time it was indexed
+         * @var <b>content_hash</b> the tpfnv hash of the text of the file, as in the content hash registry
+         * @var <b>doc_id</b> the doc_id assigned to the file in the index
+         * @var <b>subindex</b> the name of the subindex containing the file
+         */
+        struct ManifestEntry {
+            std::string identifier;
+            uintmax_t size;
+            std::time_t mtime;
+            std::string content_hash;
+            std::string doc_id;
+            std::string subindex;
+        };
+
+        /*!
+         * @struct DbCacheStats
+         * @brief data structure that represents the statistics of the memory pool of the dbs used by searches
+         *
+         * @var <b>cache_hits</b> the number of pages found in the memory pool
+         * @var <b>cache_misses</b> the number of pages read from the db files
+         */
+        struct DbCacheStats {
+            uint64_t cache_hits{0};
+            uint64_t cache_misses{0};
+        };
+
         class tpc_exception : public std::runtime_error {
         public:
             explicit tpc_exception(char const* const message) throw(): std::runtime_error(message) { }
@@ -85,43 +147,66 @@ namespace tpc {
                     external(external),
                     readers_map(),
                     corpus_doc_counter(),
-                    externalIndexManager() { };
+                    externalIndexManager(),
+                    writer_options(),
+                    pipeline_options() {
+                std::shared_ptr<CategoryDictionary> dictionary = std::make_shared<CategoryDictionary>();
+                dictionary->load(index_dir + "/" + CATEGORY_DICTIONARY_FILENAME);
+                category_dictionary = dictionary;
+            };
             ~IndexManager() {
                 close();
             };
             IndexManager(const IndexManager& other) {
                 readers_map = other.readers_map;
+                index_dbs = other.index_dbs;
                 index_dir = other.index_dir;
                 readonly = other.readonly;
                 external = other.external;
                 corpus_doc_counter = other.corpus_doc_counter;
                 externalIndexManager = other.externalIndexManager;
+                writer_options = other.writer_options;
+                pipeline_options = other.pipeline_options;
+                category_dictionary = other.category_dictionary;
             };
             IndexManager& operator=(const IndexManager& other) {
                 readers_map = other.readers_map;
+                index_dbs = other.index_dbs;
                 index_dir = other.index_dir;
                 readonly = other.readonly;
                 external = other.external;
                 corpus_doc_counter = other.corpus_doc_counter;
                 externalIndexManager = other.externalIndexManager;
+                writer_options = other.writer_options;
+                pipeline_options = other.pipeline_options;
+                category_dictionary = other.category_dictionary;
             };
             IndexManager(IndexManager&& other) noexcept :
                     readers_map(std::move(other.readers_map)),
+                    index_dbs(std::move(other.index_dbs)),
                     readonly(other.readonly),
                     external(other.external),
                     index_dir(std::move(other.index_dir)),
                     corpus_doc_counter(std::move(other.corpus_doc_counter)),
-                    externalIndexManager(std::move(other.externalIndexManager)) {}
+                    externalIndexManager(std::move(other.externalIndexManager)),
+                    writer_options(other.writer_options),
+                    pipeline_options(other.pipeline_options),
+                    category_dictionary(std::move(other.category_dictionary)) {}
             IndexManager& operator=(IndexManager&& other) noexcept {
                 readers_map = std::move(other.readers_map);
+                index_dbs = std::move(other.index_dbs);
                 index_dir = std::move(other.index_dir);
                 readonly = other.readonly;
                 external = other.external;
                 corpus_doc_counter = std::move(other.corpus_doc_counter);
                 externalIndexManager = std::move(other.externalIndexManager);
+                writer_options = other.writer_options;
+                pipeline_options = other.pipeline_options;
+                category_dictionary = std::move(other.category_dictionary);
             };
 
             void close() {
+                std::lock_guard<std::mutex> lock(state_mutex);
                 for (auto &it : readers_map) {
                     it.second->close();
                 }
@@ -139,6 +224,13 @@ namespace tpc {
              */
             std::vector<std::string> get_additional_corpora();
 
+            /*!
+             * return the dictionary of the categories of the lexical annotations in the index, stored at the root of
+             * the index and shared by all the subindexes
+             * @return the category dictionary of the index, empty if the index has no dictionary
+             */
+            CategoryDictionary get_category_dictionary() const;
+
             /*!
              * return the number of articles indexed under a specific corpus
              * @param corpus the value of the corpus
@@ -175,6 +267,27 @@ namespace tpc {
                                            const std::set<std::string> &doc_ids = {},
                                            const SearchResults& partialResults = SearchResults());
 
+            /*!
+             * @brief get the ranges of characters of the text of a set of documents or sentences that match the terms
+             * of a query, to be used for highlighting
+             *
+             * The ranges are read from the term vectors of the fulltext or sentence field, which are stored only if the
+             * index has been created with IndexWriterOptions::store_term_vectors set, so that the text does not need to
+             * be analyzed again. Wildcard and fuzzy queries are expanded to the matching terms of the index, while
+             * each term of a phrase query is matched separately. Offsets are character positions in the text stored
+             * in the fulltext_compressed field for document queries and in the sentence_compressed field for sentence
+             * queries, that is DocumentDetails::fulltext and SentenceDetails::sentence_text as returned by
+             * get_documents_details with remove_tags and remove_newlines set to false
+             * @param query the query object used for the search. Only the type, the case sensitivity and the keywords
+             * of the query are used
+             * @param lucene_internal_ids the Lucene internal ids of the documents or sentences returned by
+             * IndexManager::search_documents for the query
+             * @return the match ranges for each id in the same order as the ids, sorted by their position in the text.
+             * The list is empty for documents without term vectors
+             */
+            std::vector<std::vector<MatchRange>> get_match_ranges(const Query& query,
+                                                                  const std::vector<int>& lucene_internal_ids);
+
             /*!
              * @brief get detailed information about a document specified by a DocumentSummary object
              *
@@ -261,13 +374,136 @@ namespace tpc {
             }
 
             /*!
-             * create a textpresso index from a set of cas files
+             * set the tuning options of the index writers used to add files to the index
+             * @param options the writer options
+             */
+            void set_index_writer_options(const IndexWriterOptions& options) {
+                writer_options = options;
+            }
+
+            /*!
+             * set the number of threads and the queue sizes of the pipeline used to add files to the index
+             * @param options the pipeline options
+             */
+            void set_indexing_pipeline_options(const IndexingPipelineOptions& options) {
+                pipeline_options = options;
+            }
+
+            /*!
+             * merge the segments of each subindex, writing compound files
+             * @param max_num_segments the max number of segments of each subindex after the merge
+             */
+            void merge_subindex_segments(int max_num_segments);
+
+            /*!
+             * rebuild the index in a new directory from the fields stored in the subindexes, without reading the cas
+             * files. The indexed fields are regenerated from their compressed stored version and the bib fields of the
+             * sentences are taken from their documents. Deleted documents are dropped and the dbs of the new index are
+             * rebuilt. Analyzer changes are applied through the analyzers parameter, field layout changes through
+             * IndexManager::rebuild_document_from_stored_fields
+             * @param output_index_dir the directory of the new index
+             * @param analyzers the analyzers to use for each index type (fulltext, fulltext_cs, sentence,
+             * sentence_cs). The default analyzers are used for the types not in the map
+             */
+            void reindex_from_stored_fields(const std::string& output_index_dir,
+                                            const std::map<std::string, Lucene::AnalyzerPtr>& analyzers = {});
+
+            /*!
+             * get the number of segments of each index in the subindexes
+             * @return a map with the number of segments for each index, in the form subindex_N/index_type
+             */
+            std::map<std::string, int> get_num_segments_per_subindex();
+
+            /*!
+             * create a new empty index generation under a root directory. Generations are complete indexes stored
+             * in the gen_N subdirectories of the root and the one being served is pointed by the current symbolic
+             * link, so that a new index can be built while the previous one is still in use
+             * @param root_dir the root directory of the generations
+             * @return the path of the new generation
+             */
+            static std::string create_index_generation(const std::string& root_dir);
+
+            /*!
+             * get the index generations available under a root directory
+             * @param root_dir the root directory of the generations
+             * @return the paths of the generations, sorted by generation number
+             */
+            static std::vector<std::string> get_index_generations(const std::string& root_dir);
+
+            /*!
+             * get the generation pointed by the current link of a root directory
+             * @param root_dir the root directory of the generations
+             * @return the path of the current generation, or an empty string if no generation has been published
+             */
+            static std::string get_current_index_generation(const std::string& root_dir);
+
+            /*!
+             * make a generation the current one. The current link is replaced atomically, so that processes opening
+             * the index through the link always see a complete generation
+             * @param root_dir the root directory of the generations
+             * @param generation_path the path of the generation to publish
+             */
+            static void publish_index_generation(const std::string& root_dir, const std::string& generation_path);
+
+            /*!
+             * delete an old generation. The current generation cannot be removed
+             * @param root_dir the root directory of the generations
+             * @param generation_path the path of the generation to remove
+             */
+            static void remove_index_generation(const std::string& root_dir, const std::string& generation_path);
+
+            /*!
+             * switch the index manager to a different index. The readers and the dbs of the new index are opened and
+             * warmed up before the switch, so that the first searches on the new index do not pay for cold caches,
+             * and then replace the ones of the previous index in a single step. Searches can run in other threads
+             * during the switch: a search that started on the previous index keeps its readers and dbs, which are
+             * closed when the last search using them ends. Methods that modify the index must not run during the
+             * switch
+             * @param index_path the path of the new index
+             */
+            void switch_to_index(const std::string& index_path);
+
+            /*!
+             * switch the index manager to the current generation of a root directory, if it is not already in use
+             * @param root_dir the root directory of the generations
+             * @return true if the index manager has been switched to a new generation, false otherwise
+             */
+            bool switch_to_current_index_generation(const std::string& root_dir);
+
+            /*!
+             * get the statistics of the memory pool of the document and sentence dbs opened for searches
+             * @return the statistics, with zero hits and misses if the dbs have not been opened
+             */
+            DbCacheStats get_db_cache_stats();
+
+            /*!
+             * add the categories of a lexicon file to the category dictionary of the index and store it at the root of
+             * the index. The methods that add files to the index already build the dictionary from the lexicon of the
+             * lexicon annotator, this method adds the categories of other lexicons. Categories already in the
+             * dictionary keep their ids and only the new categories of the lexicon are appended
+             * @param lexicon_file the lexicon file, with one term and its category per line separated by a tab
+             */
+            void create_category_dictionary(const std::string& lexicon_file);
+
+            /*!
+             * create a textpresso index from a set of cas files. The input directory is enumerated by a parallel
+             * directory walker while the files already found are indexed. Files are committed to the index in
+             * checkpoints of INDEX_CHECKPOINT_NUM_FILES files and each checkpoint is recorded in a manifest file in the
+             * index directory, so that an interrupted run can be resumed. If the max_num_segments writer option is set,
+             * the segments of the subindexes are merged at the end of the run. The categories of the lexicon annotator
+             * are added to the category dictionary of the index before any file is indexed
              * @param input_cas_dir the directory containing the cas files to be added to the index
+             * @param file_list the list of papers (literature/paper) to add. Add all the papers if empty
              * @param max_num_papers_per_subindex max number of papers per subindex
+             * @param resume whether to resume a previous run, skipping the files recorded in its manifest. Files whose
+             * size or modification time differ from their manifest entry are removed from the index and indexed again.
+             * If false, a new manifest is created
+             * @throw std::runtime_error if the input directory does not exist or cannot be listed
              */
             void create_index_from_existing_cas_dir(const std::string &input_cas_dir,
                                                     const std::set<std::string>& file_list = {},
-                                                    int max_num_papers_per_subindex = 50000);
+                                                    int max_num_papers_per_subindex = 50000,
+                                                    bool resume = false);
 
             /*!
              * add a file to a textpresso index
@@ -277,6 +513,39 @@ namespace tpc {
              */
             void add_file_to_index(const std::string& file_path, int max_num_papers_per_subindex = 50000);
 
+            /*!
+             * add a list of files to a textpresso index. Files whose content hash is already in the content hash
+             * registry of the index are skipped before they are indexed, as well as files that cannot be read, such as
+             * corrupted gzip files. The other files are indexed through a single writer session per subindex, their
+             * entries are written to the db in a single session and the readers are invalidated once. The categories of
+             * the lexicon annotator are added to the category dictionary of the index before the files are indexed
+             * @param file_paths the paths to the compressed cas files
+             * @param max_num_papers_per_subindex max number of papers per subindex
+             */
+            void add_files_to_index(const std::vector<std::string>& file_paths,
+                                    int max_num_papers_per_subindex = 50000);
+
+            /*!
+             * convert raw articles to cas and add them to the index in a single process. Each article is tokenized,
+             * annotated with the lexicon and indexed by one aggregate engine on the same in-memory cas, without
+             * writing or reading intermediate tpcas files. The bib file of an article is read from the directory of
+             * the raw file (filename.bib) and, for xml articles, it is generated from the xml text if not available.
+             * Articles with the same text as a document already in the content hash registry are skipped, and the
+             * content hashes of the new documents are added to the registry. The categories of the lexicon annotator
+             * are added to the category dictionary of the index before the articles are indexed
+             * @param file_paths the paths to the raw files, in the form paper/filename.pdf or paper/filename.nxml
+             * @param type the type of the raw files
+             * @param literature the literature of the articles
+             * @param archive_cas_dir the directory where the archival compressed cas files and their bib files are
+             * written, in the form literature/paper/filename.tpcas.gz. No cas files are written if empty
+             * @param max_num_papers_per_subindex max number of papers per subindex
+             * @param archive_cas_format the serialization format of the archival cas files
+             */
+            void add_raw_files_to_index(const std::vector<std::string>& file_paths, tpc::cas::FileType type,
+                                        const std::string& literature, const std::string& archive_cas_dir = "",
+                                        int max_num_papers_per_subindex = 50000,
+                                        tpc::cas::CasFormat archive_cas_format = tpc::cas::CasFormat::xmi);
+
             /*!
              * remove a specific file from the index
              * @param identifier the id of the file to remove, currently represented by the filepath field stored in
@@ -290,12 +559,16 @@ namespace tpc {
             void calculate_and_save_corpus_counter();
 
             /*!
-             * create an external database for sentences containing their document ids
+             * create an external database for sentences containing their document ids. The stored fields of each
+             * sentence are read once and the database is rebuilt with a single bulk load
+             * @throw DbException if the database cannot be written
              */
             void save_all_doc_ids_for_sentences_to_db();
 
             /*!
-             * create an external database for documents containing their year field
+             * create an external database for documents containing their year field. The stored fields of each
+             * document are read once and the database is rebuilt with a single bulk load
+             * @throw DbException if the database cannot be written
              */
             void save_all_years_for_documents_to_db();
 
@@ -324,35 +597,102 @@ namespace tpc {
 
         private:
 
+            class IndexDbs;
+
             /*!
-             * create a collection of sub-readers with multiple Lucene indexes
+             * create a collection of sub-readers with multiple Lucene indexes. Must be called with state_mutex held
              * @param type the type of query to be performed by the subreaders
              * @param case_sensitive whether to get case sensitive subreaders
              * @return a collection of readers created from the Lucene indexes
              */
             Lucene::Collection<Lucene::IndexReaderPtr> get_subreaders(QueryType type, bool case_sensitive = false);
 
+            /*!
+             * create a multireader on the subreaders of the index. The multireader holds a reference to each
+             * subreader until it is closed, so that a switch to another index does not close the subreaders under a
+             * running search
+             * @param type the type of query to be performed by the subreaders
+             * @param case_sensitive whether to get case sensitive subreaders
+             * @param dbs if not null, set to the dbs of the same index as the multireader
+             * @return the multireader, to be closed by the caller
+             */
+            Lucene::MultiReaderPtr open_multireader(QueryType type, bool case_sensitive = false,
+                                                    std::shared_ptr<IndexDbs>* dbs = nullptr);
+
+            /*!
+             * get the document and sentence dbs of the index, opening them at the first call
+             * @return the dbs, shared with the other searches on the index
+             */
+            std::shared_ptr<IndexDbs> get_index_dbs();
+
+            /*!
+             * close the dbs opened for searches, so that they are opened again after the dbs have been modified
+             */
+            void reset_index_dbs();
+
+            std::string get_index_dir() const;
+
+            std::shared_ptr<const CategoryDictionary> get_current_category_dictionary() const;
+
+            /*!
+             * add to the category dictionary of the index the categories assigned by a lexicon annotator, read from
+             * the postgres table or the lexicon file set in its descriptor, and store the dictionary at the root of the
+             * index. Categories already in the dictionary keep their ids. If the lexicon cannot be read, the
+             * dictionary is stored unchanged and the categories that are not in it are indexed by name
+             * @param annotator_descriptor the descriptor of the lexicon annotator
+             */
+            void update_category_dictionary(
+                    const std::string& annotator_descriptor = tpc::cas::TPCAS1_2_TPCAS2_DESCRIPTOR);
+
+            /*!
+             * store a category dictionary at the root of the index and use it to decode the categories of the index
+             * @param dictionary the category dictionary
+             */
+            void save_category_dictionary(const CategoryDictionary& dictionary);
+
+            /*!
+             * create a numeric range query on the year field
+             * @param year a single year (e.g., 2017) or a range of years with its bounds included (e.g., 2000-2010 or
+             * 2000 TO 2010)
+             * @return the query, or a null pointer if the year is empty
+             * @throws tpc_exception if the year is not in one of the supported formats
+             */
+            static Lucene::QueryPtr get_year_query(const std::string& year);
+
+            /*!
+             * open the readers of all the indexes in the subindexes of an index and load their norms
+             * @param index_path the path of the index
+             * @param read_only whether the readers should be opened in read-only mode
+             * @return the readers, with the same keys used by IndexManager::get_subreaders
+             */
+            static std::map<std::string, Lucene::IndexReaderPtr> open_warm_subreaders(const std::string& index_path,
+                                                                                      bool read_only);
+
             /*!
              * collect and return document basic information for a collection of matches obtained from a document search
              * @param matches_collection the collection of documents matching the search query
              * @param subreaders the readers used during the search
              * @param searcher the searcher used during the search
+             * @param dbs the dbs of the index that has been searched, or null for the current dbs of the index manager
              * @return the list of Document objects with information related to the matching documents, encapsulated in a
              * SearchResult object
              */
             SearchResults read_documents_summaries(const Lucene::Collection<Lucene::ScoreDocPtr> &matches_collection,
-                                                   bool sort_by_year = false);
+                                                   bool sort_by_year = false,
+                                                   std::shared_ptr<IndexDbs> dbs = nullptr);
 
             /*!
              * collect and return document information for a collection of matches obtained from a sentence search
              * @param matches_collection the collection of sentences matching the search query
              * @param subreaders the readers used during the search
              * @param searcher the searcher used during the search
+             * @param dbs the dbs of the index that has been searched, or null for the current dbs of the index manager
              * @return the list of Document objects with information related to the matching sentences and their respective
              * documents, encapsulated in a SearchResult object
              */
             SearchResults read_sentences_summaries(const Lucene::Collection<Lucene::ScoreDocPtr> &matches_collection,
-                                                   bool sort_by_year = false);
+                                                   bool sort_by_year = false,
+                                                   std::shared_ptr<IndexDbs> dbs = nullptr);
 
             /*!
              * get detailed information for the sentences of a document specifed by a DocumentSummary object and update the
@@ -364,6 +704,7 @@ namespace tpc {
              * @param searcher a Lucene searcher
              * @param fsel a Lucene field selector
              * @param fields the set of fields to be retrieved for the sentences
+             * @param doc_searcher a Lucene searcher on the document index, used to read the sentence blocks
              * @return the details of the document
              */
             void update_match_sentences_details_for_document(const DocumentSummary &doc_summary,
@@ -373,7 +714,8 @@ namespace tpc {
                                                              Lucene::FieldSelectorPtr fsel,
                                                              const std::set<Lucene::String> &fields,
                                                              bool use_lucene_internal_ids,
-                                                             Lucene::MultiReaderPtr sent_reader);
+                                                             Lucene::MultiReaderPtr sent_reader,
+                                                             Lucene::SearcherPtr doc_searcher);
 
             /*!
              * get detailed information for the complete sentences list for a document specifed by a DocumentSummary
@@ -384,11 +726,13 @@ namespace tpc {
              * @param fsel a Lucene field selector
              * @param fields the set of fields to be retrieved for the sentences
              * @param internal_lucene_ids whether internal lucene ids are used for the search
+             * @param doc_searcher a Lucene searcher on the document index, used to read the sentence blocks
              * @return the details of the document
              */
             void update_all_sentences_details_for_document(DocumentDetails &doc_details,
                                                            Lucene::FieldSelectorPtr fsel,
-                                                           const std::set<Lucene::String> &fields);
+                                                           const std::set<Lucene::String> &fields,
+                                                           Lucene::SearcherPtr doc_searcher);
 
             static std::set<Lucene::String> compose_field_set(const std::set<std::string> &include_fields,
                                                               const std::set<std::string> &exclude_fields,
@@ -397,6 +741,31 @@ namespace tpc {
             void update_document_details(DocumentDetails &doc_details, Lucene::String field,
                                          Lucene::DocumentPtr doc_ptr);
 
+            /*!
+             * update a field of the details of a sentence, reading the text and the categories from the sentence
+             * document or, for indexes created in sentence block mode, from the sentence block of its document
+             * @param sentence_details the details to update
+             * @param field the name of the field
+             * @param sent_doc the sentence document, with the sentence_id field loaded
+             * @param doc_id the id of the document of the sentence
+             * @param doc_searcher a Lucene searcher on the document index, used to read the sentence block
+             * @param sentence_block the sentence block of the document, read at the first access if null
+             */
+            void update_sentence_details(SentenceDetails& sentence_details, const Lucene::String& field,
+                                         const Lucene::DocumentPtr& sent_doc, const std::string& doc_id,
+                                         const Lucene::SearcherPtr& doc_searcher,
+                                         std::shared_ptr<SentenceBlock>& sentence_block);
+
+            /*!
+             * read the sentence block of a document indexed in sentence block mode
+             * @param doc_id the id of the document
+             * @param doc_searcher a Lucene searcher on the document index that contains the document
+             * @param sentence_block the block to fill, left empty if the document does not have a sentence block
+             * @return whether the document has a sentence block
+             */
+            static bool read_sentence_block(const std::string& doc_id, const Lucene::SearcherPtr& doc_searcher,
+                                            SentenceBlock& sentence_block);
+
             std::vector<DocumentDetails> read_documents_details(const std::vector<DocumentSummary> &doc_summaries,
                                                                 Lucene::QueryParserPtr doc_parser,
                                                                 Lucene::SearcherPtr searcher,
@@ -437,11 +806,13 @@ namespace tpc {
             }
 
             /*!
-             * write the temporary conf files for a subindex with the UIMA files needed
+             * create the temporary configuration for a subindex. The UIMA descriptors are generated once in memory and
+             * reused by all the engines that write to the subindex
              * @param index_path the output directory of the subindex
-             * @return a TmpConf object representing the information about the newly created files
+             * @param new_index whether the first engine must create a new subindex
+             * @return a TmpConf object representing the temporary configuration
              */
-            static TmpConf write_tmp_conf_files(const std::string &index_path);
+            TmpConf create_tmp_conf(const std::string &index_path, bool new_index = false);
 
             /*!
              * create the directory structure for a subindex
@@ -450,32 +821,199 @@ namespace tpc {
             static void create_subindex_dir_structure(const std::string &index_path);
 
             /*!
-             * add a cas file to the index. The cas file is processed through UIMA engine to extract sentences and other
-             * features to be added to the index
-             * @param file_path the path of the cas file to be added to the index
-             * @param index_descriptor the index descriptor location
-             * @param temp_dir the temp dir location
-             * @param update_db whether to update the db with the new entry
+             * add a list of cas files to the same subindex through a single UIMA engine, so that all the files are
+             * written by the same index writers and committed once. Files are read and decompressed, deserialized and
+             * indexed by a pipeline of stages connected by bounded queues, configured by the pipeline options. Files
+             * are indexed in the order of the list whatever the number of threads, and files with the same content hash
+             * of a file already in the registry or of a previous file in the list are skipped. If indexing throws, the
+             * pipeline threads are stopped and joined before the exception is propagated. The content hash of a file
+             * is read from the tpfnvhash annotation of its deserialized cas, and files that cannot be read, such as
+             * corrupted gzip files, are skipped
+             * @param file_paths the paths of the cas files to be added to the index
+             * @param tmp_conf the temporary configuration of the subindex, updated once the subindex has been created
+             * @param content_hashes the content hash registry, updated with the hashes of the new files
+             * @return the files that have been added to the index, with their content hash. Skipped files, files
+             * without text and files that failed in the engine are not returned
+             */
+            std::vector<std::pair<std::string, std::string>> add_cas_files_to_index(
+                    const std::vector<std::string>& file_paths, TmpConf& tmp_conf,
+                    std::map<std::string, std::string>& content_hashes);
+
+            /*!
+             * convert a list of raw articles and add them to the same subindex through a single aggregate UIMA engine.
+             * Raw files are converted to text streams by parallel threads while the engine processes the streams.
+             * Streams with the same content hash of a document in the registry are skipped before the engine runs. If
+             * indexing throws, the threads are stopped and joined before the exception is propagated
+             * @param file_paths the paths to the raw files
+             * @param type the type of the raw files
+             * @param literature the literature of the articles
+             * @param archive_cas_dir the directory of the archival cas files, or empty if not needed
+             * @param archive_cas_format the serialization format of the archival cas files
+             * @param tmp_conf the temporary configuration of the subindex, updated once the subindex has been created
+             * @param content_hashes the content hash registry, updated with the hashes of the new documents
+             * @return the identifiers of the documents that have been added to the index
+             */
+            std::vector<std::string> add_raw_files_to_subindex(const std::vector<std::string>& file_paths,
+                                                               tpc::cas::FileType type, const std::string& literature,
+                                                               const std::string& archive_cas_dir,
+                                                               tpc::cas::CasFormat archive_cas_format,
+                                                               TmpConf& tmp_conf,
+                                                               std::map<std::string, std::string>& content_hashes);
+
+            /*!
+             * get the number of the last subindex of the index
+             * @return the largest subindex number, 0 if the index has no subindexes
+             */
+            int get_largest_subindex_num() const;
+
+            /*!
+             * create the UIMA engine that writes cas files to a subindex from an in-memory descriptor, without
+             * accessing the filesystem
+             * @param index_descriptor the xml content of the index descriptor
+             * @return the new engine
+             */
+            static uima::AnalysisEngine* create_index_engine(const std::string& index_descriptor);
+
+            /*!
+             * complete the processing of an index engine, commit its writers and free it
+             * @param engine the engine to destroy
              */
-            int add_cas_file_to_index(const char *file_path, std::string index_descriptor, std::string tempDir,
-                                      bool update_db);
+            static void destroy_index_engine(uima::AnalysisEngine* engine);
 
             /*!
-             * process a single file to be added to the index, calling the appropriate UIMA annotator
-             * @param filepath the path of the file
-             * @param first_paper whether the file is the first one to add to the subindex
-             * @param tmp_conf the temporary configuration file names
-             * @param update_db whether to update the entries in the db
-             * @return true if the file was valid and it has been processed correctly, false otherwise
+             * get the identifier of a cas file, in the form literature/paper/filename, as stored in the index
+             * @param file_path the path of the cas file
+             * @return the identifier of the file
              */
-            bool process_single_file(const std::string &filepath, bool &first_paper, const TmpConf &tmp_conf,
-                                     bool update_db = false);
+            static std::string get_file_identifier(const std::string& file_path);
+
+            /*!
+             * read the manifest of the files added to the index by create_index_from_existing_cas_dir
+             * @return the manifest entries, indexed by file identifier
+             */
+            std::map<std::string, ManifestEntry> read_manifest() const;
+
+            /*!
+             * create the manifest entry for a file that has been added to the index
+             * @param file_path the path of the cas file
+             * @param doc_id the doc_id assigned to the file in the index
+             * @param subindex the name of the subindex containing the file
+             * @param content_hash the content hash of the file
+             * @return the manifest entry
+             */
+            static ManifestEntry create_manifest_entry(const std::string& file_path, const std::string& doc_id,
+                                                       const std::string& subindex, const std::string& content_hash);
+
+            /*!
+             * append a list of entries to the manifest file
+             * @param entries the entries to append
+             * @param manifest the in-memory manifest to be updated with the new entries
+             */
+            void write_manifest_entries(const std::vector<ManifestEntry>& entries,
+                                        std::map<std::string, ManifestEntry>& manifest);
+
+            /*!
+             * record in the manifest a list of files that have been committed to a subindex
+             * @param files the paths of the cas files, with their content hash
+             * @param subindex_dir the directory of the subindex containing the files
+             * @param manifest the in-memory manifest to be updated with the new entries
+             */
+            void append_to_manifest(const std::vector<std::pair<std::string, std::string>>& files,
+                                    const std::string& subindex_dir, std::map<std::string, ManifestEntry>& manifest);
+
+            /*!
+             * get the files that are present in the subindexes, e.g., to find the files committed by a run that died
+             * before recording them in the manifest
+             * @return a map with the doc_id and the subindex of each file, by filepath (literature/paper/filename)
+             */
+            std::map<std::string, std::pair<std::string, std::string>> get_indexed_files();
 
             std::string remove_document_from_index(std::string identifier, bool case_sensitive);
             void remove_sentences_for_document(const std::string& doc_id, bool case_sensitive);
 
             void add_doc_and_sentences_to_bdb(std::string identifier);
 
+            /*!
+             * add the db entries for a list of documents and their sentences, opening the db environment once
+             * @param identifiers the identifiers of the documents, as returned by IndexManager::get_file_identifier
+             */
+            void add_docs_and_sentences_to_bdb(const std::vector<std::string>& identifiers);
+
+            /*!
+             * load the content hash registry of the index. The registry is stored by file identifier, so that the
+             * entry of a file is removed with a point delete, and it is loaded as a map from the tpfnv hash of the text
+             * of each indexed file to its identifier
+             * @return the registry, by hash
+             */
+            std::map<std::string, std::string> load_content_hashes_from_db() const;
+
+            /*!
+             * add a list of entries to the content hash registry of the index
+             * @param entries the pairs of hash and file identifier
+             */
+            void add_content_hashes_to_db(const std::vector<std::pair<std::string, std::string>>& entries);
+
+            /*!
+             * remove the entry of a file from the content hash registry of the index
+             * @param identifier the identifier of the file
+             */
+            void remove_content_hash_from_db(std::string identifier);
+
+            /*!
+             * apply the writer options to an index writer
+             * @param writer the index writer
+             * @param use_compound_file whether the writer creates compound files
+             */
+            void configure_index_writer(const Lucene::IndexWriterPtr& writer, bool use_compound_file) const;
+
+            /*!
+             * get the categories of the words of a sentence from its stored fields, either in binary format or, for
+             * sentences indexed with previous versions, compressed
+             * @param sentence_doc the sentence document, with the sentence_cat_binary or the sentence_cat_compressed
+             * field loaded
+             * @param category_dictionary the category dictionary of the index
+             * @return the categories of the words as a tab separated string, with NA for words without categories
+             */
+            static std::string get_sentence_categories_string(const Lucene::DocumentPtr& sentence_doc,
+                                                              const CategoryDictionary& category_dictionary);
+
+            /*!
+             * create a new Lucene document from the fields stored in an existing one, with the same layout as the
+             * documents written by Tpcas2SingleIndex
+             * @param stored_doc the document read from the index, with all its stored fields
+             * @param category_dictionary the category dictionary of the index
+             * @param store_term_vectors whether to store term vectors with positions and offsets for the fulltext and
+             * sentence fields
+             * @return the new document, ready to be added to an index
+             * @throw std::runtime_error if the categories payload of the document is corrupted
+             */
+            static Lucene::DocumentPtr rebuild_document_from_stored_fields(const Lucene::DocumentPtr& stored_doc,
+                                                                           const CategoryDictionary& category_dictionary,
+                                                                           bool store_term_vectors = false);
+
+            /*!
+             * add the indexed text and categories fields of a sentence indexed in sentence block mode to a rebuilt
+             * sentence document
+             * @param doc the sentence document
+             * @param stored_sentence the sentence read from the block of its document
+             * @param category_dictionary the category dictionary of the index
+             * @param store_term_vectors whether to store term vectors with positions and offsets for the sentence field
+             * @throw std::runtime_error if the categories payload of the sentence is corrupted
+             */
+            static void add_sentence_fields_from_block(const Lucene::DocumentPtr& doc,
+                                                       const StoredSentence& stored_sentence,
+                                                       const CategoryDictionary& category_dictionary,
+                                                       bool store_term_vectors);
+
+            /*!
+             * replace the content of a db_map<int, string> database in the index db environment with the provided
+             * entries, using Berkeley DB bulk inserts
+             * @param db_name the name of the database file (e.g., doc_map.db)
+             * @param entries the key-value pairs to write. The vector is sorted in place
+             * @throw DbException if the database cannot be opened or written
+             */
+            void bulk_load_db_map(const std::string& db_name, std::vector<std::pair<int, std::string>>& entries);
+
             void save_corpus_counter();
 
             void update_corpus_counter();
@@ -484,14 +1022,30 @@ namespace tpc {
              * load information about the number of documents indexed per corpus from file
              */
             void load_corpus_counter();
+
+            /*!
+             * read the number of documents indexed per corpus from the counter file of an index
+             * @param index_path the path of the index
+             * @param corpus_counter the map to fill
+             * @return whether the index has a counter file
+             */
+            static bool read_corpus_counter(const std::string& index_path, std::map<std::string, int>& corpus_counter);
             int get_num_docs_in_corpus_from_index(const std::string& corpus);
 
+            // the readers, the dbs, the path, the category dictionary and the corpus counter of the index are replaced
+            // by switch_to_index while searches may be running, and are guarded by state_mutex
+            mutable std::mutex state_mutex;
             std::map<std::string, Lucene::IndexReaderPtr> readers_map;
+            std::shared_ptr<IndexDbs> index_dbs;
             std::string index_dir;
             bool readonly;
             bool external;
             std::map<std::string, int> corpus_doc_counter;
             std::shared_ptr<IndexManager> externalIndexManager;
+            IndexWriterOptions writer_options;
+            IndexingPipelineOptions pipeline_options;
+            // read-only copy of the category dictionary of the index, used to decode the stored categories
+            std::shared_ptr<const CategoryDictionary> category_dictionary{std::make_shared<CategoryDictionary>()};
         };
     }
 }
@@ -0,0 +1,101 @@
+/**
+    Project: libtpc
+    File name: SentenceBlock.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "SentenceBlock.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace tpc::index;
+
+namespace {
+
+    void write_varint(string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    uint64_t read_varint(const char*& pos, const char* end) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) {
+                throw runtime_error("corrupted sentence block: unexpected end of data");
+            }
+            auto byte = static_cast<uint8_t>(*pos++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw runtime_error("corrupted sentence block: varint too long");
+    }
+
+    void write_bytes(string& out, const string& bytes) {
+        write_varint(out, bytes.size());
+        out.append(bytes);
+    }
+
+    string read_bytes(const char*& pos, const char* end) {
+        uint64_t size = read_varint(pos, end);
+        if (size > static_cast<uint64_t>(end - pos)) {
+            throw runtime_error("corrupted sentence block: unexpected end of data");
+        }
+        string bytes(pos, size);
+        pos += size;
+        return bytes;
+    }
+}
+
+string SentenceBlock::encode() const {
+    string out;
+    out.push_back(static_cast<char>(SENTENCE_BLOCK_VERSION));
+    write_varint(out, sentences.size());
+    int32_t prev_sentence_id = 0;
+    int32_t prev_begin = 0;
+    for (const StoredSentence& sentence : sentences) {
+        write_varint(out, static_cast<uint32_t>(sentence.sentence_id - prev_sentence_id));
+        write_varint(out, static_cast<uint32_t>(sentence.begin - prev_begin));
+        write_varint(out, static_cast<uint32_t>(sentence.end - sentence.begin));
+        write_bytes(out, sentence.text);
+        write_bytes(out, sentence.categories_payload);
+        prev_sentence_id = sentence.sentence_id;
+        prev_begin = sentence.begin;
+    }
+    return out;
+}
+
+void SentenceBlock::decode(const char* data, size_t size) {
+    clear();
+    const char* pos = data;
+    const char* end = data + size;
+    if (pos == end || static_cast<uint8_t>(*pos++) != SENTENCE_BLOCK_VERSION) {
+        throw runtime_error("corrupted sentence block: unsupported version");
+    }
+    uint64_t num_sentences = read_varint(pos, end);
+    StoredSentence sentence;
+    for (uint64_t i = 0; i < num_sentences; ++i) {
+        sentence.sentence_id += static_cast<int32_t>(read_varint(pos, end));
+        sentence.begin += static_cast<int32_t>(read_varint(pos, end));
+        sentence.end = sentence.begin + static_cast<int32_t>(read_varint(pos, end));
+        sentence.text = read_bytes(pos, end);
+        sentence.categories_payload = read_bytes(pos, end);
+        sentences.push_back(sentence);
+    }
+}
+
+const StoredSentence* SentenceBlock::get_sentence(int32_t sentence_id) const {
+    auto it = lower_bound(sentences.begin(), sentences.end(), sentence_id,
+                          [](const StoredSentence& sentence, int32_t id) { return sentence.sentence_id < id; });
+    if (it == sentences.end() || it->sentence_id != sentence_id) {
+        return nullptr;
+    }
+    return &*it;
+}
@@ -0,0 +1,91 @@
+/**
+    Project: libtpc
+    File name: SentenceBlock.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_SENTENCEBLOCK_H
+#define LIBTPC_SENTENCEBLOCK_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace tpc {
+
+    namespace index {
+
+        static const uint8_t SENTENCE_BLOCK_VERSION = 1;
+
+        /*!
+         * @struct StoredSentence
+         * @brief stored information of a sentence in a sentence block
+         *
+         * @var <b>sentence_id</b> the id of the sentence within its document
+         * @var <b>begin</b> the position of the beginning of the sentence in the document
+         * @var <b>end</b> the position of the end of the sentence in the document
+         * @var <b>text</b> the text of the sentence in utf-8
+         * @var <b>categories_payload</b> the categories of the words of the sentence, encoded as a CategoryPayload
+         */
+        struct StoredSentence {
+            int32_t sentence_id{0};
+            int32_t begin{0};
+            int32_t end{0};
+            std::string text;
+            std::string categories_payload;
+        };
+
+        /*!
+         * @brief binary encoding of the stored fields of all the sentences of a document
+         *
+         * The block is stored in a single field of the fulltext document and compressed as a whole, so that the
+         * sentence documents contain only their indexed fields and the sentences of a paper are retrieved by
+         * decompressing one block. The block contains the format version, the number of sentences and, for each
+         * sentence, the distance of its id and begin position from the previous sentence, its length in the document,
+         * its text and its categories payload. All integers are varint encoded
+         */
+        class SentenceBlock {
+        public:
+            /*!
+             * remove all the sentences from the block
+             */
+            void clear() { sentences.clear(); }
+
+            /*!
+             * add a sentence to the block. Sentences must be added in increasing order of id and position
+             * @param sentence the sentence to add
+             */
+            void add_sentence(const StoredSentence& sentence) { sentences.push_back(sentence); }
+
+            /*!
+             * encode the block
+             * @return the binary block, not compressed
+             */
+            std::string encode() const;
+
+            /*!
+             * decode a binary block
+             * @param data pointer to the binary block
+             * @param size the size of the block
+             * @throw std::runtime_error if the block is corrupted
+             */
+            void decode(const char* data, size_t size);
+
+            /*!
+             * get a sentence by id
+             * @param sentence_id the id of the sentence
+             * @return a pointer to the sentence, or a null pointer if the block does not contain the sentence
+             */
+            const StoredSentence* get_sentence(int32_t sentence_id) const;
+
+            const std::vector<StoredSentence>& get_sentences() const { return sentences; }
+
+        private:
+            std::vector<StoredSentence> sentences;
+        };
+    }
+}
+
+#endif //LIBTPC_SENTENCEBLOCK_H
@@ -9,6 +9,8 @@
 #include "Utils.h"
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <fstream>
+#include <sstream>
+#include <cfloat>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
@@ -68,6 +70,16 @@ string Utils::decompress_gzip(const string& gz_file, const string& tmp_dir) {
     return tempFile;
 }
 
+string Utils::decompress_gzip_to_string(const string& gz_file) {
+    std::ifstream filein(gz_file.c_str(), std::ios_base::in | std::ios_base::binary);
+    boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
+    in.push(boost::iostreams::gzip_decompressor());
+    in.push(filein);
+    stringstream out;
+    boost::iostreams::copy(in, out);
+    return out.str();
+}
+
 wstring Utils::getFulltext(CAS& tcas) {
     UnicodeStringRef usdocref = tcas.getDocumentText();
     wstring ws;
@@ -79,26 +91,108 @@ wstring Utils::getFulltext(CAS& tcas) {
 }
 
 string Utils::gettpfnvHash(CAS& tcas) {
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
+    // the hash annotation is read from its own index, without going through the annotations of the document
+    Type type = tcas.getTypeSystem().getType("org.apache.uima.textpresso.tpfnvhash");
+    if (!type.isValid()) {
+        return "";
+    }
+    ANIterator aait = tcas.getAnnotationIndex(type).iterator();
     aait.moveToFirst();
-    while (aait.isValid()) {
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.tpfnvhash") {
-            Feature fcontent = currentType.getFeatureByBaseName("content");
-            UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
-            return ucontent.asUTF8();
-        }
-        aait.moveToNext();
+    if (!aait.isValid()) {
+        return "";
     }
+    Feature fcontent = type.getFeatureByBaseName("content");
+    UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
+    return ucontent.asUTF8();
+}
+
+std::string Utils::get_raw_file_index_descriptor(const std::string& tokenizer_descriptor,
+                                                 const std::string& lexicon_descriptor,
+                                                 const std::string& index_descriptor,
+                                                 const std::string& category_dictionary_file)
+{
+    // the index descriptor is inlined as a delegate, without its xml declaration
+    std::string index_delegate = index_descriptor;
+    size_t declaration_end = index_delegate.find("?>");
+    if (index_delegate.compare(0, 5, "<?xml") == 0 && declaration_end != std::string::npos) {
+        index_delegate.erase(0, declaration_end + 2);
+    }
+    ostringstream output;
+    output << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>" << endl;
+    output << "<taeDescription xmlns = \"http://uima.apache.org/resourceSpecifier\" >" << endl;
+    output << " <frameworkImplementation > org.apache.uima.cpp</frameworkImplementation>" << endl;
+    output << " <primitive > false </primitive>" << endl;
+    output << " <delegateAnalysisEngineSpecifiers>" << endl;
+    output << "         <delegateAnalysisEngine key = \"Tokenizer\">" << endl;
+    output << "                 <import location = \"" << tokenizer_descriptor << "\"/>" << endl;
+    output << "         </delegateAnalysisEngine>" << endl;
+    output << "         <delegateAnalysisEngine key = \"LexiconAnnotator\">" << endl;
+    output << "                 <import location = \"" << lexicon_descriptor << "\"/>" << endl;
+    output << "         </delegateAnalysisEngine>" << endl;
+    output << "         <delegateAnalysisEngine key = \"Indexer\">" << endl;
+    output << index_delegate << endl;
+    output << "         </delegateAnalysisEngine>" << endl;
+    output << " </delegateAnalysisEngineSpecifiers>" << endl;
+    output << " <analysisEngineMetaData> " << endl;
+    output << "         <name > TpRawFile2Index</name>" << endl;
+    output << "         <description > Tokenizes, annotates and indexes a raw article.</description> " << endl;
+    output << "         <version > 1.0 </version> " << endl;
+    output << "         <vendor > Textpresso</vendor> " << endl;
+    if (!category_dictionary_file.empty()) {
+        output << "         <configurationParameters>" << endl;
+        output << "                 <configurationParameter>" << endl;
+        output << "                         <name>CategoryDictionaryFile</name>" << endl;
+        output << "                         <type>String</type>" << endl;
+        output << "                         <multiValued>false</multiValued>" << endl;
+        output << "                         <mandatory>false</mandatory>" << endl;
+        output << "                         <overrides>" << endl;
+        output << "                                 <parameter>LexiconAnnotator/CategoryDictionaryFile</parameter>"
+               << endl;
+        output << "                         </overrides>" << endl;
+        output << "                 </configurationParameter>" << endl;
+        output << "         </configurationParameters>" << endl;
+        output << "         <configurationParameterSettings>" << endl;
+        output << "                 <nameValuePair>" << endl;
+        output << "                         <name>CategoryDictionaryFile</name>" << endl;
+        output << "                         <value><string>" << category_dictionary_file << "</string></value>"
+               << endl;
+        output << "                 </nameValuePair>" << endl;
+        output << "         </configurationParameterSettings>" << endl;
+    }
+    output << "         <flowConstraints>" << endl;
+    output << "                 <fixedFlow>" << endl;
+    output << "                         <node>Tokenizer</node>" << endl;
+    output << "                         <node>LexiconAnnotator</node>" << endl;
+    output << "                         <node>Indexer</node>" << endl;
+    output << "                 </fixedFlow>" << endl;
+    output << "         </flowConstraints>" << endl;
+    output << " <capabilities> " << endl;
+    output << " <capability>" << endl;
+    output << " <inputs/> " << endl;
+    output << " <outputs/>" << endl;
+    output << " <languagesSupported> " << endl;
+    output << "         <language >x-unspecified</language>" << endl;
+    output << " </languagesSupported>" << endl;
+    output << " </capability>" << endl;
+    output << " </capabilities> " << endl;
+    output << " </analysisEngineMetaData>" << endl;
+    output << "</taeDescription> " << endl;
+    return output.str();
 }
 
 void Utils::write_index_descriptor(const std::string& index_path, const std::string& descriptor_path,
-                                   const std::string& tmp_conf_files_path)
+                                   const std::string& tmp_conf_files_path,
+                                   const tpc::index::IndexWriterOptions& writer_options)
 {
     ofstream output(descriptor_path.c_str());
+    output << get_index_descriptor(index_path, tmp_conf_files_path, writer_options);
+    output.close();
+}
+
+std::string Utils::get_index_descriptor(const std::string& index_path, const std::string& tmp_conf_files_path,
+                                        const tpc::index::IndexWriterOptions& writer_options, bool new_index)
+{
+    ostringstream output;
     output << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>" << endl;
     output << "<taeDescription xmlns = \"http://uima.apache.org/resourceSpecifier\" >" << endl;
     output << " <frameworkImplementation > org.apache.uima.cpp</frameworkImplementation>" << endl;
@@ -184,11 +278,60 @@ void Utils::write_index_descriptor(const std::string& index_path, const std::str
     output << "                 </configurationParameter>" << endl;
     output << "                 <configurationParameter> " << endl;
     output << "                         <name > TempDirectory</name> " << endl;
-    output << "                         <description > temporary directory under /run/shm/ to store newindexflag </description>" << endl;
+    output << "                         <description > temporary directory under /run/shm/ to store the bibliography files </description>" << endl;
     output << "                         <type > String</type>" << endl;
     output << "                         <multiValued > false </multiValued>" << endl;
     output << "                         <mandatory > true </mandatory>" << endl;
     output << "                 </configurationParameter>" << endl;
+    output << "                 <configurationParameter> " << endl;
+    output << "                         <name > NewIndex</name> " << endl;
+    output << "                         <description > Whether the index writers create a new index instead of adding to an existing one.</description>" << endl;
+    output << "                         <type > Boolean</type>" << endl;
+    output << "                         <multiValued > false </multiValued>" << endl;
+    output << "                         <mandatory > false </mandatory>" << endl;
+    output << "                 </configurationParameter>" << endl;
+    output << "                 <configurationParameter> " << endl;
+    output << "                         <name > RAMBufferSizeMB</name> " << endl;
+    output << "                         <description > RAM buffer size of the index writers in MB.</description>" << endl;
+    output << "                         <type > Float</type>" << endl;
+    output << "                         <multiValued > false </multiValued>" << endl;
+    output << "                         <mandatory > false </mandatory>" << endl;
+    output << "                 </configurationParameter>" << endl;
+    output << "                 <configurationParameter> " << endl;
+    output << "                         <name > MergeFactor</name> " << endl;
+    output << "                         <description > Merge factor of the log byte size merge policy.</description>" << endl;
+    output << "                         <type > Integer</type>" << endl;
+    output << "                         <multiValued > false </multiValued>" << endl;
+    output << "                         <mandatory > false </mandatory>" << endl;
+    output << "                 </configurationParameter>" << endl;
+    output << "                 <configurationParameter> " << endl;
+    output << "                         <name > MaxMergeMB</name> " << endl;
+    output << "                         <description > Max size in MB of the segments merged by the log byte size merge policy.</description>" << endl;
+    output << "                         <type > Float</type>" << endl;
+    output << "                         <multiValued > false </multiValued>" << endl;
+    output << "                         <mandatory > false </mandatory>" << endl;
+    output << "                 </configurationParameter>" << endl;
+    output << "                 <configurationParameter> " << endl;
+    output << "                         <name > UseCompoundFile</name> " << endl;
+    output << "                         <description > Whether the index writers create compound files.</description>" << endl;
+    output << "                         <type > Boolean</type>" << endl;
+    output << "                         <multiValued > false </multiValued>" << endl;
+    output << "                         <mandatory > false </mandatory>" << endl;
+    output << "                 </configurationParameter>" << endl;
+    output << "                 <configurationParameter> " << endl;
+    output << "                         <name > StoreTermVectors</name> " << endl;
+    output << "                         <description > Whether to store term vectors with positions and offsets for fulltext and sentences.</description>" << endl;
+    output << "                         <type > Boolean</type>" << endl;
+    output << "                         <multiValued > false </multiValued>" << endl;
+    output << "                         <mandatory > false </mandatory>" << endl;
+    output << "                 </configurationParameter>" << endl;
+    output << "                 <configurationParameter> " << endl;
+    output << "                         <name > StoreSentenceBlocks</name> " << endl;
+    output << "                         <description > Whether to store the text and categories of the sentences of each document in a single compressed block.</description>" << endl;
+    output << "                         <type > Boolean</type>" << endl;
+    output << "                         <multiValued > false </multiValued>" << endl;
+    output << "                         <mandatory > false </mandatory>" << endl;
+    output << "                 </configurationParameter>" << endl;
     output << "         </configurationParameters>" << endl;
     output << "         <configurationParameterSettings>" << endl;
     output << "                 <nameValuePair> " << endl;
@@ -257,6 +400,53 @@ void Utils::write_index_descriptor(const std::string& index_path, const std::str
     output << "                         <string>" << tmp_conf_files_path << "</string>" << endl;
     output << "                         </value> " << endl;
     output << "                 </nameValuePair> " << endl;
+    output << "                 <nameValuePair>" << endl;
+    output << "                         <name >NewIndex</name> " << endl;
+    output << "                         <value> " << endl;
+    output << "                         <boolean>" << (new_index ? "true" : "false") << "</boolean>" << endl;
+    output << "                         </value> " << endl;
+    output << "                 </nameValuePair> " << endl;
+    output << "                 <nameValuePair>" << endl;
+    output << "                         <name >RAMBufferSizeMB</name> " << endl;
+    output << "                         <value> " << endl;
+    output << "                         <float>" << writer_options.ram_buffer_size_mb << "</float>" << endl;
+    output << "                         </value> " << endl;
+    output << "                 </nameValuePair> " << endl;
+    output << "                 <nameValuePair>" << endl;
+    output << "                         <name >MergeFactor</name> " << endl;
+    output << "                         <value> " << endl;
+    output << "                         <integer>" << writer_options.merge_factor << "</integer>" << endl;
+    output << "                         </value> " << endl;
+    output << "                 </nameValuePair> " << endl;
+    if (writer_options.max_merge_mb < FLT_MAX) {
+        output << "                 <nameValuePair>" << endl;
+        output << "                         <name >MaxMergeMB</name> " << endl;
+        output << "                         <value> " << endl;
+        output << "                         <float>" << writer_options.max_merge_mb << "</float>" << endl;
+        output << "                         </value> " << endl;
+        output << "                 </nameValuePair> " << endl;
+    }
+    output << "                 <nameValuePair>" << endl;
+    output << "                         <name >UseCompoundFile</name> " << endl;
+    output << "                         <value> " << endl;
+    output << "                         <boolean>" << (writer_options.use_compound_file ? "true" : "false")
+           << "</boolean>" << endl;
+    output << "                         </value> " << endl;
+    output << "                 </nameValuePair> " << endl;
+    output << "                 <nameValuePair>" << endl;
+    output << "                         <name >StoreTermVectors</name> " << endl;
+    output << "                         <value> " << endl;
+    output << "                         <boolean>" << (writer_options.store_term_vectors ? "true" : "false")
+           << "</boolean>" << endl;
+    output << "                         </value> " << endl;
+    output << "                 </nameValuePair> " << endl;
+    output << "                 <nameValuePair>" << endl;
+    output << "                         <name >StoreSentenceBlocks</name> " << endl;
+    output << "                         <value> " << endl;
+    output << "                         <boolean>" << (writer_options.sentence_blocks ? "true" : "false")
+           << "</boolean>" << endl;
+    output << "                         </value> " << endl;
+    output << "                 </nameValuePair> " << endl;
     output << "         </configurationParameterSettings> " << endl;
     output << " <typeSystemDescription> " << endl;
     output << "         <imports> " << endl;
@@ -274,5 +464,5 @@ void Utils::write_index_descriptor(const std::string& index_path, const std::str
     output << " </capabilities> " << endl;
     output << " </analysisEngineMetaData>" << endl;
     output << "</taeDescription> " << endl;
-    output.close();
+    return output.str();
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 
 #include <string>
 #include <uima/api.hpp>
+#include "DataStructures.h"
 
 class Utils {
 public:
@@ -24,9 +25,39 @@ public:
      * @param index_path the path of the index
      * @param descriptor_path the path of the descriptor to be created
      * @param tmp_conf_files_path the path of the directory containing the temp files for the index
+     * @param writer_options the tuning options of the index writers
      */
     static void write_index_descriptor(const std::string& index_path, const std::string& descriptor_path,
-                                       const std::string& tmp_conf_files_path);
+                                       const std::string& tmp_conf_files_path,
+                                       const tpc::index::IndexWriterOptions& writer_options =
+                                       tpc::index::IndexWriterOptions());
+
+    /*!
+     * get the content of a uima descriptor for an index, so that engines can be created from memory
+     * @param index_path the path of the index
+     * @param tmp_conf_files_path the path of the directory containing the temp files for the index
+     * @param writer_options the tuning options of the index writers
+     * @param new_index whether the engine must create a new index instead of adding to an existing one
+     * @return the xml content of the descriptor
+     */
+    static std::string get_index_descriptor(const std::string& index_path, const std::string& tmp_conf_files_path,
+                                            const tpc::index::IndexWriterOptions& writer_options =
+                                            tpc::index::IndexWriterOptions(), bool new_index = false);
+
+    /*!
+     * get the content of an aggregate uima descriptor that tokenizes, annotates with the lexicon and indexes a cas
+     * in a single engine
+     * @param tokenizer_descriptor the path of the descriptor of the tokenizer
+     * @param lexicon_descriptor the path of the descriptor of the lexicon annotator
+     * @param index_descriptor the xml content of the index descriptor, as returned by Utils::get_index_descriptor
+     * @param category_dictionary_file the category dictionary of the index, passed to the lexicon annotator through
+     * its CategoryDictionaryFile parameter. The parameter is not set if empty
+     * @return the xml content of the aggregate descriptor
+     */
+    static std::string get_raw_file_index_descriptor(const std::string& tokenizer_descriptor,
+                                                     const std::string& lexicon_descriptor,
+                                                     const std::string& index_descriptor,
+                                                     const std::string& category_dictionary_file = "");
 
     /*!
      * decompress file to a new file and return file path of the latter
@@ -35,6 +66,13 @@ public:
      */
     static std::string decompress_gzip(const std::string & gz_file, const std::string& tmp_dir);
 
+    /*!
+     * decompress a gzipped file in memory
+     * @param gz_file the gz file to decompress
+     * @return the decompressed content of the file
+     */
+    static std::string decompress_gzip_to_string(const std::string& gz_file);
+
     static std::string gettpfnvHash(uima::CAS& tcas);
 
     static std::wstring getFulltext(uima::CAS& tcas);
@@ -14,17 +14,26 @@ class Stream2Tpcas {
 public:
     Stream2Tpcas(std::stringstream & streamin, std::string outfn, const char * cnfg);
     Stream2Tpcas(std::string & stringin, std::string outfn, const char * cnfg);
+    // batch mode: the engine and its cas are created once and reused by all calls to processString
+    Stream2Tpcas(const char * cnfg);
     Stream2Tpcas(const Stream2Tpcas & orig);
     virtual ~Stream2Tpcas();
+    // single document mode: process the stream or string given to the constructor, like processString
     void processInputStream();
     void processInputString();
+    void processString(const std::string & stringin, const std::string & outfn);
     void writeXmi(uima::CAS & outCas, int num, std::string outfn);
+    // the text read by the tokenizers: the stream preceded by a header with the file name
+    static UnicodeString getInputText(const std::string & outfn, const std::string & text);
 private:
     std::stringstream m_streamin;
     std::string m_stringin;
     std::string m_outfn;
     const char * m_cnfg;
     std::string file_time;
+    uima::AnalysisEngine * m_engine;
+    uima::CAS * m_cas;
+    void processCas(uima::CAS & cas, const std::string & outfn);
 
 };
 
@@ -0,0 +1,34 @@
+/**
+    Project: libtpc
+    File name: CategoryAnalyzer.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "CategoryAnalyzer.h"
+#include <lucene++/LuceneHeaders.h>
+#include <lucene++/PerFieldAnalyzerWrapper.h>
+
+using namespace Lucene;
+
+DECLARE_SHARED_PTR(CategoryAnalyzer);
+
+CategoryAnalyzer::CategoryAnalyzer(const AnalyzerPtr &analyzer, const String &gapToken) : analyzer(analyzer) {
+    gapTokens = HashSet<String>::newInstance();
+    gapTokens.add(gapToken);
+}
+
+CategoryAnalyzer::~CategoryAnalyzer() {
+}
+
+TokenStreamPtr CategoryAnalyzer::tokenStream(const String &fieldName, const ReaderPtr &reader) {
+    // the stop filter adds the positions of the removed tokens to the increment of the next token
+    return newLucene<StopFilter>(true, analyzer->tokenStream(fieldName, reader), gapTokens);
+}
+
+AnalyzerPtr CategoryAnalyzer::wrapSentenceAnalyzer(const AnalyzerPtr &analyzer, const String &gapToken) {
+    PerFieldAnalyzerWrapperPtr wrapper = newLucene<PerFieldAnalyzerWrapper>(analyzer);
+    wrapper->addAnalyzer(L"sentence_cat", newLucene<CategoryAnalyzer>(analyzer, gapToken));
+    return wrapper;
+}
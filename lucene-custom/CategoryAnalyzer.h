@@ -0,0 +1,46 @@
+/**
+    Project: libtpc
+    File name: CategoryAnalyzer.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_CATEGORYANALYZER_H
+#define LIBTPC_CATEGORYANALYZER_H
+
+#include <lucene++/LuceneHeaders.h>
+
+using namespace Lucene;
+
+/*!
+ * analyzer for the categories of the sentences. The text is analyzed by the wrapped analyzer and the gap tokens, which
+ * stand for the words without categories, are removed while their positions are kept, so that phrase queries match
+ * only adjacent categories without indexing a term for each word without categories
+ */
+class CategoryAnalyzer: public Analyzer {
+
+public:
+    CategoryAnalyzer(const Lucene::AnalyzerPtr &analyzer, const Lucene::String &gapToken);
+    virtual ~CategoryAnalyzer();
+
+    LUCENE_CLASS(CategoryAnalyzer);
+
+protected:
+    Lucene::AnalyzerPtr analyzer;
+    Lucene::HashSet<Lucene::String> gapTokens;
+
+public:
+    virtual Lucene::TokenStreamPtr tokenStream(const Lucene::String &fieldName, const Lucene::ReaderPtr &reader);
+
+    /*!
+     * wrap the analyzer of a sentence index, so that the sentence_cat field is analyzed by a CategoryAnalyzer
+     * @param analyzer the analyzer of the sentence index
+     * @param gapToken the token that stands for the words without categories
+     * @return the wrapped analyzer
+     */
+    static Lucene::AnalyzerPtr wrapSentenceAnalyzer(const Lucene::AnalyzerPtr &analyzer,
+                                                    const Lucene::String &gapToken);
+};
+
+#endif //LIBTPC_CATEGORYANALYZER_H
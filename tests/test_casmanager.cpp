@@ -7,8 +7,14 @@
 */
 
 #include <boost/filesystem/operations.hpp>
+#include <map>
+#include <memory>
+#include <thread>
 #include "gtest/gtest.h"
 #include "../CASManager.h"
+#include "../CompactCasSerializer.h"
+#include "../CorpusClassifier.h"
+#include "../Utils.h"
 
 using namespace tpc::cas;
 using namespace boost::filesystem;
@@ -47,6 +53,26 @@ namespace {
         }
     }
 
+    void get_cas_summary(uima::CAS& cas, string& sofa_text, map<string, int>& annotation_counts) {
+        sofa_text = cas.getDocumentText().asUTF8();
+        annotation_counts.clear();
+        uima::ANIterator annotation_it = cas.getAnnotationIndex().iterator();
+        for (annotation_it.moveToFirst(); annotation_it.isValid(); annotation_it.moveToNext()) {
+            ++annotation_counts[annotation_it.get().getType().getName().asUTF8()];
+        }
+    }
+
+    void read_cas_summary(const string& file_path, string& sofa_text, map<string, int>& annotation_counts) {
+        uima::ErrorInfo errorInfo;
+        unique_ptr<uima::TypeSystem> typeSystem(uima::Framework::createTypeSystem(
+                TPCAS_TYPE_SYSTEM_DESCRIPTOR.c_str(), errorInfo));
+        ASSERT_EQ(errorInfo.getErrorId(), UIMA_ERR_NONE);
+        unique_ptr<uima::CAS> cas(uima::Framework::createCAS(*typeSystem, errorInfo));
+        ASSERT_EQ(errorInfo.getErrorId(), UIMA_ERR_NONE);
+        CASManager::read_compressed_cas(file_path, *cas);
+        get_cas_summary(*cas, sofa_text, annotation_counts);
+    }
+
     TEST_F(CASManagerTest, AddPdfToCAS) {
         path p(pdf_file_path);
         string literature = p.filename().string();
@@ -54,6 +80,96 @@ namespace {
         convert_dir_recursively(pdf_file_path, tmp_dir, literature);
         ASSERT_TRUE(exists(tmp_dir));
     }
+
+    TEST_F(CASManagerTest, ConvertCasFileToCompactFormatAndBack) {
+        string cas_file = "/usr/local/share/textpresso/data/single_cas_files/C. elegans/WBPaper00029298/"
+                "WBPaper00029298.tpcas.gz";
+        string tmp_cas_file = tmp_dir + "/WBPaper00029298.tpcas.gz";
+        create_directories(tmp_dir);
+        copy_file(cas_file, tmp_cas_file, copy_option::overwrite_if_exists);
+        string sofa_text;
+        map<string, int> annotation_counts;
+        read_cas_summary(cas_file, sofa_text, annotation_counts);
+        ASSERT_FALSE(sofa_text.empty());
+        ASSERT_FALSE(annotation_counts.empty());
+        ASSERT_EQ(CASManager::convert_cas_files_format({tmp_cas_file}, CasFormat::compact), 1);
+        string compact_content = Utils::decompress_gzip_to_string(tmp_cas_file);
+        ASSERT_TRUE(CompactCasSerializer::is_compact_cas(compact_content));
+        string hash = CompactCasSerializer::get_string_feature_value(
+                compact_content, "org.apache.uima.textpresso.tpfnvhash", "content");
+        ASSERT_FALSE(hash.empty());
+        ASSERT_EQ(CASManager::convert_cas_files_format({tmp_cas_file}, CasFormat::xmi), 1);
+        string xmi_content = Utils::decompress_gzip_to_string(tmp_cas_file);
+        ASSERT_FALSE(CompactCasSerializer::is_compact_cas(xmi_content));
+        // the text and the annotations survive the round trip
+        string converted_sofa_text;
+        map<string, int> converted_annotation_counts;
+        read_cas_summary(tmp_cas_file, converted_sofa_text, converted_annotation_counts);
+        ASSERT_EQ(converted_sofa_text, sofa_text);
+        ASSERT_EQ(converted_annotation_counts, annotation_counts);
+        ASSERT_EQ(CASManager::convert_cas_files_format({tmp_cas_file}, CasFormat::compact), 1);
+        ASSERT_EQ(CompactCasSerializer::get_string_feature_value(Utils::decompress_gzip_to_string(tmp_cas_file),
+                                                                 "org.apache.uima.textpresso.tpfnvhash", "content"),
+                  hash);
+        read_cas_summary(tmp_cas_file, converted_sofa_text, converted_annotation_counts);
+        ASSERT_EQ(converted_sofa_text, sofa_text);
+        ASSERT_EQ(converted_annotation_counts, annotation_counts);
+    }
+
+    TEST_F(CASManagerTest, DeserializeCasFilesInParallel) {
+        // as in the indexing pipeline, each thread deserializes into its own cas and the type system is shared
+        string cas_file = "/usr/local/share/textpresso/data/single_cas_files/C. elegans/WBPaper00029298/"
+                "WBPaper00029298.tpcas.gz";
+        string sofa_text;
+        map<string, int> annotation_counts;
+        read_cas_summary(cas_file, sofa_text, annotation_counts);
+        string content = Utils::decompress_gzip_to_string(cas_file);
+        uima::ErrorInfo errorInfo;
+        unique_ptr<uima::TypeSystem> typeSystem(uima::Framework::createTypeSystem(
+                TPCAS_TYPE_SYSTEM_DESCRIPTOR.c_str(), errorInfo));
+        ASSERT_EQ(errorInfo.getErrorId(), UIMA_ERR_NONE);
+        const int num_threads = 8;
+        const int num_files_per_thread = 10;
+        vector<unique_ptr<uima::CAS>> cases;
+        for (int i = 0; i < num_threads; ++i) {
+            cases.emplace_back(uima::Framework::createCAS(*typeSystem, errorInfo));
+            ASSERT_EQ(errorInfo.getErrorId(), UIMA_ERR_NONE);
+        }
+        vector<int> num_equal_files(num_threads, 0);
+        vector<thread> threads;
+        for (int i = 0; i < num_threads; ++i) {
+            threads.emplace_back([&, i]() {
+                for (int j = 0; j < num_files_per_thread; ++j) {
+                    CASManager::deserialize_cas(content, *cases[i], cas_file);
+                    string thread_sofa_text;
+                    map<string, int> thread_annotation_counts;
+                    get_cas_summary(*cases[i], thread_sofa_text, thread_annotation_counts);
+                    if (thread_sofa_text == sofa_text && thread_annotation_counts == annotation_counts) {
+                        ++num_equal_files[i];
+                    }
+                    cases[i]->reset();
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        ASSERT_EQ(num_equal_files, vector<int>(num_threads, num_files_per_thread));
+    }
+
+    TEST_F(CASManagerTest, ClassifyArticleIntoCorpora) {
+        CorpusClassifier classifier;
+        BibInfo bib_info;
+        bib_info.title = "Neuronal migration in Caenorhabditis elegans";
+        bib_info.journal = "Genetics";
+        vector<string> corpora = classifier.classify(bib_info);
+        ASSERT_EQ(corpora, vector<string>({"PMCOA Neuroscience", "PMCOA Genetics", "PMCOA C. elegans"}));
+        ASSERT_EQ(corpora, CASManager::classify_article_into_corpora_from_bib_file(bib_info));
+        // as with the original regular expressions, fields spanning more than one line are not matched
+        bib_info.title = "Neuronal migration\nin worms";
+        bib_info.journal = "";
+        ASSERT_EQ(classifier.classify(bib_info), vector<string>({PMCOA_UNCLASSIFIED}));
+    }
 }
 
 int main(int argc, char **argv) {
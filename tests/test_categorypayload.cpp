@@ -0,0 +1,143 @@
+/**
+    Project: libtpc
+    File name: test_categorypayload.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include <stdexcept>
+#include "gtest/gtest.h"
+#include "../CategoryPayload.h"
+
+using namespace tpc::index;
+
+namespace {
+
+    class CategoryPayloadTest : public testing::Test {
+    protected:
+
+        CategoryPayloadTest() {
+            gene_id = dictionary.get_or_add_id(L"Gene (C. elegans) (tpgce:0000001)");
+            stage_id = dictionary.get_or_add_id(L"Life stage (C. elegans) (tplsc:0000001)");
+            // categories that are not in the dictionary of the index have negative ids
+            extra_id = -1 - extra_categories.get_or_add_id(L"Protéine");
+            // a sentence of six words, with categories on the first, fourth and sixth word
+            payload.set_num_words(6);
+            payload.add_word_categories(0, {gene_id}, extra_categories);
+            payload.add_word_categories(3, {stage_id, extra_id}, extra_categories);
+            payload.add_word_categories(5, {extra_id}, extra_categories);
+        }
+
+        void expect_corrupted(const std::string& data) {
+            CategoryPayload decoded;
+            EXPECT_THROW(decoded.decode(data.data(), data.size()), std::runtime_error);
+        }
+
+        CategoryDictionary dictionary;
+        CategoryDictionary extra_categories;
+        int32_t gene_id;
+        int32_t stage_id;
+        int32_t extra_id;
+        CategoryPayload payload;
+    };
+
+    TEST_F(CategoryPayloadTest, CategoriesStringHasNAForWordsWithoutCategories) {
+        ASSERT_EQ(payload.get_categories_string(dictionary),
+                  "Gene (C. elegans) (tpgce:0000001)\tNA\tNA\t"
+                  "Life stage (C. elegans) (tplsc:0000001)|Prot\xC3\xA9ine\tNA\tProt\xC3\xA9ine");
+    }
+
+    TEST_F(CategoryPayloadTest, IndexedTextKeepsPositionsOfWordsWithoutCategories) {
+        ASSERT_EQ(payload.get_indexed_text(dictionary),
+                  L"Gene (C. elegans) (tpgce:0000001)\t" + CATEGORY_GAP_TOKEN + L"\t" + CATEGORY_GAP_TOKEN +
+                  L"\tLife stage (C. elegans) (tplsc:0000001)|Protéine\t" + CATEGORY_GAP_TOKEN + L"\tProtéine");
+    }
+
+    TEST_F(CategoryPayloadTest, IndexedTextKeepsPositionsOfLeadingAndTrailingWords) {
+        CategoryPayload inner_payload;
+        inner_payload.set_num_words(4);
+        inner_payload.add_word_categories(1, {gene_id}, extra_categories);
+        ASSERT_EQ(inner_payload.get_indexed_text(dictionary),
+                  CATEGORY_GAP_TOKEN + L"\tGene (C. elegans) (tpgce:0000001)\t" + CATEGORY_GAP_TOKEN + L"\t" +
+                  CATEGORY_GAP_TOKEN);
+    }
+
+    TEST_F(CategoryPayloadTest, RoundTrip) {
+        std::string encoded = payload.encode();
+        CategoryPayload decoded;
+        decoded.decode(encoded.data(), encoded.size());
+        ASSERT_EQ(decoded.get_categories_string(dictionary), payload.get_categories_string(dictionary));
+        ASSERT_EQ(decoded.get_indexed_text(dictionary), payload.get_indexed_text(dictionary));
+        ASSERT_EQ(decoded.encode(), encoded);
+    }
+
+    TEST_F(CategoryPayloadTest, RoundTripOfEmptySentence) {
+        CategoryPayload empty;
+        std::string encoded = empty.encode();
+        CategoryPayload decoded;
+        decoded.decode(encoded.data(), encoded.size());
+        ASSERT_EQ(decoded.get_categories_string(dictionary), "");
+        ASSERT_EQ(decoded.get_indexed_text(dictionary), L"");
+    }
+
+    TEST_F(CategoryPayloadTest, DictionaryIdsAreNotStoredAsNames) {
+        CategoryPayload names_payload;
+        names_payload.set_num_words(1);
+        names_payload.add_word_categories(0, {gene_id, stage_id}, extra_categories);
+        ASSERT_LT(names_payload.encode().size(), 10);
+    }
+
+    TEST_F(CategoryPayloadTest, DecodeRejectsTruncatedData) {
+        std::string encoded = payload.encode();
+        for (size_t size = 0; size < encoded.size(); ++size) {
+            expect_corrupted(encoded.substr(0, size));
+        }
+    }
+
+    TEST_F(CategoryPayloadTest, DecodeRejectsTrailingData) {
+        expect_corrupted(payload.encode() + '\0');
+    }
+
+    TEST_F(CategoryPayloadTest, DecodeRejectsUnsupportedVersion) {
+        std::string encoded = payload.encode();
+        encoded[0] = static_cast<char>(CATEGORY_PAYLOAD_VERSION + 1);
+        expect_corrupted(encoded);
+    }
+
+    TEST_F(CategoryPayloadTest, DecodeRejectsWordIndexOutOfRange) {
+        // version, 1 word, no names, 1 word with categories at distance 1, 1 category with id 0
+        expect_corrupted(std::string({static_cast<char>(CATEGORY_PAYLOAD_VERSION), 1, 0, 1, 1, 1, 0}));
+    }
+
+    TEST_F(CategoryPayloadTest, DecodeRejectsCategoryIndexOutOfRange) {
+        // version, 1 word, no names, 1 word with categories at distance 0, 1 category with table index 0
+        expect_corrupted(std::string({static_cast<char>(CATEGORY_PAYLOAD_VERSION), 1, 0, 1, 0, 1, 1}));
+    }
+
+    TEST_F(CategoryPayloadTest, DecodeRejectsTooLongVarint) {
+        std::string encoded(1, static_cast<char>(CATEGORY_PAYLOAD_VERSION));
+        encoded.append(11, static_cast<char>(0xFF));
+        expect_corrupted(encoded);
+    }
+
+    TEST_F(CategoryPayloadTest, DecodeRejectsInvalidUtf8Name) {
+        // version, no words, 1 name of 2 bytes with a missing continuation byte
+        expect_corrupted(std::string({static_cast<char>(CATEGORY_PAYLOAD_VERSION), 0, 1, 2,
+                                      static_cast<char>(0xC3), 'A', 0}));
+    }
+
+    TEST_F(CategoryPayloadTest, CategoryNotInDictionaryIsReported) {
+        std::string encoded = payload.encode();
+        CategoryPayload decoded;
+        decoded.decode(encoded.data(), encoded.size());
+        CategoryDictionary empty_dictionary;
+        ASSERT_THROW(decoded.get_categories_string(empty_dictionary), std::runtime_error);
+        ASSERT_THROW(decoded.get_indexed_text(empty_dictionary), std::runtime_error);
+    }
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -7,8 +7,11 @@
 */
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <fstream>
 #include "gtest/gtest.h"
 #include "../IndexManager.h"
+#include "../CategoryPayload.h"
 
 using namespace tpc::index;
 
@@ -23,6 +26,7 @@ namespace {
             literatures = {"C. elegans", "C. elegans Supplementals"};
             cas_root_dir = "/usr/local/share/textpresso/data/tpcas";
             single_cas_files_dir = "/usr/local/share/textpresso/data/single_cas_files/C. elegans";
+            pdf_dir = "/usr/local/share/textpresso/data/pdf/C. elegans";
             output_index_dir = "/tmp/textpresso_test/index_writer_test";
             query_sentence.sort_by_year = false;
             query_sentence.type = QueryType::sentence;
@@ -84,6 +88,7 @@ namespace {
 
         std::string cas_root_dir;
         std::string single_cas_files_dir;
+        std::string pdf_dir;
         std::string output_index_dir;
         IndexManager indexManager;
     };
@@ -125,10 +130,297 @@ namespace {
         ASSERT_EQ(results.hit_documents.size(), docDetails.size());
     }
 
+    TEST_F(IndexManagerTest, SearchWithYearRange) {
+        Query query_year_range = query_document;
+        query_year_range.year = "1900-2100";
+        ASSERT_EQ(indexManager.search_documents(query_year_range).hit_documents.size(),
+                  indexManager.search_documents(query_document).hit_documents.size());
+        query_year_range.year = "1900 TO 1901";
+        ASSERT_EQ(indexManager.search_documents(query_year_range).hit_documents.size(), 0);
+    }
+
     TEST_F(IndexManagerTest, AddSingleDocumentsToIndexTest) {
         indexManager.add_file_to_index(single_cas_files_dir + "/WBPaper00029298/WBPaper00029298.tpcas.gz");
     }
 
+    TEST_F(IndexManagerTest, AddMultipleDocumentsToIndexTest) {
+        indexManager.add_files_to_index({single_cas_files_dir + "/WBPaper00029298/WBPaper00029298.tpcas.gz",
+                                         single_cas_files_dir + "/WBPaper00046156/WBPaper00046156.tpcas.gz"});
+    }
+
+    TEST_F(IndexManagerTest, ResumeIndexingSkipsRecordedFiles) {
+        size_t num_hits = indexManager.search_documents(query_document).hit_documents.size();
+        indexManager.create_index_from_existing_cas_dir(cas_root_dir + "/C. elegans", {}, 50000, true);
+        ASSERT_EQ(indexManager.search_documents(query_document).hit_documents.size(), num_hits);
+    }
+
+    TEST_F(IndexManagerTest, ResumeIndexingReindexesChangedFiles) {
+        std::string cas_dir("/tmp/textpresso_test/changed_cas/C. elegans/WBPaper00029298");
+        std::string changed_index_dir("/tmp/textpresso_test/index_changed");
+        boost::filesystem::create_directories(cas_dir);
+        for (const std::string& extension : {".tpcas.gz", ".bib"}) {
+            boost::filesystem::copy_file(single_cas_files_dir + "/WBPaper00029298/WBPaper00029298" + extension,
+                                         cas_dir + "/WBPaper00029298" + extension,
+                                         boost::filesystem::copy_option::overwrite_if_exists);
+        }
+        boost::filesystem::create_directories(changed_index_dir);
+        IndexManager changedIndexManager(changed_index_dir, false);
+        changedIndexManager.create_index_from_existing_cas_dir("/tmp/textpresso_test/changed_cas/C. elegans", {}, 1);
+        Query query;
+        query.type = QueryType::sentence;
+        query.keyword = "the";
+        query.case_sensitive = false;
+        query.literatures = {"C. elegans"};
+        int num_sentences = changedIndexManager.search_documents(query).total_num_sentences;
+        std::string cas_file = cas_dir + "/WBPaper00029298.tpcas.gz";
+        boost::filesystem::last_write_time(cas_file, boost::filesystem::last_write_time(cas_file) + 10);
+        changedIndexManager.create_index_from_existing_cas_dir("/tmp/textpresso_test/changed_cas/C. elegans", {},
+                                                               1, true);
+        // the old version of the file is replaced, not duplicated
+        ASSERT_EQ(changedIndexManager.search_documents(query).total_num_sentences, num_sentences);
+        query.type = QueryType::document;
+        ASSERT_EQ(changedIndexManager.search_documents(query).hit_documents.size(), 1);
+        // the reindexed file is counted once, so it goes back to the only subindex
+        int num_subindexes = 0;
+        for (boost::filesystem::directory_iterator dir_it(changed_index_dir);
+             dir_it != boost::filesystem::directory_iterator(); ++dir_it) {
+            if (dir_it->path().filename().string().find(SUBINDEX_NAME + "_") == 0) {
+                ++num_subindexes;
+            }
+        }
+        ASSERT_EQ(num_subindexes, 1);
+        boost::filesystem::remove_all("/tmp/textpresso_test/changed_cas");
+        boost::filesystem::remove_all(changed_index_dir);
+    }
+
+    TEST_F(IndexManagerTest, MergeSubindexSegments) {
+        indexManager.merge_subindex_segments(1);
+        for (const auto& num_segments : indexManager.get_num_segments_per_subindex()) {
+            ASSERT_LE(num_segments.second, 1);
+        }
+    }
+
+    TEST_F(IndexManagerTest, ReindexFromStoredFields) {
+        indexManager.reindex_from_stored_fields("/tmp/textpresso_test/reindex");
+        IndexManager reindexed("/tmp/textpresso_test/reindex");
+        ASSERT_EQ(reindexed.search_documents(query_document).hit_documents.size(),
+                  indexManager.search_documents(query_document).hit_documents.size());
+        boost::filesystem::remove_all("/tmp/textpresso_test/reindex");
+    }
+
+    TEST_F(IndexManagerTest, SentenceBlocksReturnSameSentences) {
+        std::string block_index_dir("/tmp/textpresso_test/index_blocks");
+        boost::filesystem::create_directories(block_index_dir);
+        IndexManager blockIndexManager(block_index_dir, false);
+        IndexWriterOptions options;
+        options.sentence_blocks = true;
+        blockIndexManager.set_index_writer_options(options);
+        blockIndexManager.create_index_from_existing_cas_dir(cas_root_dir + "/C. elegans");
+        blockIndexManager.save_all_years_for_documents_to_db();
+        blockIndexManager.save_all_doc_ids_for_sentences_to_db();
+        SearchResults results = indexManager.search_documents(query_sentence);
+        SearchResults block_results = blockIndexManager.search_documents(query_sentence);
+        ASSERT_EQ(block_results.total_num_sentences, results.total_num_sentences);
+        std::vector<DocumentDetails> details = indexManager.get_documents_details(results.hit_documents, false);
+        std::vector<DocumentDetails> block_details = blockIndexManager.get_documents_details(
+                block_results.hit_documents, false);
+        std::map<std::pair<std::string, int>, std::string> sentences;
+        for (const DocumentDetails& doc : details) {
+            for (const SentenceDetails& sentence : doc.sentences_details) {
+                sentences[{doc.identifier, sentence.sentence_id}] = sentence.sentence_text +
+                        sentence.categories_string;
+            }
+        }
+        for (const DocumentDetails& doc : block_details) {
+            for (const SentenceDetails& sentence : doc.sentences_details) {
+                ASSERT_EQ(sentence.sentence_text + sentence.categories_string,
+                          sentences[{doc.identifier, sentence.sentence_id}]);
+            }
+        }
+        boost::filesystem::remove_all(block_index_dir);
+    }
+
+    TEST_F(IndexManagerTest, IndexCreationStoresCategoryDictionary) {
+        std::string dictionary_file("/tmp/textpresso_test/index/" + CATEGORY_DICTIONARY_FILENAME);
+        ASSERT_TRUE(boost::filesystem::exists(dictionary_file));
+        CategoryDictionary dictionary;
+        dictionary.load(dictionary_file);
+        ASSERT_GT(dictionary.size(), 0);
+        // the categories of the sentences are encoded with the ids of the stored dictionary
+        std::string sentence_index_dir("/tmp/textpresso_test/index/" + SUBINDEX_NAME + "_0/" + SENTENCE_INDEXNAME);
+        Lucene::IndexReaderPtr reader = Lucene::IndexReader::open(Lucene::FSDirectory::open(
+                Lucene::String(sentence_index_dir.begin(), sentence_index_dir.end())), true);
+        int num_payloads = 0;
+        for (int32_t doc = 0; doc < reader->maxDoc(); ++doc) {
+            Lucene::ByteArray payload_bytes = reader->document(doc)->getBinaryValue(L"sentence_cat_binary");
+            if (!payload_bytes) {
+                continue;
+            }
+            CategoryPayload payload;
+            payload.decode(reinterpret_cast<const char*>(payload_bytes.get()), payload_bytes.size());
+            ASSERT_EQ(payload.get_num_extra_categories(), 0);
+            ASSERT_NO_THROW(payload.get_categories_string(dictionary));
+            ++num_payloads;
+        }
+        reader->close();
+        ASSERT_GT(num_payloads, 0);
+    }
+
+    TEST_F(IndexManagerTest, CategoryIdsAreStableAcrossSubindexes) {
+        std::string split_index_dir("/tmp/textpresso_test/index_split");
+        std::string lexicon_file("/tmp/textpresso_test/lexicon.tsv");
+        std::ofstream lexicon(lexicon_file);
+        lexicon << "lin-15\tGene (C. elegans) (tpgce:0000001)" << std::endl;
+        lexicon << "dauer\tLife stage (C. elegans) (tplsc:0000001)" << std::endl;
+        lexicon << "lin-15B\tGene (C. elegans) (tpgce:0000001)" << std::endl;
+        lexicon.close();
+        boost::filesystem::create_directories(split_index_dir);
+        IndexManager splitIndexManager(split_index_dir, false);
+        splitIndexManager.create_category_dictionary(lexicon_file);
+        splitIndexManager.create_category_dictionary(lexicon_file);
+        CategoryDictionary dictionary = splitIndexManager.get_category_dictionary();
+        ASSERT_EQ(dictionary.size(), 2);
+        // one paper per subindex
+        splitIndexManager.create_index_from_existing_cas_dir(cas_root_dir + "/C. elegans", {}, 1);
+        splitIndexManager.save_all_years_for_documents_to_db();
+        splitIndexManager.save_all_doc_ids_for_sentences_to_db();
+        // the categories of the lexicon annotator are appended to the ones already in the dictionary
+        CategoryDictionary indexed_dictionary = splitIndexManager.get_category_dictionary();
+        ASSERT_GE(indexed_dictionary.size(), dictionary.size());
+        for (int32_t id = 0; id < dictionary.size(); ++id) {
+            ASSERT_EQ(indexed_dictionary.get_name(id), dictionary.get_name(id));
+        }
+        int num_subindexes = 0;
+        for (boost::filesystem::directory_iterator dir_it(split_index_dir);
+             dir_it != boost::filesystem::directory_iterator(); ++dir_it) {
+            if (dir_it->path().filename().string().find(SUBINDEX_NAME + "_") == 0) {
+                ++num_subindexes;
+                ASSERT_FALSE(boost::filesystem::exists(dir_it->path() / CATEGORY_DICTIONARY_FILENAME));
+            }
+        }
+        ASSERT_GT(num_subindexes, 1);
+        // the categories of the sentences do not depend on the subindex of their document
+        SearchResults results = indexManager.search_documents(query_sentence);
+        SearchResults split_results = splitIndexManager.search_documents(query_sentence);
+        ASSERT_EQ(split_results.total_num_sentences, results.total_num_sentences);
+        std::map<std::pair<std::string, int>, std::string> categories;
+        for (const DocumentDetails& doc : indexManager.get_documents_details(results.hit_documents, false)) {
+            for (const SentenceDetails& sentence : doc.sentences_details) {
+                categories[{doc.identifier, sentence.sentence_id}] = sentence.categories_string;
+            }
+        }
+        for (const DocumentDetails& doc : splitIndexManager.get_documents_details(split_results.hit_documents,
+                                                                                 false)) {
+            for (const SentenceDetails& sentence : doc.sentences_details) {
+                ASSERT_EQ(sentence.categories_string, categories[{doc.identifier, sentence.sentence_id}]);
+            }
+        }
+        boost::filesystem::remove_all(split_index_dir);
+        boost::filesystem::remove(lexicon_file);
+    }
+
+    TEST_F(IndexManagerTest, AddRawPdfFilesToIndex) {
+        std::string raw_dir("/tmp/textpresso_test/raw/WBPaper00000045");
+        std::string raw_index_dir("/tmp/textpresso_test/index_raw");
+        std::string archive_dir("/tmp/textpresso_test/archive");
+        std::string cas_index_dir("/tmp/textpresso_test/index_archive");
+        boost::filesystem::create_directories(raw_dir);
+        std::string pdf_file = raw_dir + "/WBPaper00000045.pdf";
+        boost::filesystem::copy_file(pdf_dir + "/WBPaper00000045/WBPaper00000045.pdf", pdf_file,
+                                     boost::filesystem::copy_option::overwrite_if_exists);
+        std::ofstream bib(raw_dir + "/WBPaper00000045.bib");
+        bib << "author|Test author" << std::endl << "accession|WBPaper00000045" << std::endl
+            << "type|Journal_article" << std::endl << "title|Test title" << std::endl << "journal|Test journal"
+            << std::endl << "citation|Test citation" << std::endl << "year|1980" << std::endl << "abstract|"
+            << std::endl;
+        bib.close();
+        boost::filesystem::create_directories(raw_index_dir);
+        IndexManager rawIndexManager(raw_index_dir, false);
+        rawIndexManager.add_raw_files_to_index({pdf_file}, tpc::cas::FileType::pdf, "C. elegans", archive_dir);
+        // the same content is not indexed twice
+        rawIndexManager.add_raw_files_to_index({pdf_file}, tpc::cas::FileType::pdf, "C. elegans");
+        rawIndexManager.save_all_years_for_documents_to_db();
+        rawIndexManager.save_all_doc_ids_for_sentences_to_db();
+        // the archived cas file gives the same index as the raw file
+        boost::filesystem::create_directories(cas_index_dir);
+        IndexManager casIndexManager(cas_index_dir, false);
+        casIndexManager.create_index_from_existing_cas_dir(archive_dir + "/C. elegans");
+        casIndexManager.save_all_years_for_documents_to_db();
+        casIndexManager.save_all_doc_ids_for_sentences_to_db();
+        Query query;
+        query.type = QueryType::document;
+        query.keyword = "the";
+        query.case_sensitive = false;
+        query.literatures = {"C. elegans"};
+        ASSERT_EQ(rawIndexManager.search_documents(query).hit_documents.size(), 1);
+        ASSERT_EQ(casIndexManager.search_documents(query).hit_documents.size(), 1);
+        query.type = QueryType::sentence;
+        SearchResults results = rawIndexManager.search_documents(query);
+        ASSERT_GT(results.total_num_sentences, 0);
+        ASSERT_EQ(results.total_num_sentences, casIndexManager.search_documents(query).total_num_sentences);
+        boost::filesystem::remove_all("/tmp/textpresso_test/raw");
+        boost::filesystem::remove_all(raw_index_dir);
+        boost::filesystem::remove_all(archive_dir);
+        boost::filesystem::remove_all(cas_index_dir);
+    }
+
+    TEST_F(IndexManagerTest, GetMatchRangesFromTermVectors) {
+        IndexWriterOptions options;
+        options.store_term_vectors = true;
+        indexManager.set_index_writer_options(options);
+        indexManager.reindex_from_stored_fields("/tmp/textpresso_test/reindex_tv");
+        IndexManager reindexed("/tmp/textpresso_test/reindex_tv");
+        SearchResults results = reindexed.search_documents(query_document);
+        ASSERT_GT(results.hit_documents.size(), 0);
+        std::vector<std::vector<MatchRange>> ranges = reindexed.get_match_ranges(
+                query_document, {results.hit_documents[0].lucene_internal_id});
+        ASSERT_EQ(ranges.size(), 1);
+        ASSERT_GT(ranges[0].size(), 0);
+        // the offsets refer to the fulltext returned in the document details
+        std::vector<DocumentDetails> details = reindexed.get_documents_details({results.hit_documents[0]}, false,
+                                                                               false, {"fulltext_compressed"});
+        ASSERT_EQ(details.size(), 1);
+        const std::string& fulltext = details[0].fulltext;
+        for (const MatchRange& range : ranges[0]) {
+            ASSERT_LT(range.begin, range.end);
+            ASSERT_LE(range.end, fulltext.size());
+            ASSERT_EQ(range.term, "al");
+            ASSERT_EQ(boost::algorithm::to_lower_copy(fulltext.substr(range.begin, range.end - range.begin)), "al");
+        }
+        boost::filesystem::remove_all("/tmp/textpresso_test/reindex_tv");
+    }
+
+    TEST_F(IndexManagerTest, SwitchToPublishedIndexGeneration) {
+        std::string root_dir("/tmp/textpresso_test/generations");
+        std::string generation = IndexManager::create_index_generation(root_dir);
+        indexManager.reindex_from_stored_fields(generation);
+        IndexManager::publish_index_generation(root_dir, generation);
+        ASSERT_EQ(IndexManager::get_current_index_generation(root_dir), generation);
+        size_t num_hits = indexManager.search_documents(query_document).hit_documents.size();
+        IndexManager servingIndexManager(output_index_dir);
+        ASSERT_TRUE(servingIndexManager.switch_to_current_index_generation(root_dir));
+        ASSERT_EQ(servingIndexManager.search_documents(query_document).hit_documents.size(), num_hits);
+        boost::filesystem::remove_all(root_dir);
+    }
+
+    TEST_F(IndexManagerTest, SwitchWarmsUpTheDbsUsedBySearches) {
+        std::string root_dir("/tmp/textpresso_test/generations");
+        std::string generation = IndexManager::create_index_generation(root_dir);
+        indexManager.reindex_from_stored_fields(generation);
+        IndexManager::publish_index_generation(root_dir, generation);
+        IndexManager servingIndexManager(output_index_dir);
+        ASSERT_TRUE(servingIndexManager.switch_to_current_index_generation(root_dir));
+        DbCacheStats warm_stats = servingIndexManager.get_db_cache_stats();
+        ASSERT_GT(warm_stats.cache_misses, 0);
+        // the pages read by the searches have been loaded by the warm-up
+        ASSERT_GT(servingIndexManager.search_documents(query_document).hit_documents.size(), 0);
+        ASSERT_GT(servingIndexManager.search_documents(query_sentence).hit_documents.size(), 0);
+        DbCacheStats search_stats = servingIndexManager.get_db_cache_stats();
+        ASSERT_GT(search_stats.cache_hits, warm_stats.cache_hits);
+        ASSERT_EQ(search_stats.cache_misses, warm_stats.cache_misses);
+        boost::filesystem::remove_all(root_dir);
+    }
+
     TEST_F(IndexManagerTest, DeleteDocument) {
         indexManager.remove_file_from_index("C. elegans/WBPaper00046156/WBPaper00046156.tpcas.gz");
     }
@@ -0,0 +1,115 @@
+/**
+    Project: libtpc
+    File name: test_tptrie.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include <stdexcept>
+#include "gtest/gtest.h"
+#include "../uima-annotators/TpTrie/TpTrie.h"
+
+namespace {
+
+    class TpTrieTest : public testing::Test {
+    protected:
+
+        static UnicodeString utf8(const char* s) {
+            return UnicodeString::fromUTF8(s);
+        }
+
+        TpTrie trie;
+    };
+
+    TEST_F(TpTrieTest, SingleDictionaryFindsOverlappingWords) {
+        trie.addWord(utf8("ab"));
+        trie.addWord(utf8("b"));
+        trie.addWord(utf8("abc"));
+        ASSERT_EQ(trie.searchAllWords(utf8("xabcab")), TpMatches({{1, 2}, {1, 3}, {2, 2}, {4, 5}, {5, 5}}));
+    }
+
+    TEST_F(TpTrieTest, EmptyTextHasNoMatches) {
+        trie.addWord(utf8("a"));
+        ASSERT_TRUE(trie.searchAllWords(utf8("")).empty());
+    }
+
+    TEST_F(TpTrieTest, MultipleDictionariesAreSearchedInOnePass) {
+        trie.addWord(utf8(" "), 0);
+        trie.addWord(utf8("."), 0);
+        trie.addWord(utf8("<_pdf_"), 1);
+        trie.addWord(utf8("</_pdf_"), 1);
+        trie.addWord(utf8("_pdf_"), 3);
+        vector<TpMatches> matches;
+        trie.searchAllWords(utf8("a <_pdf_ b.</_pdf_"), matches);
+        ASSERT_EQ(matches.size(), 4);
+        ASSERT_EQ(matches[0], TpMatches({{1, 1}, {8, 8}, {10, 10}}));
+        ASSERT_EQ(matches[1], TpMatches({{2, 7}, {11, 17}}));
+        ASSERT_TRUE(matches[2].empty());
+        ASSERT_EQ(matches[3], TpMatches({{3, 7}, {13, 17}}));
+    }
+
+    TEST_F(TpTrieTest, WordInMoreDictionariesIsReportedOnceByAllWordsSearch) {
+        trie.addWord(utf8("ab"), 0);
+        trie.addWord(utf8("ab"), 2);
+        vector<TpMatches> matches;
+        trie.searchAllWords(utf8("abab"), matches);
+        ASSERT_EQ(matches[0], TpMatches({{0, 1}, {2, 3}}));
+        ASSERT_TRUE(matches[1].empty());
+        ASSERT_EQ(matches[2], TpMatches({{0, 1}, {2, 3}}));
+        ASSERT_EQ(trie.searchAllWords(utf8("abab")), TpMatches({{0, 1}, {2, 3}}));
+    }
+
+    TEST_F(TpTrieTest, EmptyWordMatchesAtEveryPosition) {
+        trie.addWord(utf8(""), 1);
+        trie.addWord(utf8("b"), 0);
+        vector<TpMatches> matches;
+        trie.searchAllWords(utf8("abc"), matches);
+        ASSERT_EQ(matches[0], TpMatches({{1, 1}}));
+        // empty matches end before they begin
+        ASSERT_EQ(matches[1], TpMatches({{0, -1}, {1, 0}, {2, 1}}));
+    }
+
+    TEST_F(TpTrieTest, NonAsciiWordsAreMatched) {
+        trie.addWord(utf8("\xC3\xA9"), 0);
+        trie.addWord(utf8("\xCE\xB1-\xCE\xB2"), 0);
+        trie.addWord(utf8("\xCE\xB2"), 1);
+        vector<TpMatches> matches;
+        trie.searchAllWords(utf8("\xCE\xB1\xCE\xB2 \xC3\xA9 \xCE\xB1-\xCE\xB2"), matches);
+        ASSERT_EQ(matches[0], TpMatches({{3, 3}, {5, 7}}));
+        ASSERT_EQ(matches[1], TpMatches({{1, 1}, {7, 7}}));
+    }
+
+    TEST_F(TpTrieTest, WordsAddedAfterSearchAreFound) {
+        trie.addWord(utf8("a"));
+        ASSERT_EQ(trie.searchAllWords(utf8("abc")), TpMatches({{0, 0}}));
+        trie.addWord(utf8("bc"), 1);
+        ASSERT_EQ(trie.searchAllWords(utf8("abc")), TpMatches({{0, 0}, {1, 2}}));
+        vector<TpMatches> matches;
+        trie.searchAllWords(utf8("abc"), matches);
+        ASSERT_EQ(matches.size(), 2);
+        ASSERT_EQ(matches[1], TpMatches({{1, 2}}));
+        // words that extend the compiled ones keep the failure links to them
+        trie.addWord(utf8("abc"), 2);
+        trie.searchAllWords(utf8("abcbc"), matches);
+        ASSERT_EQ(matches.size(), 3);
+        ASSERT_EQ(matches[0], TpMatches({{0, 0}}));
+        ASSERT_EQ(matches[1], TpMatches({{1, 2}, {3, 4}}));
+        ASSERT_EQ(matches[2], TpMatches({{0, 2}}));
+    }
+
+    TEST_F(TpTrieTest, DictionaryOutOfRangeIsRejected) {
+        ASSERT_THROW(trie.addWord(utf8("a"), -1), std::invalid_argument);
+        ASSERT_THROW(trie.addWord(utf8("a"), TpTrie::MAX_DICTIONARIES), std::invalid_argument);
+        trie.addWord(utf8("a"), TpTrie::MAX_DICTIONARIES - 1);
+        vector<TpMatches> matches;
+        trie.searchAllWords(utf8("a"), matches);
+        ASSERT_EQ(matches.size(), TpTrie::MAX_DICTIONARIES);
+        ASSERT_EQ(matches[TpTrie::MAX_DICTIONARIES - 1], TpMatches({{0, 0}}));
+    }
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
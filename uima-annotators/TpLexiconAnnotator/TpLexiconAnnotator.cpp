@@ -28,6 +28,15 @@ TyErrorId TpLexiconAnnotator::initialize(AnnotatorContext & rclAnnotatorContext)
         return UIMA_ERR_USER_ANNOTATOR_COULD_NOT_INIT;
     }
     trie = new TpLexiconTrie();
+    std::string categorydictionaryfile;
+    if (rclAnnotatorContext.isParameterDefined("CategoryDictionaryFile") &&
+            rclAnnotatorContext.extractValue("CategoryDictionaryFile", categorydictionaryfile) == UIMA_ERR_NONE) {
+        // the category dictionary of the index is only read, categories that are not in the dictionary get ids
+        // after the ones of the index
+        tpc::index::CategoryDictionary categorydictionary;
+        categorydictionary.load(categorydictionaryfile);
+        trie->useCategoryDictionary(categorydictionary);
+    }
     std::ifstream f(locallexiconfile.c_str());
     string in;
     while (getline(f, in)) {
@@ -67,11 +76,11 @@ TyErrorId TpLexiconAnnotator::process(CAS & tcas, ResultSpecification const & cr
     getAnnotatorContext().getLogger().logMessage("process called");
     UnicodeString dst;
     ulstrDoc.extract(0, ulstrDoc.length(), dst);
-    vector<ppiiU> p = trie->searchAllWords(dst);
-    vector<ppiiU>::iterator it;
+    vector<ppiiI> p = trie->searchAllWords(dst);
+    vector<ppiiI>::iterator it;
     for (it = p.begin(); it < p.end(); it++) {
         pair<int32_t, int32_t> be = (*it).first;
-        UnicodeString a = (*it).second;
+        const UnicodeString & a = trie->getAnnotation((*it).second);
         int32_t b = be.first;
         int32_t e = be.second + 1;
         AnnotationFS fsNewExp = tcas.createAnnotation(lexanntype, b, e);
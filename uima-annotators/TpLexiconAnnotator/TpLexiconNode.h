@@ -21,9 +21,9 @@ public:
     UChar content() { return content_; }
     void setContent(UChar c) { content_ = c; }
     UnicodeString PopOneAnnotation();
-    void PushBackAnnotation(UnicodeString s) { annotation_.push_back(s); }
-    long unsigned int AnnotationVectorSize() { return annotation_.size(); }
-    UnicodeString GetVectorElement(long unsigned int i) { return annotation_.at(i); }
+    void PushBackAnnotation(long unsigned int i) { annotationid_.push_back(i); }
+    long unsigned int AnnotationVectorSize() { return annotationid_.size(); }
+    long unsigned int GetVectorElement(long unsigned int i) { return annotationid_.at(i); }
     bool wordMarker() { return marker_; }
     void setWordMarker() { marker_ = true; }
     TpLexiconNode * findChild(UChar c);
@@ -33,7 +33,7 @@ private:
     UChar content_;
     bool marker_;
     vector<TpLexiconNode*> children_;
-    vector<UnicodeString> annotation_;
+    vector<long unsigned int> annotationid_;
 };
 
 #endif	/* TPLEXICONNODE_H */
@@ -11,6 +11,7 @@
 using namespace std;
 
 TpLexiconTrie::TpLexiconTrie() {
+    idcounter_ = 0;
     root = new TpLexiconNode();
     dlsetToken = set<UnicodeString>(G_initT, G_initT + G_initT_No);
     set<UnicodeString>::iterator it;
@@ -26,6 +27,17 @@ TpLexiconTrie::TpLexiconTrie(const TpLexiconTrie & orig) {
 TpLexiconTrie::~TpLexiconTrie() {
 }
 
+void TpLexiconTrie::useCategoryDictionary(const tpc::index::CategoryDictionary & dictionary) {
+    for (size_t id = 0; id < dictionary.size(); id++) {
+        const wstring & name = dictionary.get_name(id);
+        UnicodeString annotation;
+        for (wchar_t c : name) {
+            annotation.append(static_cast<UChar32> (c));
+        }
+        annotation2id(annotation);
+    }
+}
+
 void TpLexiconTrie::addWord(UnicodeString s, UnicodeString annotation) {
     TpLexiconNode * current = root;
     if (s.length() == 0) return;
@@ -41,18 +53,18 @@ void TpLexiconTrie::addWord(UnicodeString s, UnicodeString annotation) {
         }
         if (i == s.length() - 1) {
             current->setWordMarker();
-            current->PushBackAnnotation(annotation);
+            current->PushBackAnnotation(annotation2id(annotation));
         }
     }
 }
 
-vector<ppiiU> TpLexiconTrie::searchAllWords(UnicodeString s) {
-    vector<ppiiU> result;
+vector<ppiiI> TpLexiconTrie::searchAllWords(UnicodeString s) {
+    vector<ppiiI> result;
     result.clear();
     vector< pair<int32_t, int32_t> > dls = trieToken->searchAllWords(s);
     sort(dls.begin(), dls.end());
     map<int32_t, bool> fb;
-    map<ppiiU, bool> alreadyseen;
+    set<ppiiI> alreadyseen;
     vector< pair<int32_t, int32_t> >::iterator it;
     for (it = dls.begin(); it != dls.end(); it++) fb[(*it).first] = true;
     for (it = dls.begin(); it != dls.end(); it++) {
@@ -65,11 +77,10 @@ vector<ppiiU> TpLexiconTrie::searchAllWords(UnicodeString s) {
                     if (fb[i]) {
                         pair<int32_t, int32_t> p = make_pair(j, i - 1);
                         for (long unsigned int k = 0; k < current->AnnotationVectorSize(); k++) {
-                            UnicodeString a = current->GetVectorElement(k);
-                            ppiiU aux = make_pair(p, a);
-                            if (!alreadyseen[aux]) {
-                                alreadyseen[aux] = true;
-                                result.push_back(make_pair(p, a));
+                            long unsigned int a = current->GetVectorElement(k);
+                            ppiiI aux = make_pair(p, a);
+                            if (alreadyseen.insert(aux).second) {
+                                result.push_back(aux);
                             }
                         }
                     }
@@ -85,11 +96,10 @@ vector<ppiiU> TpLexiconTrie::searchAllWords(UnicodeString s) {
                 if (current->wordMarker()) {
                     pair<int32_t, int32_t> p = make_pair(j, s.length() - 1);
                     for (long unsigned int k = 0; k < current->AnnotationVectorSize(); k++) {
-                        UnicodeString a = current->GetVectorElement(k);
-                        ppiiU aux = make_pair(p, a);
-                        if (!alreadyseen[aux]) {
-                            alreadyseen[aux] = true;
-                            result.push_back(make_pair(p, a));
+                        long unsigned int a = current->GetVectorElement(k);
+                        ppiiI aux = make_pair(p, a);
+                        if (alreadyseen.insert(aux).second) {
+                            result.push_back(aux);
                         }
                     }
                 }
@@ -97,3 +107,14 @@ vector<ppiiU> TpLexiconTrie::searchAllWords(UnicodeString s) {
     }
     return result;
 }
+
+long unsigned int TpLexiconTrie::annotation2id(UnicodeString annotation) {
+    std::map<UnicodeString, long unsigned int>::iterator it;
+    it = a2i_.find(annotation);
+    if (it == a2i_.end()) {
+        a2i_[annotation] = idcounter_;
+        i2a_.push_back(annotation);
+        idcounter_++;
+    }
+    return a2i_[annotation];
+}
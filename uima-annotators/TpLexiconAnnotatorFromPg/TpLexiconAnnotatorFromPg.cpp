@@ -57,6 +57,15 @@ uima::TyErrorId TpLexiconAnnotatorFromPg::initialize(uima::AnnotatorContext & rc
     w.commit();
     cn.disconnect();
     trie_ = new TpLexiconTrie();
+    std::string categorydictionaryfile;
+    if (rclAnnotatorContext.isParameterDefined("CategoryDictionaryFile") &&
+            rclAnnotatorContext.extractValue("CategoryDictionaryFile", categorydictionaryfile) == UIMA_ERR_NONE) {
+        // the category dictionary of the index is only read, categories that are not in the dictionary get ids
+        // after the ones of the index
+        tpc::index::CategoryDictionary categorydictionary;
+        categorydictionary.load(categorydictionaryfile);
+        trie_->useCategoryDictionary(categorydictionary);
+    }
     AllMyParents * amp = new AllMyParents();
     std::multimap<std::string, std::string> mmamp(amp->GetCPs());
     while (!term.empty()) {
@@ -122,11 +131,11 @@ uima::TyErrorId TpLexiconAnnotatorFromPg::process(uima::CAS & tcas, uima::Result
     getAnnotatorContext().getLogger().logMessage("process called");
     UnicodeString dst;
     ulstrDoc.extract(0, ulstrDoc.length(), dst);
-    vector<ppiiU> p = trie_->searchAllWords(dst);
-    vector<ppiiU>::iterator it;
+    vector<ppiiI> p = trie_->searchAllWords(dst);
+    vector<ppiiI>::iterator it;
     for (it = p.begin(); it < p.end(); it++) {
         pair<int32_t, int32_t> be = (*it).first;
-        UnicodeString a = (*it).second;
+        const UnicodeString & a = trie_->getAnnotation((*it).second);
         int32_t b = be.first;
         int32_t e = be.second + 1;
         uima::AnnotationFS fsNewExp = tcas.createAnnotation(lexanntype_, b, e);
@@ -27,6 +27,17 @@ TpLexiconTrie::TpLexiconTrie(const TpLexiconTrie & orig) {
 TpLexiconTrie::~TpLexiconTrie() {
 }
 
+void TpLexiconTrie::useCategoryDictionary(const tpc::index::CategoryDictionary & dictionary) {
+    for (size_t id = 0; id < dictionary.size(); id++) {
+        const wstring & name = dictionary.get_name(id);
+        UnicodeString annotation;
+        for (wchar_t c : name) {
+            annotation.append(static_cast<UChar32> (c));
+        }
+        annotation2id(annotation);
+    }
+}
+
 void TpLexiconTrie::addWord(UnicodeString s, UnicodeString annotation) {
     TpLexiconNode * current = root;
     if (s.length() == 0) return;
@@ -47,13 +58,13 @@ void TpLexiconTrie::addWord(UnicodeString s, UnicodeString annotation) {
     }
 }
 
-vector<ppiiU> TpLexiconTrie::searchAllWords(UnicodeString s) {
-    vector<ppiiU> result;
+vector<ppiiI> TpLexiconTrie::searchAllWords(UnicodeString s) {
+    vector<ppiiI> result;
     result.clear();
     vector< pair<int32_t, int32_t> > dls = trieToken->searchAllWords(s);
     sort(dls.begin(), dls.end());
     map<int32_t, bool> fb;
-    map<ppiiU, bool> alreadyseen;
+    set<ppiiI> alreadyseen;
     vector< pair<int32_t, int32_t> >::iterator it;
     for (it = dls.begin(); it != dls.end(); it++) fb[(*it).first] = true;
     for (it = dls.begin(); it != dls.end(); it++) {
@@ -66,11 +77,10 @@ vector<ppiiU> TpLexiconTrie::searchAllWords(UnicodeString s) {
                     if (fb[i]) {
                         pair<int32_t, int32_t> p = make_pair(j, i - 1);
                         for (long unsigned int k = 0; k < current->AnnotationVectorSize(); k++) {
-                            UnicodeString a = id2annotation(current->GetVectorElement(k));
-                            ppiiU aux = make_pair(p, a);
-                            if (!alreadyseen[aux]) {
-                                alreadyseen[aux] = true;
-                                result.push_back(make_pair(p, a));
+                            long unsigned int a = current->GetVectorElement(k);
+                            ppiiI aux = make_pair(p, a);
+                            if (alreadyseen.insert(aux).second) {
+                                result.push_back(aux);
                             }
                         }
                     }
@@ -86,11 +96,10 @@ vector<ppiiU> TpLexiconTrie::searchAllWords(UnicodeString s) {
                 if (current->wordMarker()) {
                     pair<int32_t, int32_t> p = make_pair(j, s.length() - 1);
                     for (long unsigned int k = 0; k < current->AnnotationVectorSize(); k++) {
-                        UnicodeString a = id2annotation(current->GetVectorElement(k));
-                        ppiiU aux = make_pair(p, a);
-                        if (!alreadyseen[aux]) {
-                            alreadyseen[aux] = true;
-                            result.push_back(make_pair(p, a));
+                        long unsigned int a = current->GetVectorElement(k);
+                        ppiiI aux = make_pair(p, a);
+                        if (alreadyseen.insert(aux).second) {
+                            result.push_back(aux);
                         }
                     }
                 }
@@ -10,19 +10,25 @@
 
 #include <vector>
 #include "TpLexiconNode.h"
-#include "../TpTokenizer/TpTrie.h"
+#include "../TpTrie/TpTrie.h"
+#include "../../CategoryDictionary.h"
 
 using namespace std;
 
-typedef pair<pair<int32_t, int32_t>, UnicodeString> ppiiU;
+// a match of a lexicon term, with its boundaries and the id of its annotation
+typedef pair<pair<int32_t, int32_t>, long unsigned int> ppiiI;
 
 class TpLexiconTrie {
 public:
     TpLexiconTrie();
     TpLexiconTrie(const TpLexiconTrie & orig);
     virtual ~TpLexiconTrie();
+    // reserve the ids of the categories of an index category dictionary, so that annotation ids are the category
+    // ids of the index. Must be called before any word is added
+    void useCategoryDictionary(const tpc::index::CategoryDictionary & dictionary);
     void addWord(UnicodeString s, UnicodeString annotation);
-    vector<ppiiU> searchAllWords(UnicodeString s);
+    vector<ppiiI> searchAllWords(UnicodeString s);
+    const UnicodeString & getAnnotation(long unsigned int i) const { return i2a_[i]; }
 private:
     TpLexiconNode * root;
     std::set<UnicodeString> dlsetToken;
@@ -31,7 +37,6 @@ private:
     std::map<UnicodeString, long unsigned int> a2i_;
     std::vector<UnicodeString> i2a_;
     long unsigned int annotation2id(UnicodeString annotation);
-    UnicodeString id2annotation(long unsigned int i) { return i2a_[i]; }
 };
 
 #endif	/* TPLEXICONTRIE_H */
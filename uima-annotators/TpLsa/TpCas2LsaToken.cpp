@@ -7,14 +7,9 @@
 
 #include "TpCas2LsaToken.h"
 
-#include "xercesc/util/XMLString.hpp"
 #include <uima/api.hpp>
-#include "uima/xmideserializer.hpp"
-
-#include <boost/iostreams/filtering_streambuf.hpp>
-#include <boost/iostreams/copy.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/filesystem.hpp>
+#include "../../CASManager.h"
+#include <fstream>
 
 enum rawsourcetype {
     unknown, nxml, pdf
@@ -22,24 +17,6 @@ enum rawsourcetype {
 
 namespace {
 
-    std::string uncompressGzip2(std::string gzFile) {
-        std::ifstream filein(gzFile.c_str(), std::ios_base::in | std::ios_base::binary);
-        boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
-        in.push(boost::iostreams::gzip_decompressor());
-        in.push(filein);
-        char tmpname[L_tmpnam];
-        char * pDummy = tmpnam(tmpname);
-        std::string tmpfile(tmpname);
-        while (boost::filesystem::exists(tmpfile)) {
-            char * pDummy = tmpnam(tmpname);
-            tmpfile = std::string(tmpname);
-        }
-        std::ofstream out(tmpfile.c_str());
-        boost::iostreams::copy(in, out);
-        out.close();
-        return tmpfile;
-    }
-
     //[ Uima related
 
     uima::AnalysisEngine * CreateUimaEngine(const char * descriptor) {
@@ -56,21 +33,20 @@ namespace {
         return ret;
     }
 
-    uima::CAS * GetCas(const char * pszInputFile, uima::AnalysisEngine * pEngine) {
+    uima::CAS * GetCas(const std::string & tpcasfilename, uima::AnalysisEngine * pEngine) {
         uima::CAS * ret = pEngine->newCAS();
         if (ret == NULL) {
             std::cerr << "pEngine_->newCAS() failed." << std::endl;
         } else {
             try {
-                /* initialize from an xmicas */
-                XMLCh * native = XMLString::transcode(pszInputFile);
-                LocalFileInputSource fileIS(native);
-                XMLString::release(&native);
-                uima::XmiDeserializer::deserialize(fileIS, * ret, true);
+                /* initialize from a compressed cas, in xmi or compact format */
+                tpc::cas::CASManager::read_compressed_cas(tpcasfilename, * ret);
             } catch (uima::Exception e) {
                 uima::ErrorInfo errInfo = e.getErrorInfo();
                 std::cerr << "Error " << errInfo.getErrorId() << " " << errInfo.getMessage() << std::endl;
                 std::cerr << errInfo << std::endl;
+            } catch (std::exception & e) {
+                std::cerr << "Error reading " << tpcasfilename << ": " << e.what() << std::endl;
             }
         }
         return ret;
@@ -84,9 +60,7 @@ TpCas2LsaToken::TpCas2LsaToken(std::string tpcasfilename) {
     (void) uima::ResourceManager::createInstance("TPCAS2TPCENTRALAE");
     //time_t now = time(0);
     uima::AnalysisEngine * pEngine = CreateUimaEngine(TPCAS2TPCENTRALDESCRIPTOR);
-    std::string tmpfl = uncompressGzip2(tpcasfilename);
-    uima::CAS * pcas = GetCas(tmpfl.c_str(), pEngine);
-    boost::filesystem::remove(tmpfl);
+    uima::CAS * pcas = GetCas(tpcasfilename, pEngine);
     rawsourcetype rawsource = unknown;
     LoadStopwords("/home/mueller/NetBeansProjects/TpUimaAnnotators/TpLsa/resources/stopwords");
     uima::Type rawtype = pcas->getTypeSystem().getType(UnicodeString("org.apache.uima.textpresso.rawsource"));
@@ -179,6 +153,10 @@ TpCas2LsaToken::TpCas2LsaToken(std::string tpcasfilename) {
                 if (begin > blockeduntil) {
                     uima::Feature f = currentType.getFeatureByBaseName("content");
                     uima::UnicodeStringRef content = aait4.get().getStringValue(f);
+                    // annotations written in compact mode do not store their content
+                    if (content.length() == 0) {
+                        content = aait4.get().getCoveredText();
+                    }
                     std::string nword = Normalize(content.asUTF8());
                     if (nword.size() != 0)
                         if (!stopwords_[nword])
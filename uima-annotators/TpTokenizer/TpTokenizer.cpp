@@ -14,6 +14,11 @@
 
 using namespace std;
 
+// dictionaries of the delimiter trie
+static const int32_t TOKEN_DELIMITERS = 0;
+static const int32_t SENTENCE_DELIMITERS = 1;
+static const int32_t PDF_TAGS = 2;
+
 /* magic numbers from http://www.isthe.com/chongo/tech/comp/fnv/ */
 static const uint64_t InitialFNV = 14695981039346656037U;
 static const uint64_t FNVMultiple = 1099511628211;
@@ -57,7 +62,8 @@ pair<int32_t, int32_t> MaximizeBoundaries(pair<int32_t, int32_t> i,
 
 void WriteOutAnnotations(CAS & tcas, const UnicodeStringRef usdocref,
         vector< pair<int32_t, int32_t> > & p, Type t1, Feature f1,
-        Type t2, Feature f2, AnnotationCounter & ac, bool writeoutdelimiters) {
+        Type t2, Feature f2, Feature faid, AnnotationCounter & ac, bool writeoutdelimiters,
+        bool writeoutcontent) {
     FSIndexRepository & indexRep = tcas.getIndexRepository();
     vector< pair<int32_t, int32_t> > merged;
     merged.clear();
@@ -82,10 +88,11 @@ void WriteOutAnnotations(CAS & tcas, const UnicodeStringRef usdocref,
         int32_t e = (*it).second;
         if (b != laste) {
             AnnotationFS fsNewTok = tcas.createAnnotation(t2, laste, b);
-            UnicodeString wd;
-            usdocref.extract(laste, b - laste, wd);
-            fsNewTok.setStringValue(f2, wd);
-            Feature faid = t2.getFeatureByBaseName("aid");
+            if (writeoutcontent) {
+                UnicodeString wd;
+                usdocref.extract(laste, b - laste, wd);
+                fsNewTok.setStringValue(f2, wd);
+            }
             if (faid.isValid())
                 fsNewTok.setIntValue(faid, ac.GetNextId());
             indexRep.addFS(fsNewTok);
@@ -93,10 +100,11 @@ void WriteOutAnnotations(CAS & tcas, const UnicodeStringRef usdocref,
         laste = e;
         if (writeoutdelimiters) {
             AnnotationFS fsNewTok = tcas.createAnnotation(t2, b, e);
-            UnicodeString wd;
-            usdocref.extract(b, e - b, wd);
-            fsNewTok.setStringValue(f2, wd);
-            Feature faid = t2.getFeatureByBaseName("aid");
+            if (writeoutcontent) {
+                UnicodeString wd;
+                usdocref.extract(b, e - b, wd);
+                fsNewTok.setStringValue(f2, wd);
+            }
             if (faid.isValid())
                 fsNewTok.setIntValue(faid, ac.GetNextId());
             indexRep.addFS(fsNewTok);
@@ -180,18 +188,21 @@ TpTokenizer::~TpTokenizer() {
 }
 
 TyErrorId TpTokenizer::initialize(AnnotatorContext & rclAnnotatorContext) {
+    // in compact mode the content of tokens and sentences is not stored, as it can be derived from their
+    // begin and end positions, and delimiters are not annotated as tokens
+    compactMode = false;
+    if (rclAnnotatorContext.isParameterDefined("CompactMode")) {
+        rclAnnotatorContext.extractValue("CompactMode", compactMode);
+    }
     set<UnicodeString>::iterator it;
-    trieToken = new TpTrie();
     for (it = dlsetToken.begin(); it != dlsetToken.end(); it++) {
-        trieToken->addWord(*it);
+        delimiterTrie.addWord(*it, TOKEN_DELIMITERS);
     }
-    trieSentence = new TpTrie();
     for (it = dlsetSentence.begin(); it != dlsetSentence.end(); it++) {
-        trieSentence->addWord(*it);
+        delimiterTrie.addWord(*it, SENTENCE_DELIMITERS);
     }
-    triePdfTags = new TpTrie();
     for (it = PdfTags.begin(); it != PdfTags.end(); it++) {
-        triePdfTags->addWord(*it);
+        delimiterTrie.addWord(*it, PDF_TAGS);
     }
     return (TyErrorId) UIMA_ERR_NONE;
 }
@@ -221,6 +232,8 @@ TyErrorId TpTokenizer::typeSystemInit(TypeSystem const & crTypeSystem) {
         return (TyErrorId) UIMA_ERR_RESMGR_INVALID_RESOURCE;
     }
     tokentype_content = tokentype.getFeatureByBaseName("content");
+    // the optional annotation id feature is resolved here, not for each annotation written out
+    tokentype_aid = tokentype.getFeatureByBaseName("aid");
     tokendelimitertype =
             crTypeSystem.getType("org.apache.uima.textpresso.tokendelimiter");
     if (!tokendelimitertype.isValid()) {
@@ -239,6 +252,7 @@ TyErrorId TpTokenizer::typeSystemInit(TypeSystem const & crTypeSystem) {
         return (TyErrorId) UIMA_ERR_RESMGR_INVALID_RESOURCE;
     }
     sentencetype_content = sentencetype.getFeatureByBaseName("content");
+    sentencetype_aid = sentencetype.getFeatureByBaseName("aid");
     sentencedelimitertype =
             crTypeSystem.getType("org.apache.uima.textpresso.sentencedelimiter");
     if (!sentencedelimitertype.isValid()) {
@@ -296,23 +310,21 @@ TyErrorId TpTokenizer::process(CAS & tcas, ResultSpecification const & crResultS
     UnicodeString dst;
     usdocref.extract(0, usdocref.length(), dst);
 
-    vector< pair<int32_t, int32_t> > p = trieToken->searchAllWords(dst);
-    sort(p.begin(), p.end()); // just to make sure it is sorted.
-    WriteOutAnnotations(tcas, usdocref, p,
+    // matches are sorted by begin and end position
+    vector<TpMatches> matches;
+    delimiterTrie.searchAllWords(dst, matches);
+    matches.resize(PDF_TAGS + 1);
+    WriteOutAnnotations(tcas, usdocref, matches[TOKEN_DELIMITERS],
             tokendelimitertype, tokendelimitertype_content,
-            tokentype, tokentype_content, ac, true);
+            tokentype, tokentype_content, tokentype_aid, ac, !compactMode, !compactMode);
 
-    p.clear();
-    p = trieSentence->searchAllWords(dst);
-    p = RemoveDelimiters(usdocref, disqSentence, p,
+    vector< pair<int32_t, int32_t> > p = RemoveDelimiters(usdocref, disqSentence, matches[SENTENCE_DELIMITERS],
             maxfrontdisqcharlength, maxbackdisqcharlength);
     sort(p.begin(), p.end());
     WriteOutAnnotations(tcas, usdocref, p,
             sentencedelimitertype, sentencedelimitertype_content,
-            sentencetype, sentencetype_content, ac, false);
-    p.clear();
-    p = triePdfTags->searchAllWords(dst);
-    WriteOutPdfTags(tcas, usdocref, p, pdftagtype, pdftagtype_tagtype, pdftagtype_value);
+            sentencetype, sentencetype_content, sentencetype_aid, ac, false, !compactMode);
+    WriteOutPdfTags(tcas, usdocref, matches[PDF_TAGS], pdftagtype, pdftagtype_tagtype, pdftagtype_value);
 
     //    Consider introducing hyphenated word annotation;
     //    Here is the pattern from the old Tokenizer Perl script.
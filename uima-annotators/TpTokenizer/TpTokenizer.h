@@ -10,7 +10,7 @@
 
 #include <set>
 #include <uima/api.hpp>
-#include "TpTrie.h"
+#include "../TpTrie/TpTrie.h"
 
 using namespace uima;
 
@@ -31,10 +31,12 @@ private:
     Type tokentype;
     Type tokendelimitertype;
     Feature tokentype_content;
+    Feature tokentype_aid;
     Feature tokendelimitertype_content;
     Type sentencetype;
     Type sentencedelimitertype;
     Feature sentencetype_content;
+    Feature sentencetype_aid;
     Feature sentencedelimitertype_content;
     Type tpfnvhashtype;
     Feature tpfnvhashtype_content;
@@ -42,16 +44,16 @@ private:
     Feature pdftagtype_tagtype;
     Feature pdftagtype_value;
     
+    bool compactMode;
     CAS * tcas;
     std::set<UnicodeString> dlsetToken;
-    TpTrie * trieToken;
     std::set<UnicodeString> dlsetSentence;
     vector<string> disqSentence;
     int32_t maxfrontdisqcharlength;
     int32_t maxbackdisqcharlength;
-    TpTrie * trieSentence;
-    TpTrie * triePdfTags;
     std::set<UnicodeString> PdfTags;
+    // token delimiters, sentence delimiters and pdf tags, found in a single pass over the sofa
+    TpTrie delimiterTrie;
 };
 
 #endif	/* TPTOKENIZER_H */
@@ -0,0 +1,203 @@
+/**
+    Project: libtpc
+    File name: TpTrie.cpp
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#include "TpTrie.h"
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <stdexcept>
+
+using namespace std;
+
+const int32_t TpTrie::MAX_DICTIONARIES;
+
+TpTrie::TpTrie() : nodes(1), numDictionaries(0), compiled(false) {
+    nodes[0].fail = 0;
+    nodes[0].output = -1;
+    nodes[0].depth = 0;
+    nodes[0].dictionaries = 0;
+}
+
+void TpTrie::addWord(const UnicodeString& s, int32_t dictionary) {
+    if (dictionary < 0 || dictionary >= MAX_DICTIONARIES) {
+        throw invalid_argument("dictionary index out of range: " + to_string(dictionary));
+    }
+    if (compiled) {
+        decompile();
+    }
+    int32_t current = 0;
+    for (int32_t i = 0; i < s.length(); i++) {
+        int32_t child = findChild(current, s[i]);
+        if (child < 0) {
+            child = static_cast<int32_t>(nodes.size());
+            Node node;
+            node.fail = 0;
+            node.output = -1;
+            node.depth = nodes[current].depth + 1;
+            node.dictionaries = 0;
+            nodes.push_back(node);
+            vector< pair<UChar, int32_t> >& children = nodes[current].children;
+            children.insert(lower_bound(children.begin(), children.end(), make_pair(s[i], INT32_MIN)),
+                    make_pair(s[i], child));
+        }
+        current = child;
+    }
+    nodes[current].dictionaries |= 1u << dictionary;
+    numDictionaries = max(numDictionaries, dictionary + 1);
+    compiled = false;
+}
+
+TpMatches TpTrie::searchAllWords(const UnicodeString& s) {
+    TpMatches result;
+    scan(s, [&result](int32_t b, int32_t e, uint32_t) {
+        result.push_back(make_pair(b, e));
+    });
+    // matches are found in order of end position, so they are usually already sorted
+    if (!is_sorted(result.begin(), result.end())) {
+        sort(result.begin(), result.end());
+    }
+    return result;
+}
+
+void TpTrie::searchAllWords(const UnicodeString& s, vector<TpMatches>& matches) {
+    matches.assign(numDictionaries, TpMatches());
+    scan(s, [&matches](int32_t b, int32_t e, uint32_t dictionaries) {
+        for (int32_t d = 0; dictionaries != 0; d++, dictionaries >>= 1) {
+            if (dictionaries & 1u) {
+                matches[d].push_back(make_pair(b, e));
+            }
+        }
+    });
+    // matches are found in order of end position, so they are usually already sorted
+    for (TpMatches& dictionaryMatches : matches) {
+        if (!is_sorted(dictionaryMatches.begin(), dictionaryMatches.end())) {
+            sort(dictionaryMatches.begin(), dictionaryMatches.end());
+        }
+    }
+}
+
+int32_t TpTrie::findChild(int32_t node, UChar c) const {
+    const vector< pair<UChar, int32_t> >& children = nodes[node].children;
+    auto it = lower_bound(children.begin(), children.end(), make_pair(c, INT32_MIN));
+    return it != children.end() && it->first == c ? it->second : -1;
+}
+
+void TpTrie::compile() {
+    // states are numbered in breadth-first order, so that the short words at the top of the trie are close together
+    vector<int32_t> order(1, 0);
+    order.reserve(nodes.size());
+    for (const auto& child : nodes[0].children) {
+        nodes[child.second].fail = 0;
+        nodes[child.second].output = -1;
+        order.push_back(child.second);
+    }
+    for (size_t next = 1; next < order.size(); next++) {
+        int32_t state = order[next];
+        for (const auto& child : nodes[state].children) {
+            int32_t fail = nodes[state].fail;
+            int32_t failChild = findChild(fail, child.first);
+            while (fail != 0 && failChild < 0) {
+                fail = nodes[fail].fail;
+                failChild = findChild(fail, child.first);
+            }
+            Node& node = nodes[child.second];
+            node.fail = failChild >= 0 ? failChild : 0;
+            // the empty word of the root is reported separately
+            node.output = node.fail != 0 && nodes[node.fail].dictionaries != 0 ? node.fail : nodes[node.fail].output;
+            order.push_back(child.second);
+        }
+    }
+    vector<int32_t> stateOf(nodes.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        stateOf[order[i]] = static_cast<int32_t>(i);
+    }
+    states.resize(order.size());
+    labels.clear();
+    targets.clear();
+    labels.reserve(nodes.size() - 1);
+    targets.reserve(nodes.size() - 1);
+    for (size_t i = 0; i < order.size(); i++) {
+        const Node& node = nodes[order[i]];
+        State& state = states[i];
+        state.firstChild = static_cast<int32_t>(labels.size());
+        state.numChildren = static_cast<int32_t>(node.children.size());
+        state.fail = stateOf[node.fail];
+        state.output = node.output >= 0 ? stateOf[node.output] : -1;
+        state.depth = node.depth;
+        state.dictionaries = node.dictionaries;
+        for (const auto& child : node.children) {
+            labels.push_back(child.first);
+            targets.push_back(stateOf[child.second]);
+        }
+    }
+    fill(rootAscii, rootAscii + ASCII_TABLE_SIZE, -1);
+    for (int32_t i = 0; i < states[0].numChildren && labels[i] < ASCII_TABLE_SIZE; i++) {
+        rootAscii[labels[i]] = targets[i];
+    }
+    // the builder nodes are rebuilt from the states if more words are added
+    vector<Node>().swap(nodes);
+    compiled = true;
+}
+
+void TpTrie::decompile() {
+    nodes.resize(states.size());
+    for (size_t i = 0; i < states.size(); i++) {
+        const State& state = states[i];
+        Node& node = nodes[i];
+        node.children.clear();
+        node.children.reserve(state.numChildren);
+        for (int32_t child = state.firstChild; child < state.firstChild + state.numChildren; child++) {
+            node.children.push_back(make_pair(labels[child], targets[child]));
+        }
+        // failure links are recomputed by compile
+        node.fail = 0;
+        node.output = -1;
+        node.depth = state.depth;
+        node.dictionaries = state.dictionaries;
+    }
+    compiled = false;
+}
+
+int32_t TpTrie::nextState(int32_t state, UChar c) const {
+    while (true) {
+        if (state == 0 && c < ASCII_TABLE_SIZE) {
+            return rootAscii[c] >= 0 ? rootAscii[c] : 0;
+        }
+        const State& current = states[state];
+        const UChar* first = labels.data() + current.firstChild;
+        const UChar* last = first + current.numChildren;
+        const UChar* label = current.numChildren > 8 ? lower_bound(first, last, c) : find(first, last, c);
+        if (label != last && *label == c) {
+            return targets[label - labels.data()];
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = current.fail;
+    }
+}
+
+template <typename Function> void TpTrie::scan(const UnicodeString& s, Function onMatch) {
+    if (!compiled) {
+        compile();
+    }
+    const UChar* text = s.getBuffer();
+    int32_t length = s.length();
+    int32_t state = 0;
+    for (int32_t i = 0; i < length; i++) {
+        // an empty word matches at every position
+        if (states[0].dictionaries != 0) {
+            onMatch(i, i - 1, states[0].dictionaries);
+        }
+        state = nextState(state, text[i]);
+        for (int32_t match = states[state].dictionaries != 0 ? state : states[state].output; match > 0;
+                match = states[match].output) {
+            onMatch(i - states[match].depth + 1, i, states[match].dictionaries);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/**
+    Project: libtpc
+    File name: TpTrie.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_TPTRIE_H
+#define LIBTPC_TPTRIE_H
+
+#include <uima/api.hpp>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// pairs of (begin, end) positions of the matches of a word, with the end position included
+typedef vector< pair<int32_t, int32_t> > TpMatches;
+
+/*!
+ * @brief multi-pattern matcher shared by the annotators to find delimiters and tags in the sofa
+ *
+ * Words are added to one of up to MAX_DICTIONARIES dictionaries and compiled, at the first search after they have been
+ * added, into an Aho-Corasick automaton, so that all the occurrences of the words of all the dictionaries are found in
+ * a single linear pass over the text. The compiled automaton is stored in flat arrays, with states numbered in
+ * breadth-first order and the children of each state stored contiguously, and the transitions of the root for ASCII
+ * characters are looked up in a table, so that the states visited most often while scanning stay in cache
+ */
+class TpTrie {
+public:
+    static const int32_t MAX_DICTIONARIES = 32;
+
+    TpTrie();
+
+    /*!
+     * add a word to a dictionary
+     * @param s the word
+     * @param dictionary the index of the dictionary, between 0 and MAX_DICTIONARIES - 1
+     * @throw std::invalid_argument if the index of the dictionary is out of range
+     */
+    void addWord(const UnicodeString& s, int32_t dictionary = 0);
+
+    /*!
+     * find the occurrences of the words of all the dictionaries in a text
+     * @param s the text
+     * @return the matches, sorted by begin and end position. Matches of words found in more than one dictionary are
+     * reported once
+     */
+    TpMatches searchAllWords(const UnicodeString& s);
+
+    /*!
+     * find the occurrences of the words of each dictionary in a text
+     * @param s the text
+     * @param matches the matches of each dictionary, sorted by begin and end position. The vector is resized to the
+     * number of dictionaries
+     */
+    void searchAllWords(const UnicodeString& s, vector<TpMatches>& matches);
+
+private:
+    static const int32_t ASCII_TABLE_SIZE = 128;
+
+    struct Node {
+        // children sorted by character
+        vector< pair<UChar, int32_t> > children;
+        int32_t fail;
+        // nearest node on the failure path that ends a word
+        int32_t output;
+        int32_t depth;
+        // bit mask of the dictionaries of the word ending at the node
+        uint32_t dictionaries;
+    };
+
+    // compiled state. Children are stored in labels and targets, from firstChild to firstChild + numChildren
+    struct State {
+        int32_t firstChild;
+        int32_t numChildren;
+        int32_t fail;
+        int32_t output;
+        int32_t depth;
+        uint32_t dictionaries;
+    };
+
+    int32_t findChild(int32_t node, UChar c) const;
+
+    void compile();
+
+    // rebuild the builder nodes from the compiled states, so that more words can be added
+    void decompile();
+
+    int32_t nextState(int32_t state, UChar c) const;
+
+    template <typename Function> void scan(const UnicodeString& s, Function onMatch);
+
+    // builder trie, released once it is compiled into the states
+    vector<Node> nodes;
+    vector<State> states;
+    // characters of the children of the compiled states, sorted for each state
+    vector<UChar> labels;
+    vector<int32_t> targets;
+    // children of the root for ASCII characters, -1 if missing
+    int32_t rootAscii[ASCII_TABLE_SIZE];
+    int32_t numDictionaries;
+    bool compiled;
+};
+
+#endif //LIBTPC_TPTRIE_H
@@ -10,7 +10,7 @@
 
 #include <set>
 #include <uima/api.hpp>
-#include "../TpTokenizer/TpTrie.h"
+#include "../TpTrie/TpTrie.h"
 #include "pugixml.hpp"
 
 using namespace uima;
@@ -36,10 +36,12 @@ private:
     Type tokentype;
     Type tokendelimitertype;
     Feature tokentype_content;
+    Feature tokentype_aid;
     Feature tokendelimitertype_content;
     Type sentencetype;
     Type sentencedelimitertype;
     Feature sentencetype_content;
+    Feature sentencetype_aid;
     Feature sentencedelimitertype_content;
     Type tpfnvhashtype;
     Feature tpfnvhashtype_content;
@@ -48,14 +50,15 @@ private:
     Feature xmltagtype_content;
     Feature xmltagtype_term;
 
+    bool compactMode;
     CAS * tcas;
     std::set<UnicodeString> dlsetToken;
-    TpTrie * trieToken;
     std::set<UnicodeString> dlsetSentence;
     vector<string> disqSentence;
     int32_t maxfrontdisqcharlength;
     int32_t maxbackdisqcharlength;
-    TpTrie * trieSentence;
+    // token and sentence delimiters, found in a single pass over the sofa
+    TpTrie delimiterTrie;
     int32_t FindStartTag(const UnicodeString docstring, const UnicodeString name, int32_t pos);
     int32_t FindEndTag(const UnicodeString docstring, const UnicodeString name, int32_t pos);
 };
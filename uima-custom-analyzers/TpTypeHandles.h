@@ -0,0 +1,88 @@
+/**
+    Project: libtpc
+    File name: TpTypeHandles.h
+
+    @author agent
+    @version 1.0 10/19/26.
+*/
+
+#ifndef LIBTPC_TPTYPEHANDLES_H
+#define LIBTPC_TPTYPEHANDLES_H
+
+#include <string>
+#include <uima/api.hpp>
+
+/*!
+ * @struct TpTypeHandles
+ * @brief handles of the Textpresso types and features read by the cas consumers
+ *
+ * The handles are resolved by name once, when the type system is initialized, so that no lookup into the type system
+ * is done while processing documents. The handles of the types that are not defined in the type system are left
+ * invalid
+ */
+struct TpTypeHandles {
+    uima::Type filename;
+    uima::Feature filename_value;
+    uima::Type rawsource;
+    uima::Feature rawsource_value;
+    uima::Type tpfnvhash;
+    uima::Feature tpfnvhash_content;
+    uima::Type pdftag;
+    uima::Type xmltag;
+    uima::Feature xmltag_value;
+    uima::Feature xmltag_term;
+    uima::Type sentence;
+    uima::Feature sentence_content;
+    uima::Type lexicalannotation;
+    uima::Feature lexicalannotation_term;
+    uima::Feature lexicalannotation_category;
+
+    /*!
+     * resolve all the handles from a type system
+     * @param type_system the type system of the cas objects to process
+     */
+    void init(const uima::TypeSystem& type_system) {
+        filename = type_system.getType("org.apache.uima.textpresso.filename");
+        filename_value = get_feature(filename, "value");
+        rawsource = type_system.getType("org.apache.uima.textpresso.rawsource");
+        rawsource_value = get_feature(rawsource, "value");
+        tpfnvhash = type_system.getType("org.apache.uima.textpresso.tpfnvhash");
+        tpfnvhash_content = get_feature(tpfnvhash, "content");
+        pdftag = type_system.getType("org.apache.uima.textpresso.pdftag");
+        xmltag = type_system.getType("org.apache.uima.textpresso.xmltag");
+        xmltag_value = get_feature(xmltag, "value");
+        xmltag_term = get_feature(xmltag, "term");
+        sentence = type_system.getType("org.apache.uima.textpresso.sentence");
+        sentence_content = get_feature(sentence, "content");
+        lexicalannotation = type_system.getType("org.apache.uima.textpresso.lexicalannotation");
+        lexicalannotation_term = get_feature(lexicalannotation, "term");
+        lexicalannotation_category = get_feature(lexicalannotation, "category");
+    }
+
+    /*!
+     * get the value of a string feature of the first annotation of a type in a cas
+     * @param tcas the cas
+     * @param type the annotation type
+     * @param feature the string feature
+     * @return the value of the feature, or an empty string if the cas does not contain annotations of the type
+     */
+    static std::string get_first_string_value(uima::CAS& tcas, const uima::Type& type,
+                                              const uima::Feature& feature) {
+        if (!type.isValid() || !feature.isValid()) {
+            return "";
+        }
+        uima::ANIterator aait = tcas.getAnnotationIndex(type).iterator();
+        aait.moveToFirst();
+        if (!aait.isValid()) {
+            return "";
+        }
+        return aait.get().getStringValue(feature).asUTF8();
+    }
+
+private:
+    static uima::Feature get_feature(const uima::Type& type, const char* name) {
+        return type.isValid() ? type.getFeatureByBaseName(name) : uima::Feature();
+    }
+};
+
+#endif //LIBTPC_TPTYPEHANDLES_H
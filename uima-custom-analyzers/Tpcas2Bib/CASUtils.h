@@ -15,6 +15,7 @@
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include "../TpTypeHandles.h"
 
 using namespace std;
 using namespace uima;
@@ -23,10 +24,10 @@ using namespace Lucene;
 
 #endif	/* CASUTILS_H */
 
-extern wstring getCleanText(CAS& tcas); //get clean text
+extern wstring getCleanText(CAS& tcas, const TpTypeHandles& handles); //get clean text
 extern wstring getFulltext(CAS& tcas);// get full texto(not clean)
-extern string getCASType(CAS & tcas); // get CAS file type(PDF or NXML)
-extern string gettpfnvHash(CAS& tcas); // get hash value
-extern string getFilename(CAS& tcas); // get filename
+extern string getCASType(CAS & tcas, const TpTypeHandles& handles); // get CAS file type(PDF or NXML)
+extern string gettpfnvHash(CAS& tcas, const TpTypeHandles& handles); // get hash value
+extern string getFilename(CAS& tcas, const TpTypeHandles& handles); // get filename
 extern string getXMLstring(CAS & tcas); // get xml from tpcas
 //extern string getTempDir();// generate a temp dir under /run/shm to store all temp files for each run. using year+month+day+min
\ No newline at end of file
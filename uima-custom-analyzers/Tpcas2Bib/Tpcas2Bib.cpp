@@ -9,7 +9,6 @@
 #include "Tpcas2Bib.h"
 #include <lucene++/FileUtils.h>
 #include "CASUtils.h"
-#include "TpTrie.h"
 #include <iomanip>
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
@@ -412,8 +411,8 @@ wstring decreaseString(wstring str) {
     return decreased_string;
 }
 
-std::map<wstring, vector<wstring> > collectCategoryMapping(CAS& tcas) {
-    string filenamehash = gettpfnvHash(tcas);
+std::map<wstring, vector<wstring> > collectCategoryMapping(CAS& tcas, const TpTypeHandles& handles) {
+    string filenamehash = gettpfnvHash(tcas, handles);
     FSIndexRepository & indices = tcas.getIndexRepository();
     ANIndex allannindex = tcas.getAnnotationIndex();
     ANIterator aait = allannindex.iterator();
@@ -422,19 +421,14 @@ std::map<wstring, vector<wstring> > collectCategoryMapping(CAS& tcas) {
     map<wstring, vector<wstring> > cat_map;
     while (aait.isValid()) {
         count++;
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.lexicalannotation") {
-            Feature fterm = currentType.getFeatureByBaseName("term");
-            UnicodeStringRef uterm = aait.get().getStringValue(fterm);
+        if (aait.get().getType() == handles.lexicalannotation) {
+            UnicodeStringRef uterm = aait.get().getStringValue(handles.lexicalannotation_term);
             wstring ws_term;
             UnicodeString wd;
             uterm.extract(0, uterm.length(), wd);
             for (int i = 0; i < wd.length(); ++i)
                 ws_term += static_cast<wchar_t> (wd[i]);
-            Feature fcategory = currentType.getFeatureByBaseName("category");
-            UnicodeStringRef ucategory = aait.get().getStringValue(fcategory);
+            UnicodeStringRef ucategory = aait.get().getStringValue(handles.lexicalannotation_category);
             wstring ws_category;
             UnicodeString wd1;
             ucategory.extract(0, ucategory.length(), wd1);
@@ -466,8 +460,9 @@ std::map<wstring, vector<wstring> > collectCategoryMapping(CAS& tcas) {
     return cat_map;
 }
 
-void IndexSentences(CAS& tcas, map<wstring, vector<wstring> > cat_map, vector<String> bib_info, IndexWriterPtr sentencewriter) {
-    string filenamehash = gettpfnvHash(tcas);
+void IndexSentences(CAS& tcas, const TpTypeHandles& handles, map<wstring, vector<wstring> > cat_map,
+                    vector<String> bib_info, IndexWriterPtr sentencewriter) {
+    string filenamehash = gettpfnvHash(tcas, handles);
     String l_filenamehash = StringUtils::toString(filenamehash.c_str());
     String l_author = bib_info[0];
     String l_accession = bib_info[1];
@@ -477,19 +472,18 @@ void IndexSentences(CAS& tcas, map<wstring, vector<wstring> > cat_map, vector<St
     String l_citation = bib_info[5];
     String l_year = bib_info[6];
     String l_abstract = bib_info[7];
-    Type sent_type = tcas.getTypeSystem().getType("org.apache.uima.textpresso.sentence");
-    ANIndex sentenceindex = tcas.getAnnotationIndex(sent_type);
+    ANIndex sentenceindex = tcas.getAnnotationIndex(handles.sentence);
     ANIterator aait = sentenceindex.iterator();
     aait.moveToFirst();
     int count = 0;
     while (aait.isValid()) {
         count++;
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.sentence") {
-            Feature fcontent = currentType.getFeatureByBaseName("content");
-            UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
+        if (aait.get().getType() == handles.sentence) {
+            UnicodeStringRef ucontent = aait.get().getStringValue(handles.sentence_content);
+            // annotations written in compact mode do not store their content
+            if (ucontent.length() == 0) {
+                ucontent = aait.get().getCoveredText();
+            }
             // going wchar_t by wchar_t.
             wstring w_sentence;
             UnicodeString wd;
@@ -498,10 +492,8 @@ void IndexSentences(CAS& tcas, map<wstring, vector<wstring> > cat_map, vector<St
                 w_sentence += static_cast<wchar_t> (wd[i]);
             boost::wregex tagregex(L"\<_pdf.+?\/\>");
             w_sentence = boost::regex_replace(w_sentence, tagregex, "");
-            Feature begincontent = currentType.getFeatureByBaseName("begin");
-            int begin = aait.get().getIntValue(begincontent);
-            Feature endcontent = currentType.getFeatureByBaseName("end");
-            int end = aait.get().getIntValue(endcontent);
+            int begin = aait.get().getBeginPosition();
+            int end = aait.get().getEndPosition();
             wstring w_sentence_cat;
             wstring w_sentence_pos;
             vector<wstring> words;
@@ -673,13 +665,15 @@ TyErrorId Tpcas2Bib::typeSystemInit(TypeSystem const & crTypeSystem) {
             features_[*atit].push_back(*fit);
         }
     }
+    // handles of the types and features read while processing documents
+    typeHandles.init(crTypeSystem);
     return (TyErrorId) UIMA_ERR_NONE;
 }
 
 TyErrorId Tpcas2Bib::process(CAS & tcas, ResultSpecification const & crResultSpecification) {
     vector<String> bib_info;
     string regex_wb = "WBPaper";
-    string filename = getFilename(tcas);
+    string filename = getFilename(tcas, typeHandles);
     boost::regex regex_to_match(regex_wb.c_str(), boost::regex::icase);
     if (boost::regex_search(filename, regex_to_match)) {
         boost::regex suffix(".tpcas");
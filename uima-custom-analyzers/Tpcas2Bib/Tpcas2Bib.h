@@ -11,6 +11,7 @@
 #include <uima/api.hpp>
 #include <lucene++/targetver.h>
 #include <lucene++/LuceneHeaders.h>
+#include "../TpTypeHandles.h"
 
 using namespace uima;
 using namespace std;
@@ -32,6 +33,7 @@ private:
     vector<Type> types_;
    // map<Type, int> types;
     map< Type, vector<Feature> > features_;
+    TpTypeHandles typeHandles;
     CAS *tcas;
    
 //    string fulltextindexdirectory; // full clean text index
@@ -7,7 +7,6 @@
 
 #include "Tpcas2Bib4Nxml.h"
 #include "CASUtils.h"
-#include "TpTrie.h"
 #include <iomanip>
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
@@ -26,6 +25,8 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/regex.h>
 
+using namespace std;
+
 Tpcas2Bib4Nxml::Tpcas2Bib4Nxml() {
 }
 
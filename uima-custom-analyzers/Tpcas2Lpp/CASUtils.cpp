@@ -1,18 +1,8 @@
 #include "CASUtils.h"
 
 
-string getFilename(CAS& tcas) {
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
-    aait.moveToFirst();
-    while (aait.get().getType().getName().asUTF8().find("filename") == -1) {
-        aait.moveToNext();
-    }
-    Type currentType = aait.get().getType();
-    Feature fcontent = currentType.getFeatureByBaseName("value");
-    UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
-    return ucontent.asUTF8();
-
+string getFilename(CAS& tcas, const TpTypeHandles& handles) {
+    return TpTypeHandles::get_first_string_value(tcas, handles.filename, handles.filename_value);
 }
 
 wstring getFulltext(CAS& tcas) {
@@ -25,62 +15,30 @@ wstring getFulltext(CAS& tcas) {
     return ws;
 }
 
-string getCASType(CAS& tcas) {
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
-    aait.moveToFirst();
-    while (aait.isValid()) {
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.rawsource") {
-            Feature fvalue = currentType.getFeatureByBaseName("value");
-            UnicodeStringRef uvalue = aait.get().getStringValue(fvalue);
-            cout << "castype is  " << uvalue << endl;
-            return uvalue.asUTF8();
-        }
-        aait.moveToNext();
-    }
-
+string getCASType(CAS& tcas, const TpTypeHandles& handles) {
+    return TpTypeHandles::get_first_string_value(tcas, handles.rawsource, handles.rawsource_value);
 }
 
-string gettpfnvHash(CAS& tcas) {
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
-    aait.moveToFirst();
-    while (aait.isValid()) {
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.tpfnvhash") {
-            Feature fcontent = currentType.getFeatureByBaseName("content");
-            UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
-            return ucontent.asUTF8();
-        }
-        aait.moveToNext();
-    }
-
+string gettpfnvHash(CAS& tcas, const TpTypeHandles& handles) {
+    return TpTypeHandles::get_first_string_value(tcas, handles.tpfnvhash, handles.tpfnvhash_content);
 }
 
 
-wstring getCleanText(CAS & tcas) {
-    string castype = getCASType(tcas);
+wstring getCleanText(CAS & tcas, const TpTypeHandles& handles) {
+    string castype = getCASType(tcas, handles);
     wstring w_fulltext(L"");
     if (castype == "pdf") { //if it's from pdf , records all PDF tag positions and skip PDF tags in clean text
         vector < pair<int, int> > pdftags;
-        ANIndex allannindex = tcas.getAnnotationIndex();
-        ANIterator aait = allannindex.iterator();
-        aait.moveToFirst();
-        while (aait.isValid()) {
-            Type currentType = aait.get().getType();
-            UnicodeStringRef tnameref = currentType.getName();
-            string annType = tnameref.asUTF8();
-            if (annType == "org.apache.uima.textpresso.pdftag") {
+        if (handles.pdftag.isValid()) {
+            ANIndex pdftagindex = tcas.getAnnotationIndex(handles.pdftag);
+            ANIterator aait = pdftagindex.iterator();
+            aait.moveToFirst();
+            while (aait.isValid()) {
                 int begin = aait.get().getBeginPosition();
                 int end = aait.get().getEndPosition();
                 pdftags.push_back(make_pair(begin, end));
+                aait.moveToNext();
             }
-            aait.moveToNext();
         }
         w_fulltext = getFulltext(tcas); //get full clean text
         for (int i = 0; i < pdftags.size(); i++) {  // skip PDF tags in full text to get clean text
@@ -103,17 +61,10 @@ wstring getCleanText(CAS & tcas) {
         ANIterator aait = allannindex.iterator();
         aait.moveToFirst();
         while (aait.isValid()) {
-            Type currentType = aait.get().getType();
-            UnicodeStringRef tnameref = currentType.getName();
-            string annType = tnameref.asUTF8();
-            if (annType == "org.apache.uima.textpresso.xmltag") {
-                int begin = aait.get().getBeginPosition();
-                int end = aait.get().getEndPosition();
-                Feature fvalue = currentType.getFeatureByBaseName("value");
-                UnicodeStringRef uvalue = aait.get().getStringValue(fvalue);
+            if (aait.get().getType() == handles.xmltag) {
+                UnicodeStringRef uvalue = aait.get().getStringValue(handles.xmltag_value);
                 if (uvalue.asUTF8() == "pcdata") {  //concatenate all pcdata strings to form clean text
-                    Feature fterm = currentType.getFeatureByBaseName("term");
-                    UnicodeStringRef uterm = aait.get().getStringValue(fterm);
+                    UnicodeStringRef uterm = aait.get().getStringValue(handles.xmltag_term);
                     UnicodeString wd;
                     uterm.extract(0, uterm.length(), wd);
                     for (int i = 0; i < wd.length(); ++i)
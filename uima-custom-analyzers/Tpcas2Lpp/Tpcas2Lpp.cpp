@@ -344,6 +344,8 @@ TyErrorId Tpcas2Lpp::typeSystemInit(TypeSystem const & crTypeSystem) {
             features_[*atit].push_back(*fit);
         }
     }
+    // handles of the types and features read while processing documents
+    typeHandles.init(crTypeSystem);
     return (TyErrorId) UIMA_ERR_NONE;
 }
 
@@ -354,9 +356,9 @@ TyErrorId Tpcas2Lpp::process(CAS & tcas, ResultSpecification const & crResultSpe
     UnicodeStringRef usdocref = tcas.getDocumentText();
     string pid = tpfnv(usdocref);
     String Spid = StringUtils::toString(pid.c_str());
-    string filenamehash = gettpfnvHash(tcas);
+    string filenamehash = gettpfnvHash(tcas, typeHandles);
     //indexing fulltext
-    wstring w_cleanText = getCleanText(tcas);
+    wstring w_cleanText = getCleanText(tcas, typeHandles);
     String l_filenamehash = StringUtils::toString(filenamehash.c_str());
     DocumentPtr fulltextdoc = newLucene<Document > ();
     fulltextdoc->add(newLucene<Field > (L"identifier", l_filenamehash, Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
@@ -374,16 +376,15 @@ TyErrorId Tpcas2Lpp::process(CAS & tcas, ResultSpecification const & crResultSpe
     while (aait.isValid()) {
         count++;
         Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.sentence") {
-            vector<Feature> fList;
-            currentType.getAppropriateFeatures(fList);
+        if (currentType == typeHandles.sentence) {
             long begin = aait.get().getBeginPosition(); //.getStringValue(fid);
             long end = aait.get().getEndPosition();
             wstring sentenceid(filenamehash.begin(), filenamehash.end());
-            Feature fcontent = currentType.getFeatureByBaseName("content");
-            UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
+            UnicodeStringRef ucontent = aait.get().getStringValue(typeHandles.sentence_content);
+            // annotations written in compact mode do not store their content
+            if (ucontent.length() == 0) {
+                ucontent = aait.get().getCoveredText();
+            }
             wstring ws;
             UnicodeString wd;
             ucontent.extract(0, ucontent.length(), wd);
@@ -399,16 +400,14 @@ TyErrorId Tpcas2Lpp::process(CAS & tcas, ResultSpecification const & crResultSpe
         }
 
 
-        if (annType == "org.apache.uima.textpresso.lexicalannotation") {
-            Feature fterm = currentType.getFeatureByBaseName("term");
-            UnicodeStringRef uterm = aait.get().getStringValue(fterm);
+        if (currentType == typeHandles.lexicalannotation) {
+            UnicodeStringRef uterm = aait.get().getStringValue(typeHandles.lexicalannotation_term);
             wstring ws_term;
             UnicodeString wd;
             uterm.extract(0, uterm.length(), wd);
             for (int i = 0; i < wd.length(); ++i)
                 ws_term += static_cast<wchar_t> (wd[i]);
-            Feature fcategory = currentType.getFeatureByBaseName("category");
-            UnicodeStringRef ucategory = aait.get().getStringValue(fcategory);
+            UnicodeStringRef ucategory = aait.get().getStringValue(typeHandles.lexicalannotation_category);
             wstring ws_category;
             UnicodeString wd1;
             ucategory.extract(0, ucategory.length(), wd1);
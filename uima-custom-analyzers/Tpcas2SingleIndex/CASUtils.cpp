@@ -1,4 +1,7 @@
 #include <codecvt>
+#include <algorithm>
+#include <cstdint>
+#include <locale>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string_regex.hpp>
 #include <boost/algorithm/string.hpp>
@@ -7,17 +10,8 @@
 #include "Tpcas2SingleIndex.h"
 
 
-string getFilename(CAS& tcas) {
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
-    aait.moveToFirst();
-    while (aait.get().getType().getName().asUTF8().find("filename") == -1) {
-        aait.moveToNext();
-    }
-    Type currentType = aait.get().getType();
-    Feature fcontent = currentType.getFeatureByBaseName("value");
-    UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
-    return ucontent.asUTF8();
+string getFilename(CAS& tcas, const TpTypeHandles& handles) {
+    return TpTypeHandles::get_first_string_value(tcas, handles.filename, handles.filename_value);
 }
 
 wstring getFulltext(CAS& tcas) {
@@ -31,88 +25,102 @@ wstring getFulltext(CAS& tcas) {
     return ws;
 }
 
-string getCASType(CAS& tcas) {
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
-    aait.moveToFirst();
-    while (aait.isValid()) {
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.rawsource") {
-            Feature fvalue = currentType.getFeatureByBaseName("value");
-            UnicodeStringRef uvalue = aait.get().getStringValue(fvalue);
-            return uvalue.asUTF8();
-        }
-        aait.moveToNext();
-    }
+string getCASType(CAS& tcas, const TpTypeHandles& handles) {
+    return TpTypeHandles::get_first_string_value(tcas, handles.rawsource, handles.rawsource_value);
 }
 
-string gettpfnvHash(CAS& tcas) {
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
-    aait.moveToFirst();
-    while (aait.isValid()) {
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.tpfnvhash") {
-            Feature fcontent = currentType.getFeatureByBaseName("content");
-            UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
-            return ucontent.asUTF8();
+string gettpfnvHash(CAS& tcas, const TpTypeHandles& handles) {
+    return TpTypeHandles::get_first_string_value(tcas, handles.tpfnvhash, handles.tpfnvhash_content);
+}
+
+namespace {
+
+    // same character class matched by \s in a boost::wregex with the default traits
+    bool isCleanTextSpace(wchar_t c) {
+        // the facet is owned by the locale, which must outlive the reference
+        static const std::locale locale;
+        static const std::ctype<wchar_t>& wctype = std::use_facet<std::ctype<wchar_t> >(locale);
+        return wctype.is(std::ctype_base::space, c);
+    }
+
+    // copy text into clean_text in a single pass, skipping the given spans (sorted, non overlapping, end exclusive)
+    // and replacing each run of whitespace with a single space
+    void copyCleanText(const wstring& text, const vector<pair<int32_t, int32_t> >& skipped_spans,
+                       wstring& clean_text) {
+        clean_text.clear();
+        clean_text.reserve(text.length());
+        bool in_spaces = false;
+        size_t pos = 0;
+        auto span = skipped_spans.begin();
+        while (pos < text.length()) {
+            size_t run_end = text.length();
+            if (span != skipped_spans.end()) {
+                run_end = min(run_end, static_cast<size_t>(span->first));
+            }
+            for (; pos < run_end; ++pos) {
+                bool is_space = isCleanTextSpace(text[pos]);
+                if (is_space && in_spaces) {
+                    continue;
+                }
+                clean_text += is_space ? L' ' : text[pos];
+                in_spaces = is_space;
+            }
+            if (span != skipped_spans.end()) {
+                pos = max(pos, static_cast<size_t>(span->second));
+                ++span;
+            }
         }
-        aait.moveToNext();
     }
 }
 
-wstring getCleanText(CAS& tcas) {
-    string castype = getCASType(tcas);
+wstring getCleanText(CAS& tcas, const TpTypeHandles& handles) {
+    string castype = getCASType(tcas, handles);
     wstring w_fulltext(L"");
+    wstring w_cleantext(L"");
     if (castype == "pdf") { //if it's from pdf , records all PDF tag positions and skip PDF tags in clean text
-        vector < pair<int, int> > pdftags;
-        ANIndex allannindex = tcas.getAnnotationIndex();
-        ANIterator aait = allannindex.iterator();
-        aait.moveToFirst();
-        while (aait.isValid()) {
-            Type currentType = aait.get().getType();
-            UnicodeStringRef tnameref = currentType.getName();
-            string annType = tnameref.asUTF8();
-            if (annType == "org.apache.uima.textpresso.pdftag") {
-                int begin = aait.get().getBeginPosition();
-                int end = aait.get().getEndPosition();
-                pdftags.push_back(make_pair(begin, end));
+        vector<pair<int32_t, int32_t> > pdftags;
+        w_fulltext = getFulltext(tcas);
+        if (handles.pdftag.isValid()) {
+            ANIndex pdftagindex = tcas.getAnnotationIndex(handles.pdftag);
+            ANIterator aait = pdftagindex.iterator();
+            aait.moveToFirst();
+            while (aait.isValid()) {
+                int32_t begin = aait.get().getBeginPosition();
+                // the end position of pdf tags points to the closing '>' of the tag
+                int32_t end = aait.get().getEndPosition() + 1;
+                begin = max(begin, 0);
+                end = min(end, static_cast<int32_t>(w_fulltext.length()));
+                if (begin < end) {
+                    if (w_fulltext[begin] != '<') {
+                        wcout << "nomatch " << begin << "is " << w_fulltext[begin] << endl;  //error when matching a PDF tag in full text
+                    }
+                    pdftags.push_back(make_pair(begin, end));
+                }
+                aait.moveToNext();
             }
-            aait.moveToNext();
         }
-        w_fulltext = getFulltext(tcas); //get full clean text
-        for (int i = 0; i < pdftags.size(); i++) {  // skip PDF tags in full text to get clean text
-            int begin = pdftags[i].first;
-            int end = pdftags[i].second;
-            if (w_fulltext[begin] != '<') {
-                wcout << "nomatch " << begin << "is " << w_fulltext[begin] << endl;  //error when matching a PDF tag in full text
-            }
-            int sub_length = end - begin + 1;
-            w_fulltext.replace(begin, sub_length, L"");  //replace a PDF tag with empty string
-            for (int j = i + 1; j < pdftags.size(); j++) { // shift all following PDF tags positions by the length of previously replaced PDF tag
-                pdftags[j].first -= sub_length;
-                pdftags[j].second -= sub_length;
+        // sort the tags once and merge the overlapping ones, so that the text can be copied in a single pass
+        std::sort(pdftags.begin(), pdftags.end());
+        size_t num_merged = 0;
+        for (const auto& tag : pdftags) {
+            if (num_merged > 0 && tag.first <= pdftags[num_merged - 1].second) {
+                pdftags[num_merged - 1].second = max(pdftags[num_merged - 1].second, tag.second);
+            } else {
+                pdftags[num_merged++] = tag;
             }
         }
+        pdftags.resize(num_merged);
+        copyCleanText(w_fulltext, pdftags, w_cleantext);
     }
     else if (castype == "nxml") { // if it's from nxml
         ANIndex allannindex = tcas.getAnnotationIndex();
         ANIterator aait = allannindex.iterator();
         aait.moveToFirst();
         while (aait.isValid()) {
-            Type currentType = aait.get().getType();
-            UnicodeStringRef tnameref = currentType.getName();
-            string annType = tnameref.asUTF8();
-            if (annType == "org.apache.uima.textpresso.xmltag") {
-                Feature fvalue = currentType.getFeatureByBaseName("value");
-                UnicodeStringRef uvalue = aait.get().getStringValue(fvalue);
+            if (aait.get().getType() == handles.xmltag) {
+                UnicodeStringRef uvalue = aait.get().getStringValue(handles.xmltag_value);
                 if (uvalue.asUTF8() == "pcdata") {  //concatenate all pcdata strings to form clean text
-                    Feature fterm = currentType.getFeatureByBaseName("term");
-                    UnicodeStringRef uterm = aait.get().getStringValue(fterm);
+                    UnicodeStringRef uterm = aait.get().getStringValue(handles.xmltag_term);
                     UnicodeString wd;
                     uterm.extract(0, uterm.length(), wd);
                     for (int i = 0; i < wd.length(); ++i)
@@ -122,18 +130,24 @@ wstring getCleanText(CAS& tcas) {
             w_fulltext += L" ";  //adding a space between words
             aait.moveToNext();
         }
+        copyCleanText(w_fulltext, vector<pair<int32_t, int32_t> >(), w_cleantext);
     }
-    try {
-        //boost::wregex tagregex(L"\<[! ].*\>");
-        //w_fulltext = boost::regex_replace(w_fulltext, tagregex, "");
-        //boost::wregex tagregex2(L"\<\/.+?\>");
-        //w_fulltext = boost::regex_replace(w_fulltext, tagregex2, "");
-        boost::wregex spaces_regex(L"\\s+");
-        w_fulltext = boost::regex_replace(w_fulltext, spaces_regex, " ");
-    } catch (std::exception& e) {
-        w_fulltext = L"";
+    return w_cleantext;
+}
+
+void addYearFields(const DocumentPtr& doc, const String& year) {
+    doc->add(newLucene<Field>(L"year", year, Field::STORE_YES, Field::INDEX_NO));
+    // the first sequence of four digits is the numeric year (e.g., 2017 for "2017 Mar 3")
+    int32_t num_digits = 0;
+    for (size_t i = 0; i < year.length(); ++i) {
+        num_digits = year[i] >= L'0' && year[i] <= L'9' ? num_digits + 1 : 0;
+        if (num_digits == 4 && (i + 1 == year.length() || year[i + 1] < L'0' || year[i + 1] > L'9')) {
+            NumericFieldPtr year_field = newLucene<NumericField>(L"year", Field::STORE_NO, true);
+            year_field->setIntValue(StringUtils::toInt(year.substr(i - 3, 4)));
+            doc->add(year_field);
+            return;
+        }
     }
-    return w_fulltext;
 }
 
 string getXMLstring(CAS & tcas)
@@ -20,11 +20,13 @@
 #include <boost/algorithm/string.hpp>
 #include "Tpcas2SingleIndex.h"
 
-std::wstring getCleanText(CAS& tcas);
+std::wstring getCleanText(CAS& tcas, const TpTypeHandles& handles);
 std::wstring getFulltext(CAS& tcas);// get full texto(not clean)
-std::string getCASType(uima::CAS & tcas); // get CAS file type(PDF or NXML)
-std::string gettpfnvHash(uima::CAS& tcas); // get hash value
-std::string getFilename(uima::CAS& tcas);
+std::string getCASType(uima::CAS & tcas, const TpTypeHandles& handles); // get CAS file type(PDF or NXML)
+std::string gettpfnvHash(uima::CAS& tcas, const TpTypeHandles& handles); // get hash value
+std::string getFilename(uima::CAS& tcas, const TpTypeHandles& handles);
 std::string getXMLstring(uima::CAS & tcas); // get xml from tpcas
+// add the year of a document as a stored string and, if it contains a four digit year, as an indexed numeric field
+void addYearFields(const Lucene::DocumentPtr& doc, const Lucene::String& year);
 
 #endif	/* CASUTILS_H */
\ No newline at end of file
@@ -6,9 +6,10 @@
  * modified Nov, 2013, liyuling
  */
 #include "Tpcas2SingleIndex.h"
+#include "../../CategoryPayload.h"
+#include "../../SentenceBlock.h"
 #include <lucene++/FileUtils.h>
 #include "CASUtils.h"
-#include "TpTrie.h"
 #include <lucene++/LuceneHeaders.h>
 #include <lucene++/CompressionTools.h>
 #include <iomanip>
@@ -30,8 +31,10 @@
 #include <codecvt>
 #include <chrono>
 #include <regex>
+#include <unordered_map>
 #include <boost/archive/text_iarchive.hpp>
 #include "../../lucene-custom/CaseSensitiveAnalyzer.h"
+#include "../../lucene-custom/CategoryAnalyzer.h"
 #include "../../CASManager.h"
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/set.hpp>
@@ -42,9 +45,16 @@ using namespace std;
 using namespace boost;
 using namespace std::chrono;
 using namespace tpc::cas;
+using tpc::index::CategoryDictionary;
 
 Tpcas2SingleIndex::Tpcas2SingleIndex() {
     root_dir = "/usr/local/textpresso/tpcas";
+    ramBufferSizeMB = IndexWriter::DEFAULT_RAM_BUFFER_SIZE_MB;
+    mergeFactor = LogMergePolicy::DEFAULT_MERGE_FACTOR;
+    maxMergeMB = LogByteSizeMergePolicy::DEFAULT_MAX_MERGE_MB;
+    useCompoundFile = true;
+    storeTermVectors = false;
+    storeSentenceBlocks = false;
 }
 
 Tpcas2SingleIndex::Tpcas2SingleIndex(const Tpcas2SingleIndex & orig) {
@@ -426,163 +436,264 @@ vector<String> GetBibFromWB(string paper) {
     return bib;
 }
 
-std::map<wstring, vector<wstring> > collectCategoryMapping(CAS& tcas) {
-    string filenamehash = gettpfnvHash(tcas);
-    FSIndexRepository & indices = tcas.getIndexRepository();
-    ANIndex allannindex = tcas.getAnnotationIndex();
-    ANIterator aait = allannindex.iterator();
+// the ids of the categories of each lexical term, in order of first occurrence in the document. Categories that are
+// not in the dictionary of the index have negative ids, -1 - id in the extra categories
+typedef std::unordered_map<wstring, vector<int32_t> > CategoryMapping;
+
+inline const wstring& getCategoryName(int32_t category_id, const CategoryDictionary& categoryDictionary,
+                                      const CategoryDictionary& extraCategories) {
+    return category_id >= 0 ? categoryDictionary.get_name(category_id) : extraCategories.get_name(-1 - category_id);
+}
+
+CategoryMapping collectCategoryMapping(CAS& tcas, const TpTypeHandles& handles,
+                                       const CategoryDictionary& categoryDictionary,
+                                       CategoryDictionary& extraCategories) {
+    CategoryMapping cat_map;
+    const Type& lexanntype = handles.lexicalannotation;
+    if (!lexanntype.isValid()) {
+        return cat_map;
+    }
+    const Feature& fterm = handles.lexicalannotation_term;
+    const Feature& fcategory = handles.lexicalannotation_category;
+    wstring ws_term;
+    wstring ws_category;
+    ANIndex lexannindex = tcas.getAnnotationIndex(lexanntype);
+    ANIterator aait = lexannindex.iterator();
     aait.moveToFirst();
-    int count = 0;
-    map<wstring, vector<wstring> > cat_map;
     while (aait.isValid()) {
-        count++;
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.lexicalannotation") {
-            Feature fterm = currentType.getFeatureByBaseName("term");
-            UnicodeStringRef uterm = aait.get().getStringValue(fterm);
-            wstring ws_term;
-            UnicodeString wd;
-            uterm.extract(0, uterm.length(), wd);
-            for (int i = 0; i < wd.length(); ++i)
-                ws_term += static_cast<wchar_t> (wd[i]);
-            Feature fcategory = currentType.getFeatureByBaseName("category");
-            UnicodeStringRef ucategory = aait.get().getStringValue(fcategory);
-            wstring ws_category;
-            UnicodeString wd1;
-            ucategory.extract(0, ucategory.length(), wd1);
-            for (int i = 0; i < wd1.length(); ++i)
-                ws_category += static_cast<wchar_t> (wd1[i]);
-            long begin = aait.get().getBeginPosition(); //.getStringValue(fid);
-            long end = aait.get().getEndPosition();
-            int term_size = cat_map[ws_term].size();
-            int j = 0;
-            if (term_size > 0) {
-                while (j < term_size) {
-                    if (cat_map[ws_term].at(j) == ws_category) {
-                        break;
-                    }
-                    j++;
-                }
-                if (j == term_size) {
-                    cat_map[ws_term].push_back(ws_category);
-                }
-            } else {
-                cat_map[ws_term].push_back(ws_category);
+        AnnotationFS lexann = aait.get();
+        if (lexann.getType() == lexanntype) {
+            UnicodeStringRef uterm = lexann.getStringValue(fterm);
+            ws_term.resize(uterm.length());
+            for (int32_t i = 0; i < uterm.length(); ++i) {
+                ws_term[i] = static_cast<wchar_t>(uterm[i]);
+            }
+            UnicodeStringRef ucategory = lexann.getStringValue(fcategory);
+            ws_category.resize(ucategory.length());
+            for (int32_t i = 0; i < ucategory.length(); ++i) {
+                ws_category[i] = static_cast<wchar_t>(ucategory[i]);
+            }
+            int32_t category_id = categoryDictionary.get_id(ws_category);
+            if (category_id < 0) {
+                category_id = -1 - extraCategories.get_or_add_id(ws_category);
+            }
+            vector<int32_t>& term_categories = cat_map[ws_term];
+            if (find(term_categories.begin(), term_categories.end(), category_id) == term_categories.end()) {
+                term_categories.push_back(category_id);
             }
-            wstring ws_lexicalannotaitonid(filenamehash.begin(), filenamehash.end());
-            ws_lexicalannotaitonid = ws_lexicalannotaitonid + L"|" + ws_category + L"|" + ws_term;
         }
         aait.moveToNext();
     }
     return cat_map;
 }
 
-void IndexSentences(CAS& tcas, map<wstring, vector<wstring> > cat_map, vector<String> bib_info, const string& corpora,
-                    const string& doc_id, const IndexWriterPtr& sentencewriter) {
-    std::hash<std::string> string_hash;
-    String l_author = fieldStartMark + bib_info[0] + fieldEndMark;
-    String l_accession = bib_info[1];
-    String l_type = bib_info[2];
-    String l_title = fieldStartMark + bib_info[3] + fieldEndMark;
-    String l_journal = fieldStartMark + bib_info[4] + fieldEndMark;
-    String l_citation = bib_info[5];
-    String l_year = bib_info[6];
-    String l_abstract = bib_info[7];
-    Type sent_type = tcas.getTypeSystem().getType("org.apache.uima.textpresso.sentence");
+// the category string of each term, with the category names joined by "|", computed once per document
+typedef std::unordered_map<wstring, wstring> CategoryStrings;
+
+CategoryStrings getCategoryStrings(const CategoryMapping& cat_map, const CategoryDictionary& categoryDictionary,
+                                   const CategoryDictionary& extraCategories) {
+    CategoryStrings cat_strings;
+    cat_strings.reserve(cat_map.size());
+    for (const auto& term_categories : cat_map) {
+        wstring cat_string;
+        for (int32_t category_id : term_categories.second) {
+            if (!cat_string.empty()) {
+                cat_string += L'|';
+            }
+            cat_string += getCategoryName(category_id, categoryDictionary, extraCategories);
+        }
+        cat_strings.emplace(term_categories.first, std::move(cat_string));
+    }
+    return cat_strings;
+}
+
+// the characters that separate the words of a text when matching category terms
+inline bool isWordSeparator(wchar_t c) {
+    switch (c) {
+        case L' ': case L'\n': case L'\t': case L'\'': case L'\\': case L'/': case L'(': case L')': case L'[':
+        case L']': case L'{': case L'}': case L':': case L'.': case L';': case L',': case L'!': case L'?':
+            return true;
+        default:
+            return false;
+    }
+}
+
+// remove pdf tags (<_pdf.../>) in a single linear scan
+void RemovePdfTags(const wstring& text, wstring& result) {
+    result.clear();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t tag_begin = text.find(L"<_pdf", pos);
+        size_t tag_end = tag_begin == wstring::npos ? wstring::npos : text.find(L"/>", tag_begin + 6);
+        if (tag_end == wstring::npos) {
+            break;
+        }
+        result.append(text, pos, tag_begin - pos);
+        pos = tag_end + 2;
+    }
+    result.append(text, pos, wstring::npos);
+}
+
+// remove tags (<...>) in a single linear scan
+void RemoveTags(const wstring& text, wstring& result) {
+    result.clear();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t tag_begin = text.find(L'<', pos);
+        size_t tag_end = tag_begin == wstring::npos ? wstring::npos : text.find(L'>', tag_begin + 2);
+        if (tag_end == wstring::npos) {
+            break;
+        }
+        result.append(text, pos, tag_begin - pos);
+        pos = tag_end + 1;
+    }
+    result.append(text, pos, wstring::npos);
+}
+
+// the category string of a text, with the categories of each word separated by tabs and NA for words that are
+// not category terms
+void GetCatString(const wstring& text, const CategoryStrings& cat_strings, wstring& word, wstring& result) {
+    result.clear();
+    size_t word_begin = 0;
+    for (size_t i = 0; i <= text.size(); ++i) {
+        if (i == text.size() || isWordSeparator(text[i])) {
+            word.assign(text, word_begin, i - word_begin);
+            auto it = cat_strings.find(word);
+            if (it != cat_strings.end()) {
+                result += it->second;
+            } else {
+                result += L"NA";
+            }
+            if (i < text.size()) {
+                result += L'\t';
+            }
+            word_begin = i + 1;
+        }
+    }
+}
+
+void IndexSentences(CAS& tcas, const TpTypeHandles& handles, const CategoryMapping& cat_map,
+                    const CategoryStrings& cat_strings, const CategoryDictionary& extraCategories,
+                    const vector<String>& bib_info,
+                    const string& corpora, const string& doc_id, const IndexWriterPtr& sentencewriter,
+                    const IndexWriterPtr& sentencewriter_casesens, Field::TermVector term_vector,
+                    tpc::index::SentenceBlock* sentence_block) {
+    const Type& sent_type = handles.sentence;
+    const Feature& fcontent = handles.sentence_content;
+    // the same document and fields are reused for all the sentences of the article and for both indices, only the
+    // values of the fields that change from sentence to sentence are updated
+    FieldPtr sentence_id_field = newLucene<Field>(L"sentence_id", L"", Field::STORE_YES,
+                                                  Field::INDEX_NOT_ANALYZED_NO_NORMS);
+    FieldPtr sentence_field = newLucene<Field>(L"sentence", L"", Field::STORE_NO, Field::INDEX_ANALYZED,
+                                               term_vector);
+    FieldPtr sentence_compressed_field = newLucene<Field>(L"sentence_compressed",
+                                                          CompressionTools::compressString(L""), Field::STORE_YES);
+    FieldPtr sentence_cat_field = newLucene<Field>(L"sentence_cat", L"", Field::STORE_NO, Field::INDEX_ANALYZED);
+    // the categories of the words are stored as a binary payload, see tpc::index::CategoryPayload
+    FieldPtr sentence_cat_binary_field = newLucene<Field>(L"sentence_cat_binary", ByteArray::newInstance(0),
+                                                          Field::STORE_YES);
+    // offsets are indexed as trie encoded numbers to support native range queries
+    NumericFieldPtr begin_field = newLucene<NumericField>(L"begin", Field::STORE_YES, true);
+    NumericFieldPtr end_field = newLucene<NumericField>(L"end", Field::STORE_YES, true);
+    DocumentPtr sentencedoc = newLucene<Document>();
+    sentencedoc->add(sentence_id_field);
+    sentencedoc->add(newLucene<Field>(L"doc_id", StringUtils::toString(doc_id.c_str()), Field::STORE_YES,
+                                      Field::INDEX_NOT_ANALYZED_NO_NORMS));
+    sentencedoc->add(sentence_field);
+    sentencedoc->add(sentence_cat_field);
+    // in sentence block mode the text and the categories of the sentences are stored in the fulltext document
+    if (sentence_block == NULL) {
+        sentencedoc->add(sentence_compressed_field);
+        sentencedoc->add(sentence_cat_binary_field);
+    }
+    sentencedoc->add(begin_field);
+    sentencedoc->add(end_field);
+    sentencedoc->add(newLucene<Field>(L"author", fieldStartMark + bib_info[0] + fieldEndMark, Field::STORE_NO,
+                                      Field::INDEX_ANALYZED));
+    sentencedoc->add(newLucene<Field>(L"accession", bib_info[1], Field::STORE_NO, Field::INDEX_ANALYZED));
+    sentencedoc->add(newLucene<Field>(L"type", bib_info[2], Field::STORE_NO, Field::INDEX_ANALYZED));
+    sentencedoc->add(newLucene<Field>(L"title", fieldStartMark + bib_info[3] + fieldEndMark, Field::STORE_NO,
+                                      Field::INDEX_ANALYZED));
+    sentencedoc->add(newLucene<Field>(L"journal", fieldStartMark + bib_info[4] + fieldEndMark, Field::STORE_NO,
+                                      Field::INDEX_ANALYZED));
+    sentencedoc->add(newLucene<Field>(L"citation", bib_info[5], Field::STORE_NO, Field::INDEX_ANALYZED));
+    addYearFields(sentencedoc, bib_info[6]);
+    sentencedoc->add(newLucene<Field>(L"corpus", String(corpora.begin(), corpora.end()), Field::STORE_NO,
+                                      Field::INDEX_ANALYZED));
+    // buffers reused across sentences
+    wstring w_content;
+    wstring w_untagged;
+    wstring w_sentence;
+    wstring w_sentence_cat;
+    wstring word;
+    tpc::index::CategoryPayload cat_payload;
     ANIndex sentenceindex = tcas.getAnnotationIndex(sent_type);
     ANIterator aait = sentenceindex.iterator();
     aait.moveToFirst();
     int count = 0;
-    int sentence_id = 0;
     while (aait.isValid()) {
         count++;
-        Type currentType = aait.get().getType();
-        UnicodeStringRef tnameref = currentType.getName();
-        string annType = tnameref.asUTF8();
-        if (annType == "org.apache.uima.textpresso.sentence") {
-            ++sentence_id;
-            Feature fcontent = currentType.getFeatureByBaseName("content");
-            UnicodeStringRef ucontent = aait.get().getStringValue(fcontent);
-            // Need to preserve UnicodeString as much as possible by maybe
+        AnnotationFS sentence = aait.get();
+        if (sentence.getType() == sent_type) {
+            UnicodeStringRef ucontent = sentence.getStringValue(fcontent);
+            // annotations written in compact mode do not store their content
+            if (ucontent.length() == 0) {
+                ucontent = sentence.getCoveredText();
+            }
+            // Need to preserve UnicodeString as much as possible by
             // going wchar_t by wchar_t.
-            wstring w_sentence;
-            UnicodeString wd;
-            ucontent.extract(0, ucontent.length(), wd);
-            for (int i = 0; i < wd.length(); ++i)
-                w_sentence += static_cast<wchar_t> (wd[i]);
-            boost::wregex tagregex(L"\<_pdf.+?\/\>");
-            w_sentence = boost::regex_replace(w_sentence, tagregex, "");
-            Feature begincontent = currentType.getFeatureByBaseName("begin");
-            int begin = aait.get().getIntValue(begincontent);
-            Feature endcontent = currentType.getFeatureByBaseName("end");
-            int end = aait.get().getIntValue(endcontent);
-            wstring w_sentence_cat;
-            wstring w_sentence_pos;
-            w_sentence = Tpcas2SingleIndex::RemoveTags(w_sentence);
-            vector<wstring> words;
-            boost::split(words, w_sentence, boost::is_any_of(" \n\t'\\/()[]{}:.;,!?"));
-            int position = 0;
-            for (int j = 0; j < words.size(); j++) {
-                int b = position;
-                int e = position + words[j].length();
-                position = e + 1;
-                map<wstring, vector<wstring> >::iterator it = cat_map.find(words[j]);
-                if (it != cat_map.end()) // found category term CAT_TERM
-                {
-                    w_sentence_cat += boost::algorithm::join(it->second, "|");
-                    w_sentence_cat += L"\t";
-                    w_sentence_pos += boost::lexical_cast<wstring>(b);
-                    w_sentence_pos += L",";
-                    w_sentence_pos += boost::lexical_cast<wstring>(e);
-                    w_sentence_pos += L"\t";
-
-                } else //NOT_CAT term
-                {
-                    w_sentence_cat += L"NA\t"; // to save space
-                    w_sentence_pos += L"0,0\t"; //to save space
+            w_content.resize(ucontent.length());
+            for (int32_t i = 0; i < ucontent.length(); ++i) {
+                w_content[i] = static_cast<wchar_t>(ucontent[i]);
+            }
+            RemovePdfTags(w_content, w_untagged);
+            RemoveTags(w_untagged, w_sentence);
+            // only the categories of the words that are category terms are indexed, the words without categories
+            // are replaced by gap tokens that keep their positions but are not indexed
+            cat_payload.clear();
+            w_sentence_cat.clear();
+            uint32_t word_index = 0;
+            size_t word_begin = 0;
+            for (size_t i = 0; i <= w_sentence.size(); ++i) {
+                if (i == w_sentence.size() || isWordSeparator(w_sentence[i])) {
+                    word.assign(w_sentence, word_begin, i - word_begin);
+                    if (word_index > 0) {
+                        w_sentence_cat += L'\t';
+                    }
+                    auto it = cat_map.find(word);
+                    if (it != cat_map.end()) {
+                        cat_payload.add_word_categories(word_index, it->second, extraCategories);
+                        w_sentence_cat += cat_strings.at(word);
+                    } else {
+                        w_sentence_cat += tpc::index::CATEGORY_GAP_TOKEN;
+                    }
+                    ++word_index;
+                    word_begin = i + 1;
                 }
             }
-            milliseconds ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
-            string sentence_id_str = to_string(count);
-
-            w_sentence_cat = w_sentence_cat.substr(0, w_sentence_cat.length() -
-                                                      1); ///remove last \t to avoid empty string after split
-            w_sentence_pos = w_sentence_pos.substr(0, w_sentence_pos.length() - 1);
-            //testing w_cat_string and w_positions matches and retrieve words from w_cleanText
-            DocumentPtr sentencedoc = newLucene<Document>();
-            sentencedoc->add(newLucene<Field>(L"sentence_id", StringUtils::toString(sentence_id_str.c_str()),
-                                              Field::STORE_YES, Field::INDEX_NOT_ANALYZED_NO_NORMS));
-            sentencedoc->add(newLucene<Field>(L"doc_id", StringUtils::toString(doc_id.c_str()), Field::STORE_YES,
-                                              Field::INDEX_NOT_ANALYZED_NO_NORMS));
-            sentencedoc->add(newLucene<Field>(L"sentence",
-                                              StringUtils::toString<wstring>(w_sentence),
-                                              Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"sentence_compressed",
-                                              CompressionTools::compressString(
-                                                      StringUtils::toString<wstring>(w_sentence)),
-                                              Field::STORE_YES));
-            sentencedoc->add(newLucene<Field>(L"sentence_cat", StringUtils::toString<wstring>(w_sentence_cat),
-                                              Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"sentence_cat_compressed",
-                                              CompressionTools::compressString(
-                                                      StringUtils::toString<wstring>(w_sentence_cat)),
-                                              Field::STORE_YES));
-            sentencedoc->add(newLucene<Field>(L"begin", StringUtils::toString<int>(begin), Field::STORE_YES,
-                                              Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"end", StringUtils::toString<int>(end), Field::STORE_YES,
-                                              Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"author", l_author, Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"accession", l_accession, Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"type", l_type, Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"title", l_title, Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"journal", l_journal, Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"citation", l_citation, Field::STORE_NO, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"year", l_year, Field::STORE_YES, Field::INDEX_ANALYZED));
-            sentencedoc->add(newLucene<Field>(L"corpus", String(corpora.begin(), corpora.end()), Field::STORE_NO,
-                                              Field::INDEX_ANALYZED));
+            cat_payload.set_num_words(word_index);
+            string encoded_cat_payload = cat_payload.encode();
+            if (sentence_block == NULL) {
+                ByteArray cat_payload_bytes = ByteArray::newInstance(encoded_cat_payload.size());
+                std::copy(encoded_cat_payload.begin(), encoded_cat_payload.end(), cat_payload_bytes.get());
+                sentence_compressed_field->setValue(CompressionTools::compressString(w_sentence));
+                sentence_cat_binary_field->setValue(cat_payload_bytes);
+            } else {
+                tpc::index::StoredSentence stored_sentence;
+                stored_sentence.sentence_id = count;
+                stored_sentence.begin = sentence.getBeginPosition();
+                stored_sentence.end = sentence.getEndPosition();
+                stored_sentence.text = StringUtils::toUTF8(w_sentence);
+                stored_sentence.categories_payload = encoded_cat_payload;
+                sentence_block->add_sentence(stored_sentence);
+            }
+            sentence_id_field->setValue(StringUtils::toString<int>(count));
+            sentence_field->setValue(w_sentence);
+            sentence_cat_field->setValue(w_sentence_cat);
+            begin_field->setIntValue(sentence.getBeginPosition());
+            end_field->setIntValue(sentence.getEndPosition());
             sentencewriter->addDocument(sentencedoc);
+            sentencewriter_casesens->addDocument(sentencedoc);
         }
         aait.moveToNext();
     }
@@ -597,14 +708,38 @@ TyErrorId Tpcas2SingleIndex::initialize(AnnotatorContext & rclAnnotatorContext)
         cerr << "Tpcas2Lucene::initialize() TempDirectory - Error. See logfile." << endl;
         return UIMA_ERR_USER_ANNOTATOR_COULD_NOT_INIT;
     }
-    string newindexflag = tempDir + "/newindexflag";
     bool b_newindex = false; //create new index or adding to existing index.
-    if (boost::filesystem::exists(newindexflag)) {
-        //cout << "creating new indexing...." << endl;
-        b_newindex = true;
+    if (rclAnnotatorContext.isParameterDefined("NewIndex")) {
+        rclAnnotatorContext.extractValue("NewIndex", b_newindex);
     } else {
-        //cout << "adding to index....." << endl;
-        b_newindex = false;
+        // descriptors without the parameter signal a new index through a flag file in the temp directory
+        string newindexflag = tempDir + "/newindexflag";
+        b_newindex = boost::filesystem::exists(newindexflag);
+    }
+    // optional writer tuning parameters, Lucene defaults are used if not defined
+    if (rclAnnotatorContext.isParameterDefined("RAMBufferSizeMB")) {
+        float value;
+        if (rclAnnotatorContext.extractValue("RAMBufferSizeMB", value) == UIMA_ERR_NONE) {
+            ramBufferSizeMB = value;
+        }
+    }
+    if (rclAnnotatorContext.isParameterDefined("MergeFactor")) {
+        rclAnnotatorContext.extractValue("MergeFactor", mergeFactor);
+    }
+    if (rclAnnotatorContext.isParameterDefined("MaxMergeMB")) {
+        float value;
+        if (rclAnnotatorContext.extractValue("MaxMergeMB", value) == UIMA_ERR_NONE) {
+            maxMergeMB = value;
+        }
+    }
+    if (rclAnnotatorContext.isParameterDefined("UseCompoundFile")) {
+        rclAnnotatorContext.extractValue("UseCompoundFile", useCompoundFile);
+    }
+    if (rclAnnotatorContext.isParameterDefined("StoreTermVectors")) {
+        rclAnnotatorContext.extractValue("StoreTermVectors", storeTermVectors);
+    }
+    if (rclAnnotatorContext.isParameterDefined("StoreSentenceBlocks")) {
+        rclAnnotatorContext.extractValue("StoreSentenceBlocks", storeSentenceBlocks);
     }
     // creating token index writer
     if (!rclAnnotatorContext.isParameterDefined("TokenLuceneIndexDirectory") ||
@@ -635,9 +770,13 @@ TyErrorId Tpcas2SingleIndex::initialize(AnnotatorContext & rclAnnotatorContext)
         return UIMA_ERR_USER_ANNOTATOR_COULD_NOT_INIT;
     }
     String SentenceIndexDir = StringUtils::toString(sentenceindexdirectory.c_str());
+    // the gap tokens in the categories of the sentences are not indexed
     sentencewriter = newLucene<IndexWriter > (FSDirectory::open(SentenceIndexDir),
-                                              newLucene<StandardAnalyzer > (LuceneVersion::LUCENE_30), b_newindex, //create new index
+                                              CategoryAnalyzer::wrapSentenceAnalyzer(
+                                                      newLucene<StandardAnalyzer > (LuceneVersion::LUCENE_30),
+                                                      tpc::index::CATEGORY_GAP_TOKEN), b_newindex, //create new index
                                               IndexWriter::MaxFieldLengthUNLIMITED);
+    ConfigureWriter(sentencewriter);
     if (!rclAnnotatorContext.isParameterDefined("SentenceCaseSensitiveLuceneIndexDirectory") ||
             rclAnnotatorContext.extractValue("SentenceCaseSensitiveLuceneIndexDirectory", sentenceindexdirectory_casesens) != UIMA_ERR_NONE) {
         // log the error condition
@@ -648,8 +787,10 @@ TyErrorId Tpcas2SingleIndex::initialize(AnnotatorContext & rclAnnotatorContext)
     }
     String SentenceCaseSensitiveIndexDir = StringUtils::toString(sentenceindexdirectory_casesens.c_str());
     sentencewriter_casesens = newLucene<IndexWriter > (FSDirectory::open(SentenceCaseSensitiveIndexDir),
-            newLucene<CaseSensitiveAnalyzer > (LuceneVersion::LUCENE_30), b_newindex, //create new index
+            CategoryAnalyzer::wrapSentenceAnalyzer(newLucene<CaseSensitiveAnalyzer > (LuceneVersion::LUCENE_30),
+                                                   tpc::index::CATEGORY_GAP_TOKEN), b_newindex, //create new index
             IndexWriter::MaxFieldLengthUNLIMITED);
+    ConfigureWriter(sentencewriter_casesens);
     if (!rclAnnotatorContext.isParameterDefined("FulltextLuceneIndexDirectory") ||
             rclAnnotatorContext.extractValue("FulltextLuceneIndexDirectory", fulltextindexdirectory) != UIMA_ERR_NONE) {
         // log the error condition 
@@ -659,9 +800,14 @@ TyErrorId Tpcas2SingleIndex::initialize(AnnotatorContext & rclAnnotatorContext)
         return UIMA_ERR_USER_ANNOTATOR_COULD_NOT_INIT;
     }
     String FulltextIndexDir = StringUtils::toString(fulltextindexdirectory.c_str());
+    // the category dictionary is shared by all the subindexes and stored at the root of the index, above the
+    // subindex directory of the fulltext index
+    categoryDictionary.load((boost::filesystem::path(fulltextindexdirectory).parent_path().parent_path() /
+                             tpc::index::CATEGORY_DICTIONARY_FILENAME).string());
     fulltextwriter = newLucene<IndexWriter > (FSDirectory::open(FulltextIndexDir),
             newLucene<StandardAnalyzer > (LuceneVersion::LUCENE_30), b_newindex, //create new index
             IndexWriter::MaxFieldLengthUNLIMITED);
+    ConfigureWriter(fulltextwriter);
     if (!rclAnnotatorContext.isParameterDefined("FulltextCaseSensitiveLuceneIndexDirectory") ||
         rclAnnotatorContext.extractValue("FulltextCaseSensitiveLuceneIndexDirectory", fulltextindexdirectory_casesens) != UIMA_ERR_NONE) {
         // log the error condition
@@ -674,9 +820,20 @@ TyErrorId Tpcas2SingleIndex::initialize(AnnotatorContext & rclAnnotatorContext)
     fulltextwriter_casesens = newLucene<IndexWriter > (FSDirectory::open(FulltextCaseSensitiveIndexDir),
                                               newLucene<CaseSensitiveAnalyzer > (LuceneVersion::LUCENE_30), b_newindex, //create new index
                                               IndexWriter::MaxFieldLengthUNLIMITED);
+    ConfigureWriter(fulltextwriter_casesens);
     return (TyErrorId) UIMA_ERR_NONE;
 }
 
+void Tpcas2SingleIndex::ConfigureWriter(const IndexWriterPtr& writer) {
+    writer->setRAMBufferSizeMB(ramBufferSizeMB);
+    LogByteSizeMergePolicyPtr mergePolicy = newLucene<LogByteSizeMergePolicy>(writer);
+    mergePolicy->setMergeFactor(mergeFactor);
+    mergePolicy->setMaxMergeMB(maxMergeMB);
+    mergePolicy->setUseCompoundFile(useCompoundFile);
+    mergePolicy->setUseCompoundDocStore(useCompoundFile);
+    writer->setMergePolicy(mergePolicy);
+}
+
 TyErrorId Tpcas2SingleIndex::typeSystemInit(TypeSystem const & crTypeSystem) {
     // input type and feature
     std::vector<Type> alltypes;
@@ -704,32 +861,18 @@ TyErrorId Tpcas2SingleIndex::typeSystemInit(TypeSystem const & crTypeSystem) {
             features_[*atit].push_back(*fit);
         }
     }
+    // handles of the types and features read while processing documents
+    typeHandles.init(crTypeSystem);
     return (TyErrorId) UIMA_ERR_NONE;
 }
 
-wstring getCatString(CAS& tcas, map<wstring, vector<wstring>> cat_map, wstring w_cleanText) {
-    wstring w_cat_string_temp = w_cleanText;
-    vector<wstring> words;
-    boost::split(words, w_cleanText, boost::is_any_of(" \n\t'\\/()[]{}:.;,!?"));
-    wstring w_cat_string;
-    for (wstring word : words) {
-        if (cat_map.find(word) != cat_map.end()) {
-            w_cat_string += boost::algorithm::join(cat_map[word], "|") + L"\t";
-        } else {
-            w_cat_string += L"NA\t";
-        }
-    }
-    w_cat_string = w_cat_string.substr(0, w_cat_string.length() - 1);
-    return w_cat_string;
-}
-
 TyErrorId Tpcas2SingleIndex::process(CAS & tcas, ResultSpecification const & crResultSpecification) {
     FSIndexRepository & indices = tcas.getIndexRepository();
     ANIndex allannindex = tcas.getAnnotationIndex();
     ANIterator aait = allannindex.iterator();
     UnicodeStringRef usdocref = tcas.getDocumentText();
     string pid = tpfnv(usdocref);
-    wstring w_cleanText = getCleanText(tcas);
+    wstring w_cleanText = getCleanText(tcas, typeHandles);
 
     int global_doc_counter(0);
     // read global doc counter from file
@@ -766,13 +909,16 @@ TyErrorId Tpcas2SingleIndex::process(CAS & tcas, ResultSpecification const & crR
     } while (victim > 0);
 
     // collecting and indexing categories
-    auto cat_map = collectCategoryMapping(tcas);
-    wstring w_cat_string = getCatString(tcas, cat_map, w_cleanText);
+    CategoryMapping cat_map = collectCategoryMapping(tcas, typeHandles, categoryDictionary, extraCategories);
+    CategoryStrings cat_strings = getCategoryStrings(cat_map, categoryDictionary, extraCategories);
+    wstring w_cat_string;
+    wstring word;
+    GetCatString(w_cleanText, cat_strings, word, w_cat_string);
 
     w_cat_string = w_cat_string.substr(0, w_cat_string.length() - 1); ///remove last \t to avoid empty string after split
     vector<String> bib_info;
     //string regex_wb = "WBPaper";
-    string filename = getFilename(tcas);
+    string filename = getFilename(tcas, typeHandles);
     // if filename contains C. elegans or C. elegans supplemental, then set corpus according to filename, otherwise
     // get subject and title from xml fulltext and classify according to regex
     string corpora("BG");
@@ -793,7 +939,7 @@ TyErrorId Tpcas2SingleIndex::process(CAS & tcas, ResultSpecification const & crR
         corpora.append(boost::join(papers_lit_map[fn], "ED BG"));
         corpora.append("ED");
     } else {
-        if (getCASType(tcas) == "pdf") {
+        if (getCASType(tcas, typeHandles) == "pdf") {
             if (std::regex_match(filename, std::regex("^C\. elegans Supplementals\/(.*)"))) {
                 corpora.append("C. elegans SupplementalsED");
             } else {
@@ -803,7 +949,7 @@ TyErrorId Tpcas2SingleIndex::process(CAS & tcas, ResultSpecification const & crR
             string xml_text;
             usdocref.extractUTF8(xml_text);
             BibInfo bibInfo = CASManager::get_bib_info_from_xml_text(xml_text);
-            vector<string> corpora_vec = CASManager::classify_article_into_corpora_from_bib_file(bibInfo);
+            vector<string> corpora_vec = corpusClassifier.classify(bibInfo);
             if (corpora_vec.empty()) {
                 corpora_vec.push_back(PMCOA_UNCLASSIFIED);
             }
@@ -855,7 +1001,9 @@ TyErrorId Tpcas2SingleIndex::process(CAS & tcas, ResultSpecification const & crR
     fulltextdoc->add(newLucene<Field > (L"doc_id", StringUtils::toString(base64_id.c_str()),
                                         Field::STORE_YES, Field::INDEX_NOT_ANALYZED_NO_NORMS));
     fulltextdoc->add(newLucene<Field > (L"filepath", l_filepath, Field::STORE_YES, Field::INDEX_NOT_ANALYZED));
-    fulltextdoc->add(newLucene<Field > (L"fulltext", StringUtils::toString<wstring>(w_cleanText), Field::STORE_NO, Field::INDEX_ANALYZED));
+    Field::TermVector term_vector = storeTermVectors ? Field::TERMVECTOR_WITH_POSITIONS_OFFSETS : Field::TERMVECTOR_NO;
+    fulltextdoc->add(newLucene<Field > (L"fulltext", StringUtils::toString<wstring>(w_cleanText), Field::STORE_NO,
+                                        Field::INDEX_ANALYZED, term_vector));
     fulltextdoc->add(newLucene<Field > (L"fulltext_compressed",
                                         CompressionTools::compressString(StringUtils::toString<wstring>(w_cleanText)),
                                         Field::STORE_YES));
@@ -886,15 +1034,23 @@ TyErrorId Tpcas2SingleIndex::process(CAS & tcas, ResultSpecification const & crR
                                         CompressionTools::compressString(StringUtils::toString<wstring>(l_journal)),
                                         Field::STORE_YES));
     fulltextdoc->add(newLucene<Field > (L"citation", l_citation, Field::STORE_YES, Field::INDEX_ANALYZED));
-    fulltextdoc->add(newLucene<Field > (L"year", l_year, Field::STORE_YES, Field::INDEX_ANALYZED));
+    addYearFields(fulltextdoc, l_year);
     fulltextdoc->add(newLucene<Field > (L"abstract_compressed", CompressionTools::compressString(l_abstract),
                                         Field::STORE_YES));
     fulltextdoc->add(newLucene<Field > (L"corpus", String(corpora.begin(), corpora.end()), Field::STORE_YES,
                                         Field::INDEX_ANALYZED));
+    // sentences are indexed first, so that in sentence block mode their block can be added to the fulltext document
+    tpc::index::SentenceBlock sentence_block;
+    IndexSentences(tcas, typeHandles, cat_map, cat_strings, extraCategories, bib_info, corpora, base64_id,
+                   sentencewriter, sentencewriter_casesens, term_vector,
+                   storeSentenceBlocks ? &sentence_block : NULL);
+    if (storeSentenceBlocks) {
+        string encoded_block = sentence_block.encode();
+        fulltextdoc->add(newLucene<Field>(L"sentences_block", CompressionTools::compress(
+                reinterpret_cast<uint8_t*>(&encoded_block[0]), 0, encoded_block.size()), Field::STORE_YES));
+    }
     fulltextwriter->addDocument(fulltextdoc);
     fulltextwriter_casesens->addDocument(fulltextdoc);
-    IndexSentences(tcas, cat_map, bib_info, corpora, base64_id, sentencewriter);
-    IndexSentences(tcas, cat_map, bib_info, corpora, base64_id, sentencewriter_casesens);
     return (TyErrorId) UIMA_ERR_NONE;
 }
 
@@ -913,11 +1069,9 @@ TyErrorId Tpcas2SingleIndex::destroy() {
 }
 
 wstring Tpcas2SingleIndex::RemoveTags(wstring w_cleantext) {
-    boost::wregex tagregex(L"\<.+?\>");
-    w_cleantext = boost::regex_replace(w_cleantext, tagregex, "");
-    boost::wregex tagregex2(L"\<\/.+?\>");
-    w_cleantext = boost::regex_replace(w_cleantext, tagregex2, "");
-    return w_cleantext;
+    wstring result;
+    ::RemoveTags(w_cleantext, result);
+    return result;
 }
 
 MAKE_AE(Tpcas2SingleIndex);
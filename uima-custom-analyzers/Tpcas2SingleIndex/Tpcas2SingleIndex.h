@@ -13,6 +13,9 @@
 #include <lucene++/LuceneHeaders.h>
 #include "../../lucene-custom/CaseSensitiveAnalyzer.h"
 #include "../../CASManager.h"
+#include "../../CorpusClassifier.h"
+#include "../../CategoryDictionary.h"
+#include "../TpTypeHandles.h"
 
 using namespace uima;
 using namespace std;
@@ -40,12 +43,14 @@ public:
     TyErrorId process(CAS & tcas, ResultSpecification const & crResultSpecification);
     vector<String> GetBib(string fullfilename);
     static wstring RemoveTags(wstring w_cleantext);
+    void ConfigureWriter(const IndexWriterPtr& writer);
     
 
 private:
     // input types and features
     vector<Type> types_;
     map< Type, vector<Feature> > features_;
+    TpTypeHandles typeHandles;
     CAS *tcas;
    
     string fulltextindexdirectory; // full clean text index
@@ -64,7 +69,25 @@ private:
     IndexWriterPtr fulltextwriter_casesens; //index writers
     IndexWriterPtr sentencewriter_casesens;
 
+    // index writers tuning
+    double ramBufferSizeMB;
+    int mergeFactor;
+    double maxMergeMB;
+    bool useCompoundFile;
+    // term vectors with offsets on fulltext and sentences, required for highlighting
+    bool storeTermVectors;
+    // text and categories of the sentences stored in one compressed block per paper
+    bool storeSentenceBlocks;
+
     std::string root_dir;
+
+    // categories of the lexical annotations, from the category dictionary of the index, which is only read
+    tpc::index::CategoryDictionary categoryDictionary;
+    // categories of the documents that are not in the dictionary of the index, kept in memory only
+    tpc::index::CategoryDictionary extraCategories;
+
+    // classifier of xml articles into corpora, compiled once for all the documents
+    tpc::cas::CorpusClassifier corpusClassifier;
 };
 
 #endif	/* TPCAS2LPP_H */